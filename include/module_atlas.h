@@ -0,0 +1,77 @@
+#ifndef MODULE_ATLAS_H
+#define MODULE_ATLAS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "module_font.h"
+
+#define ATLAS_SIZE 1024              // Texel edge of the square atlas image
+#define ATLAS_PADDING 1              // Cleared border around every glyph so linear filtering never bleeds
+#define ATLAS_SHELF_ROUNDING 8       // Shelf heights are multiples of this, so similar glyphs share shelves
+#define ATLAS_MAX_ENTRIES 4096       // Glyphs cached at once, empty ones (spaces) included
+#define ATLAS_HASH_BUCKETS 8192      // Power of two
+#define ATLAS_ENTRY_INVALID UINT32_MAX
+
+// Cache key of one glyph of one font; SDF glyphs serve every size, so size is not part of it
+#define ATLAS_KEY(fontId, codepoint) (((uint64_t)(fontId) << 32) | (uint32_t)(codepoint))
+
+typedef struct {
+    uint32_t x, width;
+} AtlasSpan;
+
+// A horizontal band of the atlas; freed cells return to its span list and merge with their neighbours
+typedef struct {
+    uint32_t y, height;
+    AtlasSpan *free;             // Free columns sorted by x
+    uint32_t freeCount;
+    uint32_t freeCapacity;
+    uint32_t glyphCount;
+} AtlasShelf;
+
+typedef struct {
+    uint64_t key;
+    FontGlyph glyph;             // Metrics from the rasterizer, normalized rectangle from the packer
+    uint32_t x, y;               // Texel rectangle of the distance field, padding excluded
+    uint32_t width, height;      // Zero for empty glyphs, which take no space
+    uint32_t shelf;
+    uint64_t lastUsed;           // Frame the glyph was last looked up in
+    uint32_t lruPrev, lruNext;   // Least recently used first
+    uint32_t hashNext;           // Bucket chain, or the free list while unused
+} AtlasEntry;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} AtlasStats;
+
+// Glyph cache over one single-channel image, filled on demand. Cells are packed on shelves;
+// when nothing fits, the least recently used glyphs that the current frame has not drawn are evicted.
+typedef struct {
+    AtlasShelf *shelves;         // Bottom to top
+    uint32_t shelfCount;
+    uint32_t shelfCapacity;
+    uint32_t shelfTop;           // First row above the last shelf
+    AtlasEntry entries[ATLAS_MAX_ENTRIES];
+    uint32_t buckets[ATLAS_HASH_BUCKETS];
+    uint32_t freeEntry;          // Head of the unused entry list
+    uint32_t lruHead, lruTail;
+    uint32_t count;              // Glyphs cached
+    uint64_t usedTexels;         // Area of the allocated cells, padding included
+    uint64_t frame;
+    AtlasStats stats;            // Cumulative since init
+} GlyphAtlas;
+
+void atlas_init(GlyphAtlas *atlas);
+void atlas_destroy(GlyphAtlas *atlas);
+// Starts a frame; glyphs looked up from here on are protected from eviction until the next call
+void atlas_begin_frame(GlyphAtlas *atlas);
+// Cached glyph marked as used this frame, or NULL on a miss
+const AtlasEntry *atlas_lookup(GlyphAtlas *atlas, uint64_t key);
+// Caches a glyph whose distance field is width x height texels, evicting as needed. Fills the
+// normalized rectangle of glyph; NULL when the glyphs of this frame leave no room.
+const AtlasEntry *atlas_insert(GlyphAtlas *atlas, uint64_t key, const FontGlyph *glyph, uint32_t width, uint32_t height);
+// Fraction of the atlas area held by cached glyphs
+float atlas_occupancy(const GlyphAtlas *atlas);
+
+#endif // MODULE_ATLAS_H
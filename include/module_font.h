@@ -0,0 +1,96 @@
+#ifndef MODULE_FONT_H
+#define MODULE_FONT_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#define FONT_SDF_SIZE 40        // Pixel size the distance fields are rasterized at
+#define FONT_SDF_SPREAD 6       // Distance range in pixels on each side of an outline
+#define FONT_MAX_FONTS 16       // Faces one manager can hold
+#define FONT_ID_INVALID UINT32_MAX
+
+typedef uint32_t FontId;
+
+// Metrics are in FONT_SDF_SIZE pixels relative to the pen on the baseline, y pointing down
+typedef struct {
+    float u0, v0, u1, v1;       // Atlas rectangle, normalized; filled in by the glyph atlas
+    float x0, y0, x1, y1;       // Quad, spread included
+    float advance;
+    bool empty;                 // Nothing to draw (space), advance only
+} FontGlyph;
+
+// Distance field of the last rendered glyph, owned by the face's glyph slot
+typedef struct {
+    const uint8_t *pixels;
+    uint32_t width, height;
+    int32_t pitch;              // Bytes between rows, negative for bottom-up bitmaps
+} FontBitmap;
+
+typedef enum {
+    FONT_STATE_PENDING,         // Queued for the preload thread
+    FONT_STATE_READY,
+    FONT_STATE_FAILED
+} FontState;
+
+typedef struct {
+    uint32_t codepoint;
+    FontGlyph glyph;
+    bool used;
+} FontMetricsSlot;
+
+// One face, rasterized into signed distance fields glyph by glyph as text needs them. Distance
+// fields scale, so the face is set up once at FONT_SDF_SIZE and serves every label size.
+// Texels are 128 on the outline, higher inside.
+typedef struct {
+    FontId id;
+    char *path;
+    void *data;                 // The font file, memory-mapped for the face's lifetime
+    size_t size;
+    FT_Library library;         // One per face, so the preload thread can parse faces without locking
+    FT_Face face;
+    float ascent;               // Above the baseline, FONT_SDF_SIZE pixels
+    float lineHeight;
+    FontMetricsSlot *metrics;   // Codepoint to metrics, open addressing; capacity is a power of two
+    uint32_t metricsCapacity;
+    uint32_t metricsCount;
+    FontState state;            // Guarded by the manager mutex while a preload runs
+    bool available;             // Main thread only: READY has been observed, no more locking needed
+} Font;
+
+// Loads every face once and hands out ids; labels and the glyph atlas refer to fonts by id.
+// font_manager_preload parses a list on a background thread so startup does not wait for it.
+typedef struct {
+    Font fonts[FONT_MAX_FONTS];
+    uint32_t count;
+    SDL_Mutex *mutex;
+    SDL_Condition *loaded;      // Signalled each time the preload thread finishes a font
+    SDL_Thread *loader;
+    uint32_t preloadFirst;      // Fonts [preloadFirst, preloadEnd) belong to the running preload
+    uint32_t preloadEnd;
+} FontManager;
+
+bool font_manager_init(FontManager *manager);
+// Waits for a running preload, then releases every face and mapping
+void font_manager_destroy(FontManager *manager);
+// Loads a font on the calling thread, or returns the id it already has (waiting for it when a
+// preload still has it pending); FONT_ID_INVALID on failure
+FontId font_manager_load(FontManager *manager, const char *path);
+// Registers the fonts and returns their ids in ids right away; the faces load on a background thread
+bool font_manager_preload(FontManager *manager, const char *const *paths, uint32_t count, FontId *ids);
+// The font once it is ready, NULL while it is pending or when it failed to load
+Font *font_manager_get(FontManager *manager, FontId id);
+FontState font_manager_state(FontManager *manager, FontId id);
+
+// Metrics of a glyph, taken from its outline without rasterizing and cached per codepoint;
+// font_render_glyph replaces them with the exact ones
+bool font_glyph_metrics(Font *font, uint32_t codepoint, FontGlyph *glyph);
+// Fills the metrics of glyph and, unless it is empty, the distance field in bitmap, valid until the
+// next call. Codepoints missing from the face render the face's missing glyph.
+bool font_render_glyph(Font *font, uint32_t codepoint, FontGlyph *glyph, FontBitmap *bitmap);
+float font_kerning(const Font *font, uint32_t left, uint32_t right);
+
+#endif // MODULE_FONT_H
@@ -0,0 +1,139 @@
+#ifndef MODULE_GRAPH_H
+#define MODULE_GRAPH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GRAPH_MAX_PORTS 16            // Input ports one node can have
+#define GRAPH_NODE_INVALID UINT32_MAX
+#define GRAPH_RANK_NONE UINT32_MAX    // Rank of a node left out of the order, see GRAPH_FLAG_CYCLE
+#define GRAPH_SWEEP_FRACTION 16       // A tick sweeps the order instead of using the heap once 1/16 of it is scheduled
+
+#define GRAPH_FLAG_PENDING   0x01     // Waiting in the pending list for the next tick
+#define GRAPH_FLAG_SCHEDULED 0x02     // In the evaluation heap of the current tick
+#define GRAPH_FLAG_CYCLE     0x04     // On or downstream of a cycle; never evaluated
+
+typedef uint32_t GraphNodeHandle;
+
+typedef enum {
+    GRAPH_NODE_VARIABLE,              // Holds the value given to graph_set_variable
+    GRAPH_NODE_FUNCTION,              // Applies its op to its connected inputs
+    GRAPH_NODE_TICK,                  // Takes the tick number every tick
+    GRAPH_NODE_FREE,                  // Slot on the free list
+} GraphNodeKind;
+
+// Unconnected ports are skipped; a function with no connected input gives 0, or 1 for MUL
+typedef enum {
+    GRAPH_OP_ADD,
+    GRAPH_OP_MUL,
+    GRAPH_OP_MIN,
+    GRAPH_OP_MAX,
+    GRAPH_OP_COUNT,
+} GraphOp;
+
+typedef struct {
+    uint32_t evaluated;               // Nodes evaluated by the last tick
+    uint32_t changed;                 // Of those, nodes whose value changed and woke their outputs
+    uint64_t totalEvaluated;
+    uint64_t ticks;
+    uint32_t rebuilds;                // Topology rebuilds: CSR outputs and order
+    double rebuildMs;                 // Duration of the last rebuild
+} GraphStats;
+
+typedef struct Graph Graph;
+
+// Takes over a tick's evaluation once it is too wide for the heap: it must evaluate, from rank
+// begin on, every node flagged GRAPH_FLAG_SCHEDULED and every node a changed value reaches, each
+// after its inputs, add to the counts and leave no flag set. Returning false, having evaluated
+// nothing, leaves the walk to the graph. A parallel scheduler plugs in here (module_scheduler).
+typedef struct {
+    bool (*sweep)(void *userData, Graph *graph, uint32_t begin, uint32_t *evaluated, uint32_t *changed);
+    void *userData;
+} GraphExecutor;
+
+// Told about edits as they happen, so data compiled from the graph (module_tape) can follow
+// without a full rebuild
+typedef struct {
+    void (*added)(void *userData, GraphNodeHandle node);
+    void (*removed)(void *userData, GraphNodeHandle node);   // After its ports were cleared, before the handle is released
+    void (*rewired)(void *userData, GraphNodeHandle node);   // One of the node's input ports changed source
+    void *userData;
+} GraphListener;
+
+// Dataflow graph of single-output nodes. Each node owns a contiguous range of input ports in
+// inputSources, which holds the source node per port; outputs are kept in CSR form (offsets
+// plus targets) and, with the topological order, rebuilt by the first tick after an edit.
+// Outputs connected since that rebuild are chained per source, so a removal finds every output
+// of a node without rebuilding and any number of edits cost one rebuild.
+// A tick evaluates only what changed and what depends on it, in rank order from a min-heap (or a
+// walk of the order once much of the graph is scheduled), and stops propagating at nodes whose
+// value came out the same.
+struct Graph {
+    uint8_t *kinds;                   // GraphNodeKind, indexed by handle
+    uint8_t *ops;                     // GraphOp of function nodes
+    uint8_t *flags;                   // GRAPH_FLAG_*
+    float *values;
+    uint32_t *portBase;               // First port in inputSources
+    uint32_t *portCounts;
+    uint32_t *ranks;                  // Position in order; next free handle while the slot is free
+    uint32_t nodeCapacity;
+    uint32_t nodeCount;               // Handles ever issued
+    uint32_t liveCount;
+    uint32_t freeNode;                // First recycled handle, GRAPH_NODE_INVALID if none
+    uint32_t *inputSources;           // Source node per port, GRAPH_NODE_INVALID when unconnected
+    uint32_t portCount;               // Ports in use, holes of removed nodes included
+    uint32_t portCapacity;
+    uint32_t portHoles;               // Ports of removed nodes, compacted away by a rebuild
+    uint32_t edgeCount;               // Connected ports
+    uint32_t *outputOffsets;          // Node -> first entry in outputTargets, nodeCount + 1 entries
+    uint32_t *outputTargets;          // One entry per connected port, duplicates included
+    uint32_t targetCapacity;
+    uint32_t outputNodes;             // nodeCount at the last rebuild; later handles have no CSR range
+    uint32_t *outputLogHead;          // Node -> first output connected since the last rebuild, or GRAPH_NODE_INVALID
+    uint32_t *outputLogTargets;       // Chained through outputLogNext; may be stale, ports are checked
+    uint32_t *outputLogNext;
+    uint32_t outputLogCount;
+    uint32_t outputLogCapacity;
+    uint32_t *order;                  // Live nodes in topological order, cycle nodes excluded
+    uint32_t orderCount;
+    uint32_t *tickNodes;              // Tick nodes in rank order
+    uint32_t tickCount;
+    uint32_t *pending;                // Nodes to evaluate next tick, ranks not yet valid
+    uint32_t pendingCount;
+    uint32_t *heap;                   // Min-heap on rank, at most one entry per node
+    uint32_t heapCount;
+    uint32_t *scratch;                // Fill cursors, then in-degrees, during a rebuild
+    bool topologyChanged;
+    GraphExecutor executor;           // Wide ticks walk the order on the calling thread when unset
+    GraphListener listener;           // Callbacks may be NULL
+    GraphStats stats;
+};
+
+void graph_init(Graph *graph);
+void graph_destroy(Graph *graph);
+// ports is ignored for variable and tick nodes, which have no inputs
+GraphNodeHandle graph_add_node(Graph *graph, GraphNodeKind kind, GraphOp op, uint32_t ports);
+// Disconnects the node from everything; the nodes it fed are evaluated next tick
+bool graph_remove_node(Graph *graph, GraphNodeHandle node);
+// Feeds from's value into port of to, replacing what was connected there
+bool graph_connect(Graph *graph, GraphNodeHandle from, GraphNodeHandle to, uint32_t port);
+bool graph_disconnect(Graph *graph, GraphNodeHandle to, uint32_t port);
+bool graph_set_variable(Graph *graph, GraphNodeHandle node, float value);
+bool graph_get_value(const Graph *graph, GraphNodeHandle node, float *value);
+// Replaces the graph's listener; pass NULL to clear it
+void graph_set_listener(Graph *graph, const GraphListener *listener);
+// Rebuilds the output CSR and the order if an edit changed them; graph_tick does this itself
+bool graph_update_topology(Graph *graph);
+// Replaces the graph's executor; pass NULL to clear it
+void graph_set_executor(Graph *graph, const GraphExecutor *executor);
+// Recomputes a function node from its inputs; variables and ticks keep the value they were given.
+// Returns true when the nodes it feeds have to follow. For executors, which may call it from any
+// thread once the node's inputs are final.
+bool graph_evaluate_node(Graph *graph, GraphNodeHandle node);
+// Schedules every node for the next tick, as after loading a graph
+void graph_invalidate(Graph *graph);
+// Advances the tick number, then evaluates the tick nodes, the nodes changed since the last tick
+// and whatever their changes reach. Returns the number of nodes evaluated.
+uint32_t graph_tick(Graph *graph);
+
+#endif // MODULE_GRAPH_H
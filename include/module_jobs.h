@@ -0,0 +1,34 @@
+#ifndef MODULE_JOBS_H
+#define MODULE_JOBS_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define JOB_MAX_THREADS 16 // Worker threads plus the calling thread
+
+// Runs once per job index; any thread may pick up any index
+typedef void (*JobFunction)(void *userData, uint32_t jobIndex);
+
+// Fork-join pool: job_system_run hands out indices to the workers and to the calling thread,
+// and returns once every job has finished
+typedef struct {
+    SDL_Thread **threads;
+    uint32_t threadCount;     // Worker threads, 0 runs every job on the caller
+    SDL_Mutex *mutex;
+    SDL_Condition *workReady; // Signalled when a batch is published or on shutdown
+    SDL_Condition *workDone;  // Signalled when the last job of a batch finishes
+    JobFunction function;
+    void *userData;
+    uint32_t jobCount;
+    uint32_t nextJob;         // Next index to hand out
+    uint32_t jobsRemaining;   // Handed out or pending, not finished yet
+    bool quit;
+} JobSystem;
+
+// threads counts the caller, so 1 creates no worker threads
+bool job_system_init(JobSystem *jobs, uint32_t threads);
+void job_system_destroy(JobSystem *jobs);
+void job_system_run(JobSystem *jobs, JobFunction function, void *userData, uint32_t jobCount);
+
+#endif // MODULE_JOBS_H
@@ -0,0 +1,60 @@
+#ifndef MODULE_LAYOUT_H
+#define MODULE_LAYOUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "module_spatial.h"
+
+#define LAYOUT_CACHE_BYTES (8 * 1024 * 1024) // Default budget: runs, their strings and glyphs
+#define LAYOUT_INITIAL_BUCKETS 1024          // Power of two; doubles when runs outnumber buckets
+
+// One drawable glyph of a shaped string: where its pen sits on the baseline, in FONT_SDF_SIZE
+// pixels from the label's top-left. The quad comes from the glyph's metrics at draw time.
+typedef struct {
+    uint32_t codepoint;
+    float x, y;
+} LayoutGlyph;
+
+// A string shaped in one font: UTF-8 decoded, kerned and broken into lines. Runs are in glyph
+// atlas pixels, so one run serves a string at every size.
+typedef struct LayoutRun {
+    uint64_t hash;
+    uint32_t font;
+    uint32_t length;             // Bytes of string, terminator excluded
+    char *string;                // Copy of the key, so hash collisions cannot alias runs
+    LayoutGlyph *glyphs;         // Empty glyphs (spaces) are advanced over but not stored
+    uint32_t glyphCount;
+    SpatialRect bounds;          // Ink box joined with the line boxes and the pen's travel
+    size_t bytes;                // Heap footprint, counted against the budget
+    struct LayoutRun *lruPrev, *lruNext; // Least recently used first
+    struct LayoutRun *hashNext;
+} LayoutRun;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} LayoutCacheStats;
+
+// Shaped runs keyed by string and font, bounded by memory; the least recently used runs go first
+typedef struct {
+    LayoutRun **buckets;
+    uint32_t bucketCount;
+    LayoutRun *lruHead, *lruTail;
+    uint32_t count;
+    size_t bytes;
+    size_t budget;
+    LayoutCacheStats stats;      // Cumulative since init
+} LayoutCache;
+
+void layout_cache_init(LayoutCache *cache, size_t budget);
+void layout_cache_destroy(LayoutCache *cache);
+uint64_t layout_hash(const char *string, uint32_t font);
+// The cached run, now the most recently used; NULL on a miss
+LayoutRun *layout_cache_find(LayoutCache *cache, uint64_t hash, uint32_t font, const char *string);
+// Copies a shaped run into the cache, then evicts older runs until the budget holds again
+LayoutRun *layout_cache_insert(LayoutCache *cache, uint64_t hash, uint32_t font, const char *string,
+                               const LayoutGlyph *glyphs, uint32_t glyphCount, const SpatialRect *bounds);
+
+#endif // MODULE_LAYOUT_H
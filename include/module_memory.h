@@ -0,0 +1,72 @@
+#ifndef MODULE_MEMORY_H
+#define MODULE_MEMORY_H
+
+#include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MEMORY_BLOCK_SIZE (64ull * 1024 * 1024) // Default VkDeviceMemory block, capped to 1/8 of the heap
+
+typedef struct {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+} MemoryRange;
+
+// One vkAllocateMemory, carved into sub-allocations
+typedef struct MemoryBlock {
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    VkDeviceSize used;
+    void *mapped;             // Persistently mapped when the memory type is host visible
+    MemoryRange *freeRanges;  // Sorted by offset, adjacent ranges always merged
+    uint32_t freeCount;
+    uint32_t freeCapacity;
+    uint32_t allocationCount;
+    bool dedicated;           // Sized for a single large allocation
+} MemoryBlock;
+
+// A sub-allocation; memory and offset are what vkBind*Memory needs
+typedef struct {
+    MemoryBlock *block;       // NULL when empty
+    VkDeviceMemory memory;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    void *mapped;             // Host pointer to offset, NULL unless host visible
+    uint32_t memoryType;
+} MemoryAllocation;
+
+typedef struct {
+    MemoryBlock **blocks;
+    uint32_t count;
+    uint32_t capacity;
+} MemoryPool;
+
+typedef struct {
+    VkDevice device;
+    VkPhysicalDeviceMemoryProperties properties; // Queried once at init
+    VkDeviceSize bufferImageGranularity;
+    uint32_t maxAllocationCount;
+    MemoryPool pools[VK_MAX_MEMORY_TYPES];       // Keyed by memory type index
+    uint32_t deviceAllocationCount;              // Live vkAllocateMemory calls
+    uint32_t allocationCount;                    // Live sub-allocations
+} MemoryAllocator;
+
+typedef struct {
+    uint32_t blockCount;
+    uint32_t allocationCount;
+    VkDeviceSize bytesReserved;     // Sum of block sizes
+    VkDeviceSize bytesUsed;         // Sum of sub-allocation sizes, alignment padding excluded
+    VkDeviceSize largestFreeRange;
+    uint32_t freeRangeCount;
+} MemoryStats;
+
+bool memory_allocator_init(MemoryAllocator *allocator, VkDevice device, VkPhysicalDevice physicalDevice);
+void memory_allocator_destroy(MemoryAllocator *allocator);
+uint32_t memory_find_type(const MemoryAllocator *allocator, uint32_t typeBits, VkMemoryPropertyFlags properties);
+bool memory_allocate(MemoryAllocator *allocator, const VkMemoryRequirements *requirements,
+                     VkMemoryPropertyFlags properties, bool optimalImage, MemoryAllocation *allocation);
+void memory_free(MemoryAllocator *allocator, MemoryAllocation *allocation);
+void memory_get_stats(const MemoryAllocator *allocator, uint32_t memoryType, MemoryStats *stats);
+void memory_log_stats(const MemoryAllocator *allocator);
+
+#endif // MODULE_MEMORY_H
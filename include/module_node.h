@@ -0,0 +1,84 @@
+#ifndef MODULE_NODE_H
+#define MODULE_NODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "module_spatial.h"
+#include "module_transform.h"
+
+typedef enum {
+    NODE_MESH_TRIANGLE,
+    NODE_MESH_SQUARE,
+    NODE_MESH_COUNT
+} NodeMesh;
+
+typedef uint32_t NodeHandle;
+#define NODE_HANDLE_INVALID UINT32_MAX
+
+// Per-instance data read by shader2d.vert, laid out to match std430. The basis and translation
+// come from the node's world transform and are only rebuilt when it changes.
+typedef struct {
+    float basis[4];          // Model x axis (xy) and y axis (zw): rotation times scale
+    float translation[2];    // World position
+    uint32_t color;          // RGBA8, red in the low byte; multiplied with the vertex color
+    uint32_t flags;          // Spare, keeps the stride at 32 bytes
+} NodeInstance;
+
+// Structure of arrays, dense per mesh: index i of every array belongs to the same node
+typedef struct {
+    float (*positions)[2];   // Relative to the parent node, world position for roots
+    float (*scales)[2];      // Mesh scale; applies to this node only, children do not inherit it
+    float *rotations;        // Radians, counter-clockwise, relative to the parent
+    uint32_t *colors;        // RGBA8, red in the low byte
+    NodeInstance *instances; // Drawn as one instanced range; valid after the transform update
+    NodeHandle *handles;     // Dense index -> handle
+    uint32_t count;
+    uint32_t capacity;
+} NodeMeshBatch;
+
+// Told about world position changes and removals, so data derived from node positions (wire
+// endpoints) is rewritten for the nodes that changed only
+typedef struct {
+    void (*moved)(void *userData, NodeHandle handle, float x, float y); // From node_store_update_transforms
+    void (*removed)(void *userData, NodeHandle handle);                 // Before the handle is released
+    void *userData;
+} NodeListener;
+
+typedef struct {
+    NodeMeshBatch batches[NODE_MESH_COUNT];
+    uint32_t *slotMesh;      // Handle -> mesh
+    uint32_t *slotIndex;     // Handle -> dense index, or next free handle
+    TransformHandle *slotTransform; // Handle -> entry in transforms
+    uint32_t slotCapacity;
+    uint32_t slotCount;      // Handles ever issued
+    uint32_t freeHead;       // First recycled handle, NODE_HANDLE_INVALID if none
+    uint32_t count;          // Live nodes across all meshes
+    SpatialIndex spatial;    // World bounds of every live node, keyed by handle
+    TransformHierarchy transforms; // Parent/child links; entry owners are node handles
+    NodeListener listener;   // Callbacks may be NULL
+} NodeStore;
+
+void node_store_init(NodeStore *store);
+void node_store_destroy(NodeStore *store);
+// Replaces the store's listener; pass NULL to clear it
+void node_store_set_listener(NodeStore *store, const NodeListener *listener);
+NodeHandle node_add(NodeStore *store, NodeMesh mesh, float x, float y, float scale, const float color[4]);
+bool node_remove(NodeStore *store, NodeHandle handle);
+bool node_get_position(const NodeStore *store, NodeHandle handle, float position[2]);
+bool node_get_world_position(const NodeStore *store, NodeHandle handle, float position[2]);
+bool node_get_rotation(const NodeStore *store, NodeHandle handle, float *radians);
+// Transform setters take effect, for the node and its descendants, at the next transform update
+bool node_set_position(NodeStore *store, NodeHandle handle, float x, float y);
+bool node_set_scale(NodeStore *store, NodeHandle handle, float scaleX, float scaleY);
+bool node_set_rotation(NodeStore *store, NodeHandle handle, float radians);
+bool node_set_color(NodeStore *store, NodeHandle handle, const float color[4]);
+// The child's position and rotation become relative to parent; NODE_HANDLE_INVALID detaches it
+bool node_set_parent(NodeStore *store, NodeHandle child, NodeHandle parent);
+// Recompute world transforms of moved subtrees, their instances and spatial bounds; call once per
+// frame before drawing, picking sees the last update. Returns the number of nodes recomputed.
+uint32_t node_store_update_transforms(NodeStore *store);
+NodeHandle node_pick(const NodeStore *store, float x, float y);
+void node_query_rect(const NodeStore *store, const SpatialRect *rect, SpatialVisitor visit, void *userData);
+NodeHandle node_nearest(const NodeStore *store, float x, float y, float maxDistance);
+
+#endif // MODULE_NODE_H
@@ -0,0 +1,81 @@
+#ifndef MODULE_PROFILER_H
+#define MODULE_PROFILER_H
+
+#include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PROFILER_RING_SIZE 65536      // Events kept for trace export, oldest overwritten first
+#define PROFILER_MAX_DEPTH 32         // Nested scopes per track
+#define PROFILER_MAX_GPU_SCOPES 32    // GPU scopes per frame, two timestamp queries each
+
+typedef enum {
+    PROFILE_TRACK_CPU,
+    PROFILE_TRACK_GPU
+} ProfileTrack;
+
+typedef struct {
+    const char *name;        // Not copied; scopes are named with string literals
+    uint64_t startNs;        // Relative to Profiler.originNs
+    uint64_t durationNs;
+    uint64_t frame;
+    uint8_t track;
+    uint8_t depth;
+} ProfileEvent;
+
+// Timestamp queries of one frame in flight, read back once its fence has signalled
+typedef struct {
+    VkQueryPool queryPool;
+    const char *names[PROFILER_MAX_GPU_SCOPES];
+    uint8_t depths[PROFILER_MAX_GPU_SCOPES];
+    uint32_t scopeCount;     // Scope i owns queries 2i (begin) and 2i+1 (end)
+    uint32_t openScopes[PROFILER_MAX_DEPTH];
+    uint32_t openCount;
+    uint64_t frame;
+    uint64_t submitNs;       // CPU time of the submit, anchors the frame's GPU scopes on the trace
+    bool pending;            // Queries written and not read back yet
+} ProfilerGpuFrame;
+
+typedef struct {
+    bool enabled;
+    VkDevice device;
+    bool gpuSupported;              // The graphics queue writes timestamps
+    double timestampPeriod;         // Nanoseconds per timestamp tick
+    uint64_t timestampMask;         // timestampValidBits of the graphics queue
+    ProfilerGpuFrame *gpuFrames;    // Per frame in flight
+    uint32_t gpuFrameCount;
+    ProfilerGpuFrame *currentGpuFrame; // Frame being recorded, NULL outside frame begin/end
+    struct {
+        const char *name;
+        uint64_t startNs;
+    } cpuStack[PROFILER_MAX_DEPTH];
+    uint32_t cpuDepth;
+    ProfileEvent *events;           // Ring of PROFILER_RING_SIZE
+    uint64_t eventCount;            // Events ever recorded
+    uint64_t frame;
+    uint64_t originNs;              // Trace time zero
+} Profiler;
+
+// The macros are the instrumentation entry points: a disabled profiler costs one branch
+#define PROFILE_CPU_BEGIN(profiler, name) do { if ((profiler)->enabled) profiler_cpu_begin((profiler), (name)); } while (0)
+#define PROFILE_CPU_END(profiler) do { if ((profiler)->enabled) profiler_cpu_end(profiler); } while (0)
+#define PROFILE_GPU_BEGIN(profiler, commandBuffer, name) do { if ((profiler)->currentGpuFrame) profiler_gpu_begin((profiler), (commandBuffer), (name)); } while (0)
+#define PROFILE_GPU_END(profiler, commandBuffer) do { if ((profiler)->currentGpuFrame) profiler_gpu_end((profiler), (commandBuffer)); } while (0)
+
+bool profiler_init(Profiler *profiler, VkDevice device, VkPhysicalDevice physicalDevice,
+                   uint32_t queueFamily, uint32_t framesInFlight);
+void profiler_destroy(Profiler *profiler);
+void profiler_set_enabled(Profiler *profiler, bool enabled);
+void profiler_cpu_begin(Profiler *profiler, const char *name);
+void profiler_cpu_end(Profiler *profiler);
+// Call after the frame's fence wait and outside a render pass; collects the slot's previous results
+void profiler_gpu_frame_begin(Profiler *profiler, VkCommandBuffer commandBuffer, uint32_t frameSlot);
+// Call before the frame's command buffer is ended; closes any scope left open
+void profiler_gpu_frame_end(Profiler *profiler, VkCommandBuffer commandBuffer);
+void profiler_gpu_begin(Profiler *profiler, VkCommandBuffer commandBuffer, const char *name);
+void profiler_gpu_end(Profiler *profiler, VkCommandBuffer commandBuffer);
+// Read back every frame still pending; the device must be idle
+void profiler_collect(Profiler *profiler);
+bool profiler_write_trace(const Profiler *profiler, const char *path);
+
+#endif // MODULE_PROFILER_H
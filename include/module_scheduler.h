@@ -0,0 +1,79 @@
+#ifndef MODULE_SCHEDULER_H
+#define MODULE_SCHEDULER_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "module_graph.h"
+
+#define SCHEDULER_MAX_THREADS 64     // Worker threads plus the calling thread
+#define SCHEDULER_INITIAL_RING 1024  // Entries of a worker's first deque ring; doubles when full
+#define SCHEDULER_FLUSH_RELEASES 64  // Releases a worker counts locally before publishing them
+
+// Deque storage; a full ring is replaced by one twice the size and kept until the pass ends,
+// since thieves may still be reading it
+typedef struct SchedulerRing {
+    struct SchedulerRing *retired;   // Ring this one replaced
+    uint32_t mask;
+    SDL_AtomicInt items[];
+} SchedulerRing;
+
+// Chase-Lev deque: the owner pushes and pops at the bottom, thieves take from the top. Indices
+// restart at 0 every pass.
+typedef struct {
+    struct Scheduler *scheduler;     // For the worker thread
+    SDL_AtomicInt top;
+    SDL_AtomicInt bottom;
+    void *ring;                      // SchedulerRing, read with SDL_GetAtomicPointer
+    uint32_t evaluated;              // Counted by the owner during a pass
+    uint32_t changed;
+    uint32_t steals;
+    uint32_t released;               // Releases not yet subtracted from remaining
+    uint32_t random;                 // Victim choice
+    uint32_t spilled;                // Top of the stack of released nodes the deque had no room for
+    uint8_t pad[64];                 // Keeps the next worker's indices off this cache line
+} SchedulerWorker;
+
+typedef struct {
+    uint64_t passes;
+    uint64_t steals;                 // Nodes taken from another worker's deque, all passes
+    uint32_t lastThreads;            // Threads that ran the last pass
+    double lastPassMs;
+} SchedulerStats;
+
+// Work-stealing pool that runs a graph's wide ticks. Each pass gives every node in the swept range
+// a counter of its inputs in that range; a node runs when its counter reaches zero, evaluating
+// itself only if it was scheduled or a changed input woke it, and then releases its outputs. The
+// first output released goes on running on the same thread, the rest go on its deque.
+typedef struct Scheduler {
+    SDL_Thread **threads;
+    uint32_t threadCount;            // Worker threads plus the caller
+    SchedulerWorker *workers;        // Index 0 is the calling thread
+    SDL_Mutex *mutex;
+    SDL_Condition *workReady;        // Signalled when a pass is published or on shutdown
+    SDL_Condition *workDone;         // Signalled when the last worker leaves a pass
+    uint32_t generation;             // Bumped for every pass
+    uint32_t active;                 // Workers still in the current pass
+    bool quit;
+    bool serial;                     // Run passes on the caller alone, in a repeatable order
+    Graph *graph;                    // Pass in flight
+    uint32_t begin;                  // First rank of the pass
+    uint32_t passThreads;
+    SDL_AtomicInt *counters;         // Unreleased inputs per node plus a woken bit, indexed by handle
+    uint32_t *spill;                 // Next node down a worker's spill stack, indexed by handle
+    uint32_t counterCapacity;        // Of both counters and spill
+    SDL_AtomicInt remaining;         // Nodes of the pass not yet released
+    SDL_AtomicInt initPending;       // Workers still setting up their slice of the counters
+    SchedulerStats stats;
+} Scheduler;
+
+// threads counts the caller; 0 uses every logical core
+bool scheduler_init(Scheduler *scheduler, uint32_t threads);
+void scheduler_destroy(Scheduler *scheduler);
+// Serial passes use the same counters and deque on the calling thread only, so the order nodes
+// run in is the same on every run; values and counts match the parallel passes either way
+void scheduler_set_serial(Scheduler *scheduler, bool serial);
+// Makes the scheduler the graph's executor; graph_set_executor(graph, NULL) detaches it
+void scheduler_attach(Scheduler *scheduler, Graph *graph);
+
+#endif // MODULE_SCHEDULER_H
@@ -0,0 +1,96 @@
+#ifndef MODULE_SIMULATION_H
+#define MODULE_SIMULATION_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "module_graph.h"
+
+#define SIMULATION_DEFAULT_RATE 60      // Ticks per second
+#define SIMULATION_INPUT_CAPACITY 1024  // Queued inputs; a power of two
+#define SIMULATION_MAX_CATCHUP 8        // Ticks run back to back after a stall before the rest are skipped
+#define SIMULATION_SNAPSHOT_FRESH 0x4   // Set in the middle index while it holds a snapshot not yet read
+#define SIMULATION_MAX_INTEGRATORS 8    // Integrators per simulation
+
+typedef enum {
+    SIMULATION_INPUT_SET_VARIABLE,      // graph_set_variable(node, value)
+    SIMULATION_INPUT_SET_RATE,          // value ticks per second from the next tick on
+} SimulationInputType;
+
+typedef struct {
+    uint32_t type;                      // SimulationInputType
+    GraphNodeHandle node;
+    float value;
+} SimulationInput;
+
+// State carried from tick to tick: before every graph tick, target += rate, wrapped into [0, wrap)
+// when wrap is positive. target must be a variable, so an input that sets it restarts from there.
+typedef struct {
+    GraphNodeHandle rate;
+    GraphNodeHandle target;
+    float wrap;
+} SimulationIntegrator;
+
+// Single producer, single consumer ring: the render thread pushes, the simulation thread drains
+// before every tick. Indices only grow and wrap through the mask.
+typedef struct {
+    SimulationInput items[SIMULATION_INPUT_CAPACITY];
+    SDL_AtomicInt head;                 // Next input to drain, written by the simulation thread
+    uint8_t pad[64];                    // Keeps the producer's index off the consumer's cache line
+    SDL_AtomicInt tail;                 // Next free item, written by the render thread
+} SimulationInputQueue;
+
+// Node values at the end of one tick, indexed by graph handle
+typedef struct {
+    uint64_t tick;                      // Graph tick that produced it, 0 before the first
+    Uint64 publishedNs;                 // SDL_GetTicksNS when it was published
+    uint64_t skipped;                   // Ticks dropped after stalls, all ticks so far
+    Uint64 tickNs;                      // Time the tick took
+    uint32_t inputs;                    // Inputs drained up to this tick, comparable with the queue tail
+    float *values;
+    uint32_t count;
+    uint32_t capacity;
+} SimulationSnapshot;
+
+typedef struct {
+    uint64_t framesRead;                // Acquires that found a new snapshot
+    uint64_t inputsDropped;             // Pushes refused by a full queue
+    double lastAgeMs;                   // Age of the snapshot at its acquire
+    double worstAgeMs;                  // Since the last simulation_log_stats
+    uint64_t loggedTick;                // Snapshot tick at the last simulation_log_stats
+    Uint64 loggedNs;
+} SimulationStats;
+
+// Fixed-timestep thread that owns a graph and ticks it independently of rendering. Every tick
+// is copied into one of three snapshots: the simulation thread writes the back one, the render
+// thread reads the front one, and finished snapshots are handed over by swapping indices with the
+// middle one atomically, so neither side ever waits for the other or sees a half-written tick.
+typedef struct {
+    Graph *graph;                       // Touched only by the simulation thread until destroy
+    SDL_Thread *thread;
+    SDL_AtomicInt quit;
+    Uint64 periodNs;                    // Simulation thread only
+    SimulationIntegrator integrators[SIMULATION_MAX_INTEGRATORS];
+    uint32_t integratorCount;
+    SimulationSnapshot snapshots[3];
+    SDL_AtomicInt middle;               // Snapshot index, plus SIMULATION_SNAPSHOT_FRESH
+    uint32_t back;                      // Simulation thread only
+    uint32_t front;                     // Render thread only
+    SimulationInputQueue inputs;
+    SimulationStats stats;              // Render thread only
+} Simulation;
+
+// Starts ticking graph at rate ticks per second (0 for the default), advancing the integrators
+// every tick; the graph belongs to the simulation thread until simulation_destroy, which stops it
+// and leaves the graph to the caller
+bool simulation_init(Simulation *simulation, Graph *graph, uint32_t rate, const SimulationIntegrator *integrators,
+                     uint32_t integratorCount);
+void simulation_destroy(Simulation *simulation);
+// Render thread side; false if the queue is full
+bool simulation_push_input(Simulation *simulation, const SimulationInput *input);
+// Latest published snapshot, NULL before the first tick; stays valid until the next acquire
+const SimulationSnapshot *simulation_acquire_snapshot(Simulation *simulation);
+// Tick rate and snapshot age since the last call, from the render thread
+void simulation_log_stats(Simulation *simulation);
+
+#endif // MODULE_SIMULATION_H
@@ -0,0 +1,59 @@
+#ifndef MODULE_SPATIAL_H
+#define MODULE_SPATIAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SPATIAL_CELL_SIZE 128.0f          // Default cell edge in world units, about one default node
+#define SPATIAL_ITEM_INVALID UINT32_MAX
+
+typedef struct {
+    float minX, minY, maxX, maxY;
+} SpatialRect;
+
+// A grid cell in the hash table; keeps its item array once emptied so dragging does not reallocate
+typedef struct {
+    int32_t x, y;
+    uint32_t *items;
+    uint32_t count;
+    uint32_t capacity;
+    bool used;
+} SpatialCell;
+
+typedef struct {
+    SpatialRect bounds;
+    int32_t cellX, cellY;    // Cell holding the center of bounds
+    uint32_t slot;           // Index in that cell's item array, SPATIAL_ITEM_INVALID when not indexed
+} SpatialItem;
+
+// Loose uniform hash grid: each item lives in the one cell holding its center, and queries
+// grow by the largest half extent seen so items overhanging their cell are still found
+typedef struct {
+    float cellSize;
+    float inverseCellSize;
+    SpatialCell *cells;      // Open addressing, linear probing; capacity is a power of two
+    uint32_t cellCapacity;
+    uint32_t cellCount;      // Used cells
+    SpatialItem *items;      // Indexed by item id, which callers keep dense (node handles)
+    uint32_t itemCapacity;
+    uint32_t count;          // Items currently indexed
+    float maxHalfWidth;      // Largest item half extents ever inserted, never shrinks
+    float maxHalfHeight;
+    int32_t minCellX, minCellY, maxCellX, maxCellY; // Range of cells ever used, bounds every query
+} SpatialIndex;
+
+// Return false to stop the query
+typedef bool (*SpatialVisitor)(void *userData, uint32_t item, const SpatialRect *bounds);
+
+void spatial_init(SpatialIndex *index, float cellSize);
+void spatial_destroy(SpatialIndex *index);
+bool spatial_insert(SpatialIndex *index, uint32_t item, const SpatialRect *bounds);
+// Moves the item between cells only when its center crosses a cell border
+bool spatial_update(SpatialIndex *index, uint32_t item, const SpatialRect *bounds);
+void spatial_remove(SpatialIndex *index, uint32_t item);
+// Visits every item whose bounds overlap rect (touching edges count), in no particular order
+void spatial_query_rect(const SpatialIndex *index, const SpatialRect *rect, SpatialVisitor visit, void *userData);
+// Item whose bounds are closest to (x, y), 0 when inside; SPATIAL_ITEM_INVALID if none within maxDistance
+uint32_t spatial_nearest(const SpatialIndex *index, float x, float y, float maxDistance);
+
+#endif // MODULE_SPATIAL_H
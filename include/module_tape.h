@@ -0,0 +1,86 @@
+#ifndef MODULE_TAPE_H
+#define MODULE_TAPE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "module_graph.h"
+
+#define TAPE_NONE UINT32_MAX
+#define TAPE_RECOMPILE_FRACTION 4     // A sync recompiles everything once 1/4 of the tape, or of its operands, is dead
+
+#define TAPE_FLAG_ADDED   0x01        // Not on the tape yet
+#define TAPE_FLAG_REWIRED 0x02        // On the tape with inputs that changed since
+
+typedef enum {
+    TAPE_OP_NOP,                      // Left by a removed node until the next full compile
+    TAPE_OP_LOAD,                     // Variable: registers[output] = values[a], a being the node handle
+    TAPE_OP_TICK,                     // Tick node: the tick number given to tape_run
+    TAPE_OP_CONST,                    // Function without connected inputs: the integer in a
+    TAPE_OP_COPY,                     // Any function of one input
+    TAPE_OP_ADD2,
+    TAPE_OP_MUL2,
+    TAPE_OP_MIN2,
+    TAPE_OP_MAX2,
+    TAPE_OP_ADDN,                     // count input registers from operands[a]
+    TAPE_OP_MULN,
+    TAPE_OP_MINN,
+    TAPE_OP_MAXN,
+} TapeOpcode;
+
+typedef struct {
+    uint8_t opcode;                   // TapeOpcode
+    uint8_t count;                    // Inputs of the N-ary opcodes
+    uint16_t pad;
+    uint32_t output;                  // Register written
+    uint32_t a, b;                    // Input registers
+} TapeInstruction;
+
+typedef struct {
+    uint32_t compiles;                // Full compiles
+    uint32_t syncs;                   // Edits applied in place or appended
+    double lastCompileMs;
+    double lastSyncMs;                // Edits applied by the last sync; 0 when it had none or compiled instead
+} TapeStats;
+
+// A graph lowered to straight-line code: one instruction per node in topological order, each
+// reading and writing a contiguous register file. tape_run evaluates every node with no
+// scheduling, flags or adjacency, so it suits graphs that tick far more often than they change.
+// Edits reach the tape through the graph's listener: removed nodes become NOPs on the spot,
+// rewired nodes are re-emitted in place and added nodes appended, as long as every input still
+// comes earlier on the tape; anything else, and tapes full of NOPs or dead operands, compile
+// from scratch.
+typedef struct {
+    Graph *graph;                     // Listened to for edits
+    TapeInstruction *code;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t nops;
+    uint32_t *operands;               // Input registers of the N-ary opcodes
+    uint32_t operandCount;
+    uint32_t operandCapacity;
+    uint32_t orphanedOperands;        // Left behind by re-emitted and removed nodes until the next full compile
+    float *registers;
+    uint32_t registerCount;
+    uint32_t registerCapacity;
+    uint32_t *nodeInstruction;        // Graph handle -> instruction, TAPE_NONE when not on the tape
+    uint32_t *nodeRegister;           // Graph handle -> register, TAPE_NONE when not on the tape
+    uint8_t *nodeFlags;               // TAPE_FLAG_*
+    uint32_t nodeCapacity;
+    uint32_t *edited;                 // Nodes flagged since the last sync, in edit order
+    uint32_t editedCount;
+    uint32_t editedCapacity;
+    bool stale;                       // Needs a full compile
+    TapeStats stats;
+} Tape;
+
+// Compiles the whole graph and starts listening to it; the graph's listener is taken
+bool tape_init(Tape *tape, Graph *graph);
+void tape_destroy(Tape *tape);
+// Brings the tape up to date with the edits since the last sync; cheap when there were none
+bool tape_sync(Tape *tape);
+// Syncs if the graph was edited, then evaluates every node on the tape, reading variables from
+// the graph's values. False if the sync failed.
+bool tape_run(Tape *tape, float tick);
+bool tape_get_value(const Tape *tape, GraphNodeHandle node, float *value);
+
+#endif // MODULE_TAPE_H
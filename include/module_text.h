@@ -2,23 +2,75 @@
 #define MODULE_TEXT_H
 
 #include <SDL3/SDL.h>
-#include <SDL3_ttf/SDL_ttf.h>
 #include <vulkan/vulkan.h>
 #include <stdbool.h>
 #include "module_vulkan.h"
+#include "module_font.h"
+#include "module_atlas.h"
+#include "module_layout.h"
+#include "module_spatial.h"
+
+#define TEXT_FONT_PATH "assets/fonts/Kenney Pixel.ttf"
+#define TEXT_INITIAL_GLYPHS 4096 // Glyph instances each frame region starts with; doubles when exceeded
+#define TEXT_INITIAL_LABELS 256  // Label transforms each frame region starts with; doubles when exceeded
+#define TEXT_STAGING_BYTES (256 * 1024) // Glyph distance fields one frame can upload
+#define TEXT_MAX_UPLOADS 256 // Glyph copies one frame can record; later misses wait a frame
+#define TEXT_LABEL_INVALID UINT32_MAX
+
+typedef uint32_t TextLabelHandle;
+
+// One glyph quad of the frame, drawn as a 4-vertex strip instance
+typedef struct {
+    float x0, y0, x1, y1;       // Quad in FONT_SDF_SIZE pixels from the label's top-left
+    uint16_t u0, v0, u1, v1;    // Atlas rectangle, normalized to 65535
+    uint32_t color;             // RGBA8, red in the low byte
+    uint32_t label;             // Index into the frame's label transforms
+} GlyphInstance;
+
+// Places a label's glyphs in the world: position + local * scale; std430 vec4
+typedef struct {
+    float x, y;
+    float scale;                // World units per FONT_SDF_SIZE pixel
+    float pad;
+} LabelTransform;
 
 typedef struct {
- float x, y; // Position
- float u, v; // Texture coordinates
-} TextVertex;
+    char *text;                 // NULL while the slot is free
+    uint32_t length;            // Bytes of text
+    FontId font;
+    uint64_t layoutHash;        // layout_hash of text and font, computed when either is set
+    vec2 position;              // Top-left in world units
+    float size;                 // Em size in world units
+    uint32_t color;             // RGBA8, red in the low byte
+    SpatialRect localBounds;    // Bounds of the shaped run in FONT_SDF_SIZE pixels from the top-left
+    bool measured;              // localBounds matches text; cleared when the string changes
+    uint32_t nextFree;
+} TextLabel;
 
 typedef struct TextContext {
-    VkBuffer vertexBuffer;
-    VkDeviceMemory vertexBufferMemory;
-    VkBuffer indexBuffer;
-    VkDeviceMemory indexBufferMemory;
-    VkImage textureImage;
-    VkDeviceMemory textureImageMemory;
+    FontManager fonts;
+    FontId defaultFont;         // TEXT_FONT_PATH, preloaded by text_init; new labels use it
+    GlyphAtlas atlas;           // Glyphs resident in textureImage
+    LayoutCache layouts;        // Shaped label strings
+    LayoutGlyph *shapeGlyphs;   // Scratch run for shaping a miss
+    uint32_t shapeCapacity;
+    TextLabel *labels;          // Indexed by handle
+    uint32_t labelCapacity;
+    uint32_t labelCount;        // Labels in use
+    uint32_t freeLabel;         // Head of the free slot list
+    TextLabelHandle titleLabel; // Added by text_init
+    VkBuffer instanceBuffer;    // Glyph instances, one region per frame in flight
+    MemoryAllocation instanceAllocation;
+    uint32_t glyphCapacity;     // Instances each region can hold
+    VkBuffer transformBuffer;   // Label transforms, one region per frame in flight
+    MemoryAllocation transformAllocation;
+    VkDeviceSize transformRegionSize; // Region stride, aligned to minStorageBufferOffsetAlignment
+    uint32_t transformCapacity; // Transforms each region can hold
+    VkBuffer stagingBuffer;     // Distance fields of missed glyphs, one region per frame in flight
+    MemoryAllocation stagingAllocation;
+    VkImage textureImage;       // The glyph atlas, R8 distances
+    MemoryAllocation textureImageAllocation;
+    bool atlasCleared;          // The first prepare clears the image before any copy lands in it
     VkImageView textureImageView;
     VkSampler textureSampler;
     VkDescriptorSetLayout descriptorSetLayout;
@@ -26,12 +78,27 @@ typedef struct TextContext {
     VkDescriptorSet descriptorSet;
     VkPipelineLayout pipelineLayout;
     VkPipeline graphicsPipeline;
-    vec2 position; // Text position
-    mat4 modelMatrix; // Text transformation
+    uint32_t glyphCount;        // Instances packed by the last text_prepare
+    bool glyphsDeferred;        // Misses that did not fit this frame's uploads; another frame is needed
 } TextContext;
 
 bool text_init(VulkanContext *vulkanContext, TextContext *textContext);
+TextLabelHandle text_label_add(TextContext *textContext, const char *text, float x, float y, float size, const float color[4]);
+void text_label_remove(TextContext *textContext, TextLabelHandle label);
+bool text_label_set_string(TextContext *textContext, TextLabelHandle label, const char *text);
+// Draws the label in a font of textContext->fonts; it is skipped while the font is still loading
+bool text_label_set_font(TextContext *textContext, TextLabelHandle label, FontId font);
+bool text_label_get_position(const TextContext *textContext, TextLabelHandle label, float position[2]);
+// World bounds of the label as last shaped; false until it has been laid out once
+bool text_label_get_bounds(const TextContext *textContext, TextLabelHandle label, SpatialRect *bounds);
+// Topmost label whose bounds contain the world point, TEXT_LABEL_INVALID if none
+TextLabelHandle text_label_pick(const TextContext *textContext, float x, float y);
+void text_label_set_position(TextContext *textContext, TextLabelHandle label, float x, float y);
+// Culls the labels against the camera, packs the visible glyphs into this frame's instance region
+// and copies missed glyphs into the atlas; records outside a render pass
+void text_prepare(VulkanContext *vulkanContext, TextContext *textContext, VkCommandBuffer commandBuffer);
+// One instanced draw for every glyph packed by text_prepare
 void text_render(VulkanContext *vulkanContext, TextContext *textContext, VkCommandBuffer commandBuffer);
 void text_cleanup(VulkanContext *vulkanContext, TextContext *textContext);
 
-#endif // MODULE_TEXT_H
\ No newline at end of file
+#endif // MODULE_TEXT_H
@@ -0,0 +1,58 @@
+#ifndef MODULE_TRANSFORM_H
+#define MODULE_TRANSFORM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint32_t TransformHandle;
+#define TRANSFORM_HANDLE_INVALID UINT32_MAX
+#define TRANSFORM_ROOT UINT32_MAX     // Parent index of an entry without a parent
+
+#define TRANSFORM_FLAG_DIRTY 0x01     // Local changed; the entry and its subtree get new world transforms
+
+// 2D affine transform: x axis (a, b), y axis (c, d), translation (tx, ty)
+typedef struct {
+    float a, b, c, d;
+    float tx, ty;
+} TransformAffine;
+
+// Parent/child transforms in pre-order: parents precede their children and every subtree is the
+// contiguous range [i, i + sizes[i]), so one forward pass recomputes world transforms and a dirty
+// entry's subtree is a range. Topology changes shift the arrays and cost O(n); they happen on
+// edits, not per frame.
+typedef struct {
+    uint32_t *parents;        // Dense index of the parent, TRANSFORM_ROOT for roots
+    uint32_t *sizes;          // Entries in the subtree, the entry itself included
+    TransformAffine *locals;  // Relative to the parent
+    TransformAffine *worlds;  // Valid for entries outside dirty subtrees
+    uint8_t *flags;           // TRANSFORM_FLAG_*
+    uint32_t *owners;         // Caller id reported by transform_update
+    TransformHandle *handles; // Dense index -> handle
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t *slotIndex;      // Handle -> dense index, or next free handle
+    uint32_t slotCapacity;
+    uint32_t slotCount;       // Handles ever issued
+    uint32_t freeHead;        // First recycled handle, TRANSFORM_HANDLE_INVALID if none
+    uint32_t dirtyBegin;      // Dense range holding every dirty flag, empty when begin >= end
+    uint32_t dirtyEnd;
+} TransformHierarchy;
+
+// Called for every entry whose world transform was recomputed
+typedef void (*TransformVisitor)(void *userData, uint32_t owner, const TransformAffine *world);
+
+void transform_init(TransformHierarchy *hierarchy);
+void transform_destroy(TransformHierarchy *hierarchy);
+void transform_affine_make(float x, float y, float rotation, TransformAffine *affine);
+// parent may be TRANSFORM_HANDLE_INVALID for a root
+TransformHandle transform_add(TransformHierarchy *hierarchy, TransformHandle parent, uint32_t owner, const TransformAffine *local);
+// Children keep their locals and move up to the removed entry's parent
+bool transform_remove(TransformHierarchy *hierarchy, TransformHandle handle);
+// Moves the whole subtree; fails if parent lies inside it
+bool transform_set_parent(TransformHierarchy *hierarchy, TransformHandle handle, TransformHandle parent);
+bool transform_set_local(TransformHierarchy *hierarchy, TransformHandle handle, const TransformAffine *local);
+const TransformAffine *transform_get_world(const TransformHierarchy *hierarchy, TransformHandle handle);
+// Recompute the world transforms of dirty subtrees in one pass. Returns how many were recomputed.
+uint32_t transform_update(TransformHierarchy *hierarchy, TransformVisitor visit, void *userData);
+
+#endif // MODULE_TRANSFORM_H
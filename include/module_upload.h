@@ -0,0 +1,63 @@
+#ifndef MODULE_UPLOAD_H
+#define MODULE_UPLOAD_H
+
+#include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "module_memory.h"
+
+#define UPLOAD_STAGING_SIZE (16ull * 1024 * 1024) // Persistent staging ring
+#define UPLOAD_BATCH_COUNT 4                      // Transfer submissions that may be in flight
+#define UPLOAD_ALIGNMENT 16                       // Staging offset alignment, covers every texel size we use
+
+// Timeline value of the submission carrying an upload; 0 is never issued
+typedef uint64_t UploadHandle;
+#define UPLOAD_HANDLE_INVALID 0
+
+typedef struct {
+    VkCommandBuffer commandBuffer;
+    uint64_t value;          // Timeline value signalled when this batch completes
+    VkDeviceSize ringEnd;    // Staging ring head when the batch was submitted
+    bool recording;
+} UploadBatch;
+
+typedef struct {
+    uint64_t bytesQueued;    // Bytes copied into the staging ring since init
+    uint32_t uploadsQueued;
+    uint32_t batchesSubmitted;
+    uint32_t stalls;         // Times the ring or batch slots were full and the CPU had to wait
+} UploadStats;
+
+typedef struct {
+    VkDevice device;
+    MemoryAllocator *allocator;
+    VkQueue queue;
+    uint32_t queueFamily;
+    uint32_t queueFamilies[2];   // Transfer and graphics families, for CONCURRENT sharing
+    uint32_t queueFamilyCount;   // 1 when uploads run on the graphics family
+    VkCommandPool commandPool;
+    VkSemaphore timeline;        // Signalled with each batch's value
+    VkBuffer stagingBuffer;
+    MemoryAllocation stagingAllocation;
+    VkDeviceSize head;           // Next free byte in the staging ring
+    VkDeviceSize tail;           // Oldest byte still read by an in-flight batch
+    VkDeviceSize pendingBytes;   // Staged since the last submit; the ring never resets under them
+    UploadBatch batches[UPLOAD_BATCH_COUNT];
+    uint32_t currentBatch;       // Batch collecting this frame's copies
+    uint64_t submittedValue;     // Value of the last submitted batch
+    uint64_t completedValue;     // Last value observed on the timeline
+    UploadStats stats;
+} UploadManager;
+
+bool upload_init(UploadManager *upload, VkDevice device, MemoryAllocator *allocator,
+                 uint32_t transferFamily, VkQueue transferQueue, uint32_t graphicsFamily);
+void upload_cleanup(UploadManager *upload);
+void upload_get_sharing(const UploadManager *upload, VkSharingMode *sharingMode, uint32_t *familyCount, const uint32_t **families);
+// Static data for resources nothing samples until the returned handle completes. Images in use
+// by frames in flight, such as the glyph atlas, copy inside the frame's own command buffer instead.
+UploadHandle upload_buffer(UploadManager *upload, VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size);
+uint64_t upload_flush(UploadManager *upload);
+bool upload_is_complete(UploadManager *upload, UploadHandle handle);
+bool upload_wait(UploadManager *upload, UploadHandle handle);
+
+#endif // MODULE_UPLOAD_H
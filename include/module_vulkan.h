@@ -6,68 +6,177 @@
 #include <vulkan/vulkan.h>
 #include <stdbool.h>
 #include <cglm/cglm.h>
+#include "module_node.h"
+#include "module_memory.h"
+#include "module_upload.h"
+#include "module_profiler.h"
+#include "module_jobs.h"
 
 struct TextContext;
+struct WireContext;
 
 typedef struct {
     float x, y; // Position
     float r, g, b; // Color
 } Vertex;
 
-typedef struct {
-    vec2 position; // Object position
-    mat4 modelMatrix; // Per-object transformation
-} Object;
-
 typedef struct {
     vec2 position; // Camera position (x, y)
     float scale;   // Zoom level
 } Camera;
 
+#define UNIFORM_RING_SLOTS_PER_FRAME 256 // Uniform slots available to each frame in flight
+#define FRAMES_IN_FLIGHT 2                // Default frames the CPU may record ahead of the GPU
+#define MAX_FRAMES_IN_FLIGHT 4            // Upper bound accepted from PresentConfig
+#define FRAME_INTERVAL_SAMPLES 120        // Frame intervals kept for the pacing report
+#define MAX_RETIRED_SWAPCHAINS 8          // Swapchains waiting for their last frame to finish
+
+// Per-image resources of a swapchain replaced by recreate_swapchain, destroyed once every
+// submission that referenced them, and a further framesInFlight after it, has signalled its fence
 typedef struct {
+    VkSwapchainKHR swapchain;
+    VkImageView *imageViews;
+    VkFramebuffer *framebuffers;
+    VkSemaphore *renderFinishedSemaphores;
+    VkFence *fencesInUse;
+    uint32_t imageCount;
+    uint64_t retireSerial;            // Last submission that may reference these resources
+} RetiredSwapchain;
+
+// Presentation settings, filled by vulkan_present_config_init from the environment
+// (NODE2D_PRESENT_MODE, NODE2D_FRAMES_IN_FLIGHT, NODE2D_PACE_FPS, NODE2D_RECORD_THREADS) and overridden
+// by the command line
+typedef struct {
+    VkPresentModeKHR presentMode;     // Preferred mode; the nearest supported mode is used instead when missing
+    uint32_t framesInFlight;          // 1..MAX_FRAMES_IN_FLIGHT; 1 gives the lowest latency
+    uint32_t paceFps;                 // vulkan_pace_frame sleeps to start frames at this rate; 0 disables pacing
+    uint32_t recordThreads;           // Threads recording node chunks, 1..JOB_MAX_THREADS; 1 records inline
+} PresentConfig;
+
+// Dense batch indices of the nodes overlapping the view, per mesh, in draw order
+typedef struct {
+    uint32_t *indices[NODE_MESH_COUNT];
+    uint32_t counts[NODE_MESH_COUNT];
+    uint32_t capacities[NODE_MESH_COUNT];
+} NodeCullList;
+
+typedef struct {
+    uint64_t frameIndex;              // Frames recorded since init
+    uint64_t framesSkipped;           // Loop iterations with nothing to redraw
+    VkDeviceSize uniformBytesWritten; // Bytes written into the uniform ring by the last frame
+    uint32_t uniformSlotsUsed;        // Uniform slots consumed by the last frame
+    VkDeviceSize instanceBytesWritten; // Node instance bytes packed by the last frame
+    uint32_t drawCalls;               // Draw calls recorded by the last frame
+    uint32_t instancesDrawn;          // Node instances drawn by the last frame
+    uint32_t nodesCulled;             // Nodes outside the view skipped by the last frame
+    uint32_t transformsRebuilt;       // Dirty node instances rebuilt by the last frame
+    uint32_t labelsDrawn;             // Text labels drawn by the last frame
+    uint32_t labelsCulled;            // Text labels outside the view skipped by the last frame
+    uint32_t glyphsDrawn;             // Glyph instances drawn by the last frame, every label in one draw
+    uint32_t glyphsUploaded;          // Glyphs copied into the atlas by the last frame
+    uint32_t wiresDrawn;              // Wires drawn by the last frame, every wire in one draw
+    uint32_t wiresCulled;             // Wires outside the view skipped by the last frame
+    uint32_t wireEndpointsUpdated;    // Wire endpoints rewritten for nodes moved since the frame before
+    uint64_t recordNs;                // CPU time spent packing and recording the last frame
+    uint64_t frameIntervalsNs[FRAME_INTERVAL_SAMPLES]; // Time between consecutive presents, ring
+    uint32_t frameIntervalCount;      // Valid samples in frameIntervalsNs
+    uint64_t lastPresentNs;
+} RenderStats;
+
+typedef struct {
+    bool headless;                    // Renders into offscreen images; no window, surface or swapchain
     VkInstance instance;
     VkSurfaceKHR surface;
     VkPhysicalDevice physicalDevice;
     VkDevice device;
+    MemoryAllocator allocator;        // Every buffer and image is sub-allocated from here
+    UploadManager upload;             // Staging ring and transfer submissions
     VkQueue graphicsQueue;
     VkQueue presentQueue;
+    VkQueue transferQueue;            // Dedicated transfer queue, or graphicsQueue when none exists
     uint32_t graphicsFamily;
     uint32_t presentFamily;
+    uint32_t transferFamily;
+    SDL_Window *window;
     VkSwapchainKHR swapchain;
+    VkSurfaceFormatKHR surfaceFormat; // Chosen once at init, the render pass depends on it
+    VkPresentModeKHR presentMode;     // Chosen once at init from present.presentMode, reused on every recreation
+    PresentConfig present;
+    uint64_t nextFrameNs;             // Pacing deadline of the next frame
     VkRenderPass renderPass;
     VkPipelineLayout pipelineLayout;
     VkPipeline graphicsPipeline;
+    VkPipelineCache pipelineCache;    // Shared by every pipeline, persisted at cleanup
+    bool pipelineCacheWarm;           // Seeded from a valid on-disk cache
+    char pipelineCachePath[1024];
     VkCommandPool commandPool;
-    VkCommandBuffer *commandBuffers;
-    VkSemaphore *imageAvailableSemaphores;
-    VkSemaphore *renderFinishedSemaphores;
-    VkFence *inFlightFences;
-    VkFence *fencesInUse;
-    VkBuffer vertexBuffer;
-    VkDeviceMemory vertexBufferMemory;
-    VkBuffer triangleVertexBuffer;
-    VkDeviceMemory triangleVertexBufferMemory;
-    VkBuffer squareVertexBuffer;
-    VkDeviceMemory squareVertexBufferMemory;
-    VkBuffer squareIndexBuffer;
-    VkDeviceMemory squareIndexBufferMemory;
+    VkCommandBuffer *commandBuffers;        // Per frame in flight
+    JobSystem jobs;                         // Workers recording node chunks when recordThreads > 1
+    uint32_t recordThreads;                 // Node chunks per frame, one secondary command buffer each
+    VkCommandPool *recordPools;             // [frame * recordThreads + chunk], NULL when recording inline
+    VkCommandBuffer *recordBuffers;         // [frame * (recordThreads + 2) + chunk]; the last two of each frame hold text and wires
+    VkSemaphore *imageAvailableSemaphores;  // Per frame in flight
+    VkFence *inFlightFences;                // Per frame in flight
+    uint64_t *frameSerials;                 // Per frame in flight: serial of its last submission
+    VkSemaphore *renderFinishedSemaphores;  // Per swapchain image
+    VkFence *fencesInUse;                   // Per swapchain image: fence of the frame rendering it
+    uint64_t submitSerial;                  // Submissions so far
+    uint64_t completedSerial;               // Highest submission known to have finished
+    RetiredSwapchain retiredSwapchains[MAX_RETIRED_SWAPCHAINS];
+    uint32_t retiredSwapchainCount;
+    VkBuffer meshVertexBuffer;        // Vertices of every NodeMesh
+    MemoryAllocation meshVertexAllocation;
+    VkBuffer meshIndexBuffer;         // Indices of every NodeMesh
+    MemoryAllocation meshIndexAllocation;
     VkFramebuffer *framebuffers;
     VkImageView *imageViews;
     uint32_t imageCount;
-    VkExtent2D swapchainExtent;
+    VkExtent2D swapchainExtent;       // Offscreen image size when headless
+    VkImage *offscreenImages;         // Headless: one color target per frame in flight
+    MemoryAllocation *offscreenAllocations;
+    uint32_t lastImageIndex;          // Image written by the most recent frame
     struct TextContext *textContext;
+    struct WireContext *wireContext;
     Camera camera;
-    Object objects[2]; // 0: triangle, 1: square
-    VkBuffer uniformBuffer;
-    VkDeviceMemory uniformBufferMemory;
+    NodeStore nodes;
+    NodeCullList cull;                // Visible nodes of the frame being recorded
+    VkBuffer nodeBuffer;              // Node instance storage ring, one region per frame in flight
+    MemoryAllocation nodeAllocation;
+    void *nodeBufferMapped;           // nodeAllocation.mapped
+    VkDeviceSize nodeRegionSize;      // Region stride, aligned to minStorageBufferOffsetAlignment
+    uint32_t nodeCapacity;            // Instances each region can hold
+    VkDeviceSize storageAlignment;
+    VkBuffer uniformBuffer;           // Uniform ring, one region per frame in flight
+    MemoryAllocation uniformAllocation;
+    void *uniformBufferMapped;        // uniformAllocation.mapped, persistently mapped
+    VkDeviceSize uniformSlotSize;     // Slot stride, aligned to minUniformBufferOffsetAlignment
+    uint32_t uniformSlotCursor;       // Next free slot in the current frame's region
+    uint32_t framesInFlight;          // Regions in the uniform and node rings, per-frame sync objects
+    uint32_t currentFrame;
     VkDescriptorSetLayout descriptorSetLayout;
     VkDescriptorPool descriptorPool;
-    VkDescriptorSet *descriptorSets;
+    VkDescriptorSet descriptorSet;    // Dynamic uniform buffer set shared by all draws
+    RenderStats stats;
+    Profiler profiler;                // CPU scopes and GPU timestamps, disabled until toggled
+    bool dirty;                       // Something visible changed since the last submitted frame
 } VulkanContext;
 
-bool vulkan_init(SDL_Window *window, VulkanContext *context);
+void vulkan_present_config_init(PresentConfig *config);
+bool vulkan_parse_present_mode(const char *name, VkPresentModeKHR *mode);
+const char *vulkan_present_mode_name(VkPresentModeKHR mode);
+bool vulkan_init(SDL_Window *window, const PresentConfig *config, VulkanContext *context);
+bool vulkan_init_headless(const PresentConfig *config, VulkanContext *context, uint32_t width, uint32_t height);
+void vulkan_pace_frame(VulkanContext *context);
+void vulkan_request_redraw(VulkanContext *context);
+bool vulkan_set_record_threads(VulkanContext *context, uint32_t threads);
 bool vulkan_render(VulkanContext *context);
 void vulkan_cleanup(VulkanContext *context);
 bool recreate_swapchain(VulkanContext *context, SDL_Window *window);
+bool vulkan_push_uniform(VulkanContext *context, const void *data, VkDeviceSize size, uint32_t *dynamicOffset);
+void vulkan_log_stats(const VulkanContext *context);
+bool vulkan_save_frame(VulkanContext *context, const char *path);
+void vulkan_screen_to_world(const VulkanContext *context, float screenX, float screenY, vec2 world);
+void vulkan_view_projection(const VulkanContext *context, mat4 vp);
+void vulkan_visible_rect(const VulkanContext *context, SpatialRect *rect);
 
 #endif // MODULE_VULKAN_H
\ No newline at end of file
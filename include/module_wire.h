@@ -0,0 +1,74 @@
+#ifndef MODULE_WIRE_H
+#define MODULE_WIRE_H
+
+#include <SDL3/SDL.h>
+#include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include "module_vulkan.h"
+#include "module_node.h"
+#include "module_spatial.h"
+
+#define WIRE_SEGMENTS 32            // Curve segments per wire; its strip has 2 * (WIRE_SEGMENTS + 1) vertices
+#define WIRE_INITIAL_CAPACITY 1024  // Wire instances each frame region starts with; doubles when exceeded
+#define WIRE_DEFAULT_WIDTH 4.0f     // World units
+#define WIRE_DEFAULT_TANGENT 80.0f  // Horizontal distance of the control points from their endpoints
+#define WIRE_HANDLE_INVALID UINT32_MAX
+
+typedef uint32_t WireHandle;
+
+// One connection, drawn as one triangle strip instance; shader_wire.vert evaluates the cubic
+// bezier and widens it into a ribbon. Control points are stored relative to their endpoints,
+// so a node move rewrites the endpoint and nothing else.
+typedef struct {
+    float p0[2], p3[2];         // Endpoints in world units: the source and destination node positions
+    float c1[2], c2[2];         // Control points, c1 relative to p0 and c2 relative to p3
+    uint32_t color;             // RGBA8, red in the low byte
+    float width;                // World units
+} WireInstance;
+
+typedef struct {
+    NodeHandle nodes[2];        // Source, destination
+    WireHandle next[2];         // Next wire in the list of nodes[0], nodes[1]
+    uint32_t index;             // Dense index while live, next free slot otherwise
+    bool live;
+} WireSlot;
+
+// Dense arrays: index i of instances, bounds and handles belong to the same wire
+typedef struct WireContext {
+    WireInstance *instances;    // Packed into the frame region when visible
+    SpatialRect *bounds;        // World bounds of each curve's control polygon, width included
+    WireHandle *handles;        // Dense index -> handle
+    uint32_t count;
+    uint32_t capacity;
+    WireSlot *slots;            // Indexed by handle
+    uint32_t slotCapacity;
+    uint32_t slotCount;         // Handles ever issued
+    uint32_t freeSlot;          // First recycled handle, WIRE_HANDLE_INVALID if none
+    WireHandle *nodeWires;      // Node handle -> first wire attached to it
+    uint32_t nodeWireCapacity;
+    NodeStore *nodes;           // Listened to for endpoint moves and node removals
+    uint32_t endpointsUpdated;  // Endpoints rewritten since the last wire_prepare
+    VkBuffer instanceBuffer;    // Visible wire instances, one region per frame in flight
+    MemoryAllocation instanceAllocation;
+    uint32_t instanceCapacity;  // Instances each region can hold
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkDescriptorPool descriptorPool;
+    VkDescriptorSet descriptorSet;
+    VkPipelineLayout pipelineLayout;
+    VkPipeline graphicsPipeline;
+    uint32_t drawCount;         // Instances packed by the last wire_prepare
+} WireContext;
+
+bool wire_init(VulkanContext *vulkanContext, WireContext *wireContext);
+// Connects two distinct nodes; the wire follows them as they move and goes away with either
+WireHandle wire_add(WireContext *wireContext, NodeHandle from, NodeHandle to, float width, const float color[4]);
+bool wire_remove(WireContext *wireContext, WireHandle wire);
+// Control points relative to the source and destination endpoints
+bool wire_set_tangents(WireContext *wireContext, WireHandle wire, const float c1[2], const float c2[2]);
+// Culls the wires against the camera and packs the visible ones into this frame's instance region
+void wire_prepare(VulkanContext *vulkanContext, WireContext *wireContext);
+// One instanced draw for every wire packed by wire_prepare
+void wire_render(VulkanContext *vulkanContext, WireContext *wireContext, VkCommandBuffer commandBuffer);
+void wire_cleanup(VulkanContext *vulkanContext, WireContext *wireContext);
+
+#endif // MODULE_WIRE_H
@@ -1,22 +0,0 @@
-	// 1115.2.0
-	 #pragma once
-const uint32_t shader_text_frag_spv[] = {
-	0x07230203,0x00010000,0x0008000b,0x00000014,0x00000000,0x00020011,0x00000001,0x0006000b,
-	0x00000001,0x4c534c47,0x6474732e,0x3035342e,0x00000000,0x0003000e,0x00000000,0x00000001,
-	0x0007000f,0x00000004,0x00000004,0x6e69616d,0x00000000,0x00000009,0x00000011,0x00030010,
-	0x00000004,0x00000007,0x00030003,0x00000002,0x000001c2,0x00040005,0x00000004,0x6e69616d,
-	0x00000000,0x00050005,0x00000009,0x67617266,0x6f6c6f43,0x00000072,0x00050005,0x0000000d,
-	0x53786574,0x6c706d61,0x00007265,0x00030005,0x00000011,0x00565576,0x00040047,0x00000009,
-	0x0000001e,0x00000000,0x00040047,0x0000000d,0x00000021,0x00000000,0x00040047,0x0000000d,
-	0x00000022,0x00000000,0x00040047,0x00000011,0x0000001e,0x00000000,0x00020013,0x00000002,
-	0x00030021,0x00000003,0x00000002,0x00030016,0x00000006,0x00000020,0x00040017,0x00000007,
-	0x00000006,0x00000004,0x00040020,0x00000008,0x00000003,0x00000007,0x0004003b,0x00000008,
-	0x00000009,0x00000003,0x00090019,0x0000000a,0x00000006,0x00000001,0x00000000,0x00000000,
-	0x00000000,0x00000001,0x00000000,0x0003001b,0x0000000b,0x0000000a,0x00040020,0x0000000c,
-	0x00000000,0x0000000b,0x0004003b,0x0000000c,0x0000000d,0x00000000,0x00040017,0x0000000f,
-	0x00000006,0x00000002,0x00040020,0x00000010,0x00000001,0x0000000f,0x0004003b,0x00000010,
-	0x00000011,0x00000001,0x00050036,0x00000002,0x00000004,0x00000000,0x00000003,0x000200f8,
-	0x00000005,0x0004003d,0x0000000b,0x0000000e,0x0000000d,0x0004003d,0x0000000f,0x00000012,
-	0x00000011,0x00050057,0x00000007,0x00000013,0x0000000e,0x00000012,0x0003003e,0x00000009,
-	0x00000013,0x000100fd,0x00010038
-};
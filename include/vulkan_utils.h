@@ -3,12 +3,14 @@
 
 #include <vulkan/vulkan.h>
 #include <SDL3/SDL.h>
+#include "module_memory.h"
 
-uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties);
-bool createBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer *buffer, VkDeviceMemory *bufferMemory);
-VkCommandBuffer beginSingleTimeCommands(VkDevice device, VkCommandPool commandPool);
-void endSingleTimeCommands(VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue, VkCommandBuffer commandBuffer);
-void transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout);
-void copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+bool createBuffer(MemoryAllocator *allocator, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer *buffer, MemoryAllocation *allocation);
+bool createBufferWithInfo(MemoryAllocator *allocator, const VkBufferCreateInfo *bufferInfo, VkMemoryPropertyFlags properties, VkBuffer *buffer, MemoryAllocation *allocation);
+void destroyBuffer(MemoryAllocator *allocator, VkBuffer *buffer, MemoryAllocation *allocation);
+bool createImage(MemoryAllocator *allocator, const VkImageCreateInfo *imageInfo, VkMemoryPropertyFlags properties, VkImage *image, MemoryAllocation *allocation);
+void destroyImage(MemoryAllocator *allocator, VkImage *image, MemoryAllocation *allocation);
+VkPipelineCache loadPipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, const char *path, bool *warm);
+void savePipelineCache(VkDevice device, VkPipelineCache pipelineCache, const char *path);
 
 #endif // VULKAN_UTILS_H
\ No newline at end of file
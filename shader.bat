@@ -5,10 +5,17 @@ set VULKAN_VERSION=1.4.313.0
 set VULKAN_Path=C:\VulkanSDK\%VULKAN_VERSION%\Bin\glslangValidator.exe
 echo path "%VULKAN_Path%"
 
-%VULKAN_Path% -V --vn shader2d_vert_spv shaders/shader2d.vert -o include/shader2d_vert_spv.h
-%VULKAN_Path% -V --vn shader2d_frag_spv shaders/shader2d.frag -o include/shader2d_frag_spv.h
+rem Same directory CMake generates the headers into, searched before include/
+set SPV_DIR=build\include
+if not exist %SPV_DIR% mkdir %SPV_DIR%
 
-%VULKAN_Path% -V --vn shader_text_vert_spv shaders/shader_text.vert -o include/shader_text_vert_spv.h
-%VULKAN_Path% -V --vn shader_text_frag_spv shaders/shader_text.frag -o include/shader_text_frag_spv.h
+%VULKAN_Path% -V --vn shader2d_vert_spv shaders/shader2d.vert -o %SPV_DIR%/shader2d_vert_spv.h
+%VULKAN_Path% -V --vn shader2d_frag_spv shaders/shader2d.frag -o %SPV_DIR%/shader2d_frag_spv.h
+
+%VULKAN_Path% -V --vn shader_text_vert_spv shaders/shader_text.vert -o %SPV_DIR%/shader_text_vert_spv.h
+%VULKAN_Path% -V --vn shader_text_frag_spv shaders/shader_text.frag -o %SPV_DIR%/shader_text_frag_spv.h
+
+%VULKAN_Path% -V --vn shader_wire_vert_spv shaders/shader_wire.vert -o %SPV_DIR%/shader_wire_vert_spv.h
+%VULKAN_Path% -V --vn shader_wire_frag_spv shaders/shader_wire.frag -o %SPV_DIR%/shader_wire_frag_spv.h
 
 endlocal
\ No newline at end of file
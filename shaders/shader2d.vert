@@ -5,10 +5,23 @@ layout(location = 1) in vec3 inColor;
 layout(location = 0) out vec3 fragColor;
 
 layout(binding = 0) uniform UniformBufferObject {
-    mat4 mvp;
+    mat4 viewProjection;
 } ubo;
 
+struct NodeInstance {
+    vec4 basis;       // Model x axis (xy) and y axis (zw)
+    vec2 translation;
+    uint color;       // RGBA8, red in the low byte
+    uint flags;
+};
+
+layout(std430, binding = 1) readonly buffer NodeBuffer {
+    NodeInstance nodes[];
+} nodeBuffer;
+
 void main() {
-    gl_Position = ubo.mvp * vec4(inPosition, 0.0, 1.0);
-    fragColor = inColor;
-}
\ No newline at end of file
+    NodeInstance node = nodeBuffer.nodes[gl_InstanceIndex];
+    vec2 worldPosition = node.translation + node.basis.xy * inPosition.x + node.basis.zw * inPosition.y;
+    gl_Position = ubo.viewProjection * vec4(worldPosition, 0.0, 1.0);
+    fragColor = inColor * unpackUnorm4x8(node.color).rgb;
+}
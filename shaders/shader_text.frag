@@ -1,7 +1,12 @@
 #version 450
-layout(binding = 0) uniform sampler2D texSampler;
+layout(binding = 0) uniform sampler2D texSampler; // Signed distance atlas, 0.5 on the outline
 layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) in vec4 fragColor;
 layout(location = 0) out vec4 outColor;
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
-}
\ No newline at end of file
+    // Antialias over one screen pixel whatever the zoom: fwidth is the distance change per pixel
+    float distance = texture(texSampler, fragTexCoord).r;
+    float width = max(fwidth(distance) * 0.5, 1.0 / 255.0);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+    outColor = vec4(fragColor.rgb, fragColor.a * alpha);
+}
@@ -2,10 +2,30 @@
 layout(binding = 1) uniform UniformBufferObject {
     mat4 mvp;
 } ubo;
-layout(location = 0) in vec2 inPosition;
-layout(location = 1) in vec2 inTexCoord;
+
+struct LabelTransform {
+    vec2 position;    // Top-left of the label in world units
+    float scale;      // World units per glyph atlas pixel
+    float pad;
+};
+
+layout(std430, binding = 2) readonly buffer LabelBuffer {
+    LabelTransform labels[];
+} labelBuffer;
+
+// One instance per glyph
+layout(location = 0) in vec4 inRect;      // Quad corners in label space
+layout(location = 1) in vec4 inTexRect;   // Atlas rectangle
+layout(location = 2) in vec4 inColor;
+layout(location = 3) in uint inLabel;
 layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out vec4 fragColor;
 void main() {
-    gl_Position = ubo.mvp * vec4(inPosition, 0.0, 1.0);
-    fragTexCoord = inTexCoord;
-}
\ No newline at end of file
+    // Triangle strip corners: (0, 0), (1, 0), (0, 1), (1, 1)
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    LabelTransform label = labelBuffer.labels[inLabel];
+    vec2 worldPosition = label.position + mix(inRect.xy, inRect.zw, corner) * label.scale;
+    gl_Position = ubo.mvp * vec4(worldPosition, 0.0, 1.0);
+    fragTexCoord = mix(inTexRect.xy, inTexRect.zw, corner);
+    fragColor = inColor;
+}
@@ -0,0 +1,10 @@
+#version 450
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in float fragDistance;
+layout(location = 2) in float fragHalfWidth;
+layout(location = 0) out vec4 outColor;
+void main() {
+    // Full inside the ribbon, fading to zero over the pixel straddling its edge
+    float alpha = clamp(fragHalfWidth + 0.5 - abs(fragDistance), 0.0, 1.0);
+    outColor = vec4(fragColor.rgb, fragColor.a * alpha);
+}
@@ -0,0 +1,47 @@
+#version 450
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 viewProjection;
+} ubo;
+
+layout(push_constant) uniform WirePush {
+    float pixelSize;  // World units per screen pixel
+} push;
+
+layout(constant_id = 0) const uint SEGMENTS = 32; // WIRE_SEGMENTS
+
+// One instance per wire
+layout(location = 0) in vec4 inEnds;      // Source (xy) and destination (zw) endpoints
+layout(location = 1) in vec4 inControls;  // Control points relative to the source (xy) and destination (zw)
+layout(location = 2) in vec4 inColor;
+layout(location = 3) in float inWidth;    // World units
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out float fragDistance;  // Pixels from the centre line, signed
+layout(location = 2) out float fragHalfWidth; // Pixels
+void main() {
+    // Strip vertices come in pairs, one on each side of the curve at the same parameter
+    float t = float(uint(gl_VertexIndex) >> 1) / float(SEGMENTS);
+    float side = (gl_VertexIndex & 1) == 0 ? -1.0 : 1.0;
+    vec2 p0 = inEnds.xy;
+    vec2 p3 = inEnds.zw;
+    vec2 p1 = p0 + inControls.xy;
+    vec2 p2 = p3 + inControls.zw;
+    float s = 1.0 - t;
+    vec2 position = s * s * s * p0 + 3.0 * s * s * t * p1 + 3.0 * s * t * t * p2 + t * t * t * p3;
+    vec2 tangent = 3.0 * s * s * (p1 - p0) + 6.0 * s * t * (p2 - p1) + 3.0 * t * t * (p3 - p2);
+    // The derivative vanishes where a control point sits on its endpoint; the chord stands in for it
+    if (dot(tangent, tangent) < 1e-8) tangent = p3 - p0;
+    if (dot(tangent, tangent) < 1e-8) tangent = vec2(1.0, 0.0);
+    vec2 normal = normalize(vec2(-tangent.y, tangent.x));
+
+    // Reach one pixel past the edge so the fragment shader can fade it; wires thinner than a
+    // pixel keep a one pixel ribbon and fade by their coverage instead
+    float halfWidth = 0.5 * inWidth / push.pixelSize;
+    float coverage = min(2.0 * halfWidth, 1.0);
+    halfWidth = max(halfWidth, 0.5);
+    float extent = halfWidth + 1.0;
+    vec2 worldPosition = position + normal * side * extent * push.pixelSize;
+    gl_Position = ubo.viewProjection * vec4(worldPosition, 0.0, 1.0);
+    fragColor = vec4(inColor.rgb, inColor.a * coverage);
+    fragDistance = side * extent;
+    fragHalfWidth = halfWidth;
+}
@@ -3,8 +3,858 @@
 #include <cglm/cglm.h>
 #include "module_vulkan.h"
 #include "module_text.h"
+#include "module_wire.h"
+#include "module_graph.h"
+#include "module_scheduler.h"
+#include "module_tape.h"
+#include "module_simulation.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+#define HEADLESS_WIDTH 600
+#define HEADLESS_HEIGHT 480
+#define TRACE_FILE "profile_trace.json" // Written by the T key when --trace is not given
+#define IDLE_WAIT_MS 1000 // Longest sleep while nothing is dirty, so the stats log keeps ticking
+#define SPIN_SPEED 0.05f  // Radians per simulation tick of the node spun by the R key
+
+// Render frames back to back; returns how many succeeded before the first failure
+static int render_headless_frames(VulkanContext *context, int frames, double *totalMs, double *worstMs, Uint64 *recordNs) {
+    int rendered = 0;
+    *worstMs = 0.0;
+    *recordNs = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    while (rendered < frames) {
+        vulkan_pace_frame(context);
+        Uint64 frameStart = SDL_GetPerformanceCounter();
+        PROFILE_CPU_BEGIN(&context->profiler, "frame");
+        bool frameOk = vulkan_render(context);
+        PROFILE_CPU_END(&context->profiler);
+        if (!frameOk) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Headless frame %d failed", rendered);
+            break;
+        }
+        double frameMs = (SDL_GetPerformanceCounter() - frameStart) * 1000.0 / SDL_GetPerformanceFrequency();
+        if (frameMs > *worstMs) *worstMs = frameMs;
+        *recordNs += context->stats.recordNs;
+        rendered++;
+    }
+    // Include the GPU tail so the total covers every submitted frame
+    vkDeviceWaitIdle(context->device);
+    *totalMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    return rendered;
+}
+
+// Fill the scene with a grid of small nodes, then time the same frames at each record thread count
+static bool run_thread_benchmark(VulkanContext *context, int frames, int nodes) {
+    static const uint32_t threadCounts[] = { 1, 2, 4, 8 };
+    for (int i = 0; i < nodes; i++) {
+        NodeMesh mesh = (i & 1) ? NODE_MESH_SQUARE : NODE_MESH_TRIANGLE;
+        node_add(&context->nodes, mesh, (float)(i % 1000) * 4.0f, (float)(i / 1000) * 4.0f, 4.0f, (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+    }
+    for (uint32_t i = 0; i < SDL_arraysize(threadCounts); i++) {
+        if (!vulkan_set_record_threads(context, threadCounts[i])) return false;
+        double totalMs, worstMs;
+        Uint64 recordNs;
+        int rendered = render_headless_frames(context, frames, &totalMs, &worstMs, &recordNs);
+        if (rendered < frames) return false;
+        SDL_Log("Record threads %u, %u nodes: average %.3f ms per frame (%.3f ms recording), worst %.3f ms",
+                threadCounts[i], context->nodes.count, totalMs / rendered, recordNs / 1e6 / rendered, worstMs);
+    }
+    return true;
+}
+
+// Fill the view with a grid of labels and time frames that draw every one of them
+static bool run_text_benchmark(VulkanContext *context, int frames, int labels) {
+    const int columns = 100;
+    const float cellWidth = 120.0f, cellHeight = 30.0f;
+    for (int i = 0; i < labels; i++) {
+        char title[32];
+        SDL_snprintf(title, sizeof(title), "Node %d", i);
+        if (text_label_add(context->textContext, title, (float)(i % columns) * cellWidth, (float)(i / columns) * cellHeight,
+                           24.0f, (float[4]){1.0f, 1.0f, 1.0f, 1.0f}) == TEXT_LABEL_INVALID) {
+            return false;
+        }
+    }
+    // Zoom out until the whole grid is on screen
+    int rows = (labels + columns - 1) / columns;
+    float scaleX = context->swapchainExtent.width / (columns * cellWidth);
+    float scaleY = context->swapchainExtent.height / (rows * cellHeight);
+    context->camera.scale = SDL_min(scaleX, scaleY);
+    glm_vec2_zero(context->camera.position);
+
+    double totalMs, worstMs;
+    Uint64 recordNs;
+    int rendered = render_headless_frames(context, frames, &totalMs, &worstMs, &recordNs);
+    if (rendered < frames) return false;
+    SDL_Log("Text, %u labels: %u drawn, %u glyphs, %u draw calls per frame; average %.3f ms per frame "
+            "(%.3f ms recording), worst %.3f ms",
+            context->textContext->labelCount, context->stats.labelsDrawn, context->stats.glyphsDrawn,
+            context->stats.drawCalls, totalMs / rendered, recordNs / 1e6 / rendered, worstMs);
+    vulkan_log_stats(context);
+    return true;
+}
+
+// Connect a grid of nodes with wires, time frames that draw all of them, then drag one node per
+// frame and check that only the endpoints of its own wires are rewritten
+static bool run_wire_benchmark(VulkanContext *context, int frames, int wires) {
+    const int columns = 250;
+    const float spacing = 150.0f;
+    int nodes = SDL_max(wires / 2, 2);
+    for (int i = 0; i < nodes; i++) {
+        NodeMesh mesh = (i & 1) ? NODE_MESH_SQUARE : NODE_MESH_TRIANGLE;
+        node_add(&context->nodes, mesh, (float)(i % columns) * spacing, (float)(i / columns) * spacing, 40.0f,
+                 (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+    }
+    node_store_update_transforms(&context->nodes);
+    // Half the wires run to the next node, half to the node one row down
+    uint32_t *degrees = calloc((size_t)nodes, sizeof(uint32_t));
+    if (!degrees) return false;
+    for (int i = 0; i < wires; i++) {
+        NodeHandle from = (NodeHandle)(i % nodes);
+        NodeHandle to = (NodeHandle)((from + (i < nodes ? 1 : columns)) % nodes);
+        if (to == from) to = (from + 1) % nodes;
+        if (wire_add(context->wireContext, from, to, WIRE_DEFAULT_WIDTH, (float[4]){0.9f, 0.7f, 0.2f, 1.0f}) == WIRE_HANDLE_INVALID) {
+            free(degrees);
+            return false;
+        }
+        degrees[from]++;
+        degrees[to]++;
+    }
+    // Zoom out until the whole grid is on screen
+    int rows = (nodes + columns - 1) / columns;
+    float scaleX = context->swapchainExtent.width / (columns * spacing);
+    float scaleY = context->swapchainExtent.height / (rows * spacing);
+    context->camera.scale = SDL_min(scaleX, scaleY);
+    glm_vec2_zero(context->camera.position);
+
+    double totalMs, worstMs;
+    Uint64 recordNs;
+    int rendered = render_headless_frames(context, frames, &totalMs, &worstMs, &recordNs);
+    if (rendered < frames) {
+        free(degrees);
+        return false;
+    }
+    SDL_Log("Wires, %u wires between %u nodes: %u drawn, %u draw calls per frame; average %.3f ms per frame "
+            "(%.3f ms recording), worst %.3f ms",
+            context->wireContext->count, context->nodes.count, context->stats.wiresDrawn,
+            context->stats.drawCalls, totalMs / rendered, recordNs / 1e6 / rendered, worstMs);
+
+    uint64_t endpoints = 0, expected = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    recordNs = 0;
+    for (rendered = 0; rendered < frames; rendered++) {
+        NodeHandle dragged = (NodeHandle)(rendered % nodes);
+        float position[2];
+        node_get_position(&context->nodes, dragged, position);
+        node_set_position(&context->nodes, dragged, position[0] + 10.0f, position[1]);
+        if (!vulkan_render(context)) break;
+        recordNs += context->stats.recordNs;
+        endpoints += context->stats.wireEndpointsUpdated;
+        expected += degrees[dragged];
+    }
+    vkDeviceWaitIdle(context->device);
+    totalMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    free(degrees);
+    if (rendered < frames) return false;
+    SDL_Log("Wires, dragging one node per frame: %.1f endpoints rewritten per frame (%.1f expected); average %.3f ms "
+            "per frame (%.3f ms recording)",
+            (double)endpoints / rendered, (double)expected / rendered, totalMs / rendered, recordNs / 1e6 / rendered);
+    vulkan_log_stats(context);
+    return endpoints == expected;
+}
+
+static bool count_visit(void *userData, uint32_t item, const SpatialRect *bounds) {
+    (void)item;
+    (void)bounds;
+    (*(uint32_t *)userData)++;
+    return true;
+}
+
+static double elapsed_ns(Uint64 start, int operations) {
+    return (SDL_GetPerformanceCounter() - start) * 1e9 / SDL_GetPerformanceFrequency() / operations;
+}
+
+// Time node spatial index operations on a scene at the default node density; no Vulkan needed
+static int run_spatial_benchmark(void) {
+    static const int nodeCounts[] = { 100000, 1000000 };
+    const int queries = 100000;
+    SDL_srand(1);
+    for (uint32_t c = 0; c < SDL_arraysize(nodeCounts); c++) {
+        int nodes = nodeCounts[c];
+        float side = SDL_sqrtf((float)nodes) * 150.0f; // About one node per 150x150 world units
+        NodeStore store;
+        node_store_init(&store);
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < nodes; i++) {
+            NodeMesh mesh = (i & 1) ? NODE_MESH_SQUARE : NODE_MESH_TRIANGLE;
+            node_add(&store, mesh, SDL_randf() * side, SDL_randf() * side, 20.0f + SDL_randf() * 100.0f,
+                     (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+        }
+        node_store_update_transforms(&store);
+        double insertNs = elapsed_ns(start, nodes);
+
+        uint32_t hits = 0;
+        start = SDL_GetPerformanceCounter();
+        for (int q = 0; q < queries; q++) {
+            if (node_pick(&store, SDL_randf() * side, SDL_randf() * side) != NODE_HANDLE_INVALID) hits++;
+        }
+        double pickNs = elapsed_ns(start, queries);
+
+        uint32_t found = 0;
+        start = SDL_GetPerformanceCounter();
+        for (int q = 0; q < queries; q++) {
+            float x = SDL_randf() * side, y = SDL_randf() * side;
+            SpatialRect view = { x, y, x + 600.0f, y + 480.0f }; // One window at zoom 1
+            node_query_rect(&store, &view, count_visit, &found);
+        }
+        double rectNs = elapsed_ns(start, queries);
+
+        start = SDL_GetPerformanceCounter();
+        for (int q = 0; q < queries; q++) {
+            node_nearest(&store, SDL_randf() * side, SDL_randf() * side, FLT_MAX);
+        }
+        double nearestNs = elapsed_ns(start, queries);
+
+        // Drag-sized moves, each followed by the transform update that reindexes the node; most
+        // stay inside their cell
+        start = SDL_GetPerformanceCounter();
+        for (int q = 0; q < queries; q++) {
+            NodeHandle handle = (NodeHandle)SDL_rand(nodes);
+            float position[2];
+            node_get_position(&store, handle, position);
+            node_set_position(&store, handle, position[0] + SDL_randf() * 8.0f - 4.0f, position[1] + SDL_randf() * 8.0f - 4.0f);
+            node_store_update_transforms(&store);
+        }
+        double moveNs = elapsed_ns(start, queries);
+
+        SDL_Log("Spatial index, %d nodes in %u cells: insert %.0f ns, pick %.0f ns (%u hits), 600x480 rect %.0f ns "
+                "(%.1f nodes), nearest %.0f ns, move %.0f ns",
+                nodes, store.spatial.cellCount, insertNs, pickNs, hits, rectNs, (double)found / queries, nearestNs, moveNs);
+        node_store_destroy(&store);
+    }
+    return 0;
+}
+
+// The per-object layout the node store replaced: a position plus a full model matrix
+typedef struct {
+    vec2 position;
+    mat4 modelMatrix;
+} BenchObject;
+
+// Per-frame transform cost of the old AoS objects, which rebuilt every matrix each frame, against
+// the SoA node store, which rebuilds only the nodes moved that frame
+static int run_transform_benchmark(void) {
+    static const int nodeCounts[] = { 10000, 100000, 1000000 };
+    static const int movedPercent[] = { 1, 100 };
+    const int frames = 20;
+    SDL_srand(1);
+    for (uint32_t c = 0; c < SDL_arraysize(nodeCounts); c++) {
+        int nodes = nodeCounts[c];
+        BenchObject *objects = calloc((size_t)nodes, sizeof(BenchObject));
+        NodeStore store;
+        node_store_init(&store);
+        if (!objects) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate %d benchmark objects", nodes);
+            return 1;
+        }
+        for (int i = 0; i < nodes; i++) {
+            float x = SDL_randf() * 100000.0f, y = SDL_randf() * 100000.0f;
+            glm_vec2_copy((vec2){x, y}, objects[i].position);
+            node_add(&store, (i & 1) ? NODE_MESH_SQUARE : NODE_MESH_TRIANGLE, x, y, 50.0f, (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+        }
+        node_store_update_transforms(&store);
+
+        for (uint32_t p = 0; p < SDL_arraysize(movedPercent); p++) {
+            int moved = SDL_max(nodes / 100 * movedPercent[p], 1);
+            double aosMs = 0.0, soaSetMs = 0.0, soaUpdateMs = 0.0;
+            for (int f = 0; f < frames; f++) {
+                Uint64 start = SDL_GetPerformanceCounter();
+                for (int i = 0; i < moved; i++) {
+                    objects[i].position[0] += 1.0f;
+                }
+                for (int i = 0; i < nodes; i++) {
+                    glm_translate_make(objects[i].modelMatrix, (vec3){objects[i].position[0], objects[i].position[1], 0.0f});
+                }
+                aosMs += (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+                // The rebuild includes the spatial index update the AoS layout never had
+                start = SDL_GetPerformanceCounter();
+                for (int i = 0; i < moved; i++) {
+                    float position[2];
+                    node_get_position(&store, (NodeHandle)i, position);
+                    node_set_position(&store, (NodeHandle)i, position[0] + 1.0f, position[1]);
+                }
+                Uint64 middle = SDL_GetPerformanceCounter();
+                node_store_update_transforms(&store);
+                soaSetMs += (middle - start) * 1000.0 / SDL_GetPerformanceFrequency();
+                soaUpdateMs += (SDL_GetPerformanceCounter() - middle) * 1000.0 / SDL_GetPerformanceFrequency();
+            }
+            SDL_Log("Transforms, %d nodes, %d%% moved per frame: AoS objects %.3f ms, node store %.3f ms set + %.3f ms rebuild",
+                    nodes, movedPercent[p], aosMs / frames, soaSetMs / frames, soaUpdateMs / frames);
+        }
+        node_store_destroy(&store);
+        free(objects);
+    }
+    return 0;
+}
+
+// Drag a node that owns 50 children in a scene of loose nodes: each move must recompute exactly
+// the node and its children. Returns nonzero if the count is wrong.
+static int run_hierarchy_benchmark(void) {
+    static const int nodeCounts[] = { 10000, 100000, 1000000 };
+    const int children = 50;
+    const int moves = 1000;
+    int failures = 0;
+    for (uint32_t c = 0; c < SDL_arraysize(nodeCounts); c++) {
+        int nodes = nodeCounts[c];
+        NodeStore store;
+        node_store_init(&store);
+        for (int i = 0; i < nodes / 2; i++) {
+            node_add(&store, NODE_MESH_SQUARE, (float)(i % 1000) * 150.0f, (float)(i / 1000) * 150.0f, 100.0f, (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+        }
+        // Children sit in a ring around the parent, in the middle of the arrays
+        NodeHandle parent = node_add(&store, NODE_MESH_SQUARE, -500.0f, -500.0f, 100.0f, (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+        for (int i = 0; i < children; i++) {
+            float angle = (float)i * 2.0f * SDL_PI_F / children;
+            NodeHandle child = node_add(&store, NODE_MESH_TRIANGLE, SDL_cosf(angle) * 80.0f, SDL_sinf(angle) * 80.0f, 10.0f, (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+            node_set_parent(&store, child, parent);
+        }
+        for (int i = nodes / 2 + children + 1; i < nodes; i++) {
+            node_add(&store, NODE_MESH_TRIANGLE, (float)(i % 1000) * 150.0f, (float)(i / 1000) * 150.0f, 100.0f, (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+        }
+        Uint64 start = SDL_GetPerformanceCounter();
+        uint32_t full = node_store_update_transforms(&store);
+        double fullMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+        uint32_t touched = 0, worst = 0;
+        start = SDL_GetPerformanceCounter();
+        for (int m = 0; m < moves; m++) {
+            node_set_position(&store, parent, -500.0f + (float)m, -500.0f);
+            uint32_t rebuilt = node_store_update_transforms(&store);
+            touched += rebuilt;
+            worst = SDL_max(worst, rebuilt);
+        }
+        double moveNs = elapsed_ns(start, moves);
+
+        // The children must follow their parent
+        float parentPosition[2], childPosition[2];
+        node_get_world_position(&store, parent, parentPosition);
+        node_get_world_position(&store, parent + 1, childPosition);
+        bool followed = SDL_fabsf(childPosition[0] - parentPosition[0] - 80.0f) < 0.01f;
+        bool exact = touched == (uint32_t)moves * (children + 1) && worst == (uint32_t)children + 1;
+        SDL_Log("Hierarchy, %d nodes: full update %.3f ms (%u transforms), drag with %d children %.0f ns and %u transforms per move",
+                nodes, fullMs, full, children, moveNs, touched / moves);
+        if (!exact || !followed) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Hierarchy drag touched %u transforms per move (worst %u), expected %d%s",
+                         touched / moves, worst, children + 1, followed ? "" : "; children did not follow");
+            failures++;
+        }
+        node_store_destroy(&store);
+    }
+    return failures ? 1 : 0;
+}
+
+typedef enum {
+    BENCH_GRAPH_CHAIN,    // A tick node feeding a chain of one-input functions
+    BENCH_GRAPH_FAN_OUT,  // One variable feeding every other node
+    BENCH_GRAPH_DAG,      // 1% variables, then two-input functions reading one recent and one random earlier node
+    BENCH_GRAPH_SHAPES,
+} BenchGraphShape;
+
+// Build the shape; returns the node whose change drives each tick (the tick node for the chain)
+static GraphNodeHandle build_bench_graph(Graph *graph, BenchGraphShape shape, int nodes, int *variables) {
+    *variables = 0;
+    GraphNodeHandle first = GRAPH_NODE_INVALID;
+    for (int i = 0; i < nodes; i++) {
+        GraphNodeHandle node;
+        if (shape == BENCH_GRAPH_CHAIN) {
+            node = graph_add_node(graph, i == 0 ? GRAPH_NODE_TICK : GRAPH_NODE_FUNCTION, GRAPH_OP_ADD, 1);
+            if (i > 0) graph_connect(graph, node - 1, node, 0);
+        } else if (shape == BENCH_GRAPH_FAN_OUT) {
+            node = graph_add_node(graph, i == 0 ? GRAPH_NODE_VARIABLE : GRAPH_NODE_FUNCTION, GRAPH_OP_ADD, 1);
+            if (i > 0) graph_connect(graph, first, node, 0);
+        } else if (i < SDL_max(nodes / 100, 1)) {
+            node = graph_add_node(graph, GRAPH_NODE_VARIABLE, GRAPH_OP_ADD, 0);
+        } else {
+            static const GraphOp ops[] = { GRAPH_OP_ADD, GRAPH_OP_MIN, GRAPH_OP_MAX };
+            node = graph_add_node(graph, GRAPH_NODE_FUNCTION, ops[SDL_rand(3)], 2);
+            graph_connect(graph, (GraphNodeHandle)(i - 1 - SDL_rand(SDL_min(i, 1000))), node, 0);
+            graph_connect(graph, (GraphNodeHandle)SDL_rand(i), node, 1);
+        }
+        if (node == GRAPH_NODE_INVALID) return GRAPH_NODE_INVALID;
+        if (i == 0) first = node;
+        if (graph->kinds[node] == GRAPH_NODE_VARIABLE) (*variables)++;
+    }
+    return first;
+}
+
+// Tick graphs of each shape: one full evaluation, then ticks that change one input each. The
+// chain and fan-out depend entirely on their input, so each tick must evaluate every node;
+// random DAG ticks should only evaluate the changed variable's cone. Returns nonzero on a wrong count.
+static int run_graph_benchmark(void) {
+    static const int nodeCounts[] = { 100000, 1000000 };
+    static const char *shapeNames[] = { "chain", "fan-out", "random DAG" };
+    const int ticks = 100;
+    int failures = 0;
+    SDL_srand(1);
+    for (uint32_t c = 0; c < SDL_arraysize(nodeCounts); c++) {
+        int nodes = nodeCounts[c];
+        for (int shape = 0; shape < BENCH_GRAPH_SHAPES; shape++) {
+            Graph graph;
+            graph_init(&graph);
+            int variables;
+            Uint64 start = SDL_GetPerformanceCounter();
+            GraphNodeHandle driver = build_bench_graph(&graph, shape, nodes, &variables);
+            double buildMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+            if (driver == GRAPH_NODE_INVALID) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to build a %s graph of %d nodes", shapeNames[shape], nodes);
+                graph_destroy(&graph);
+                return 1;
+            }
+            // The first tick after building pays for the rebuild too
+            start = SDL_GetPerformanceCounter();
+            uint32_t full = graph_tick(&graph);
+            double fullMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency() - graph.stats.rebuildMs;
+
+            uint64_t evaluated = 0;
+            uint32_t worst = 0, fewest = UINT32_MAX;
+            start = SDL_GetPerformanceCounter();
+            for (int t = 0; t < ticks; t++) {
+                if (shape == BENCH_GRAPH_FAN_OUT) {
+                    graph_set_variable(&graph, driver, (float)t + 1.0f);
+                } else if (shape == BENCH_GRAPH_DAG) {
+                    graph_set_variable(&graph, driver + (GraphNodeHandle)SDL_rand(variables), (float)t + 1.0f);
+                }
+                uint32_t count = graph_tick(&graph);
+                evaluated += count;
+                worst = SDL_max(worst, count);
+                fewest = SDL_min(fewest, count);
+            }
+            double tickMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency() / ticks;
+
+            SDL_Log("Graph %s, %d nodes, %u edges: build %.3f ms, rebuild %.3f ms, full tick %.3f ms (%u nodes), "
+                    "tick %.3f ms evaluating %.1f nodes (%u to %u), %.1f ns per node",
+                    shapeNames[shape], nodes, graph.edgeCount, buildMs, graph.stats.rebuildMs, fullMs, full,
+                    tickMs, (double)evaluated / ticks, fewest, worst,
+                    evaluated ? tickMs * 1e6 * ticks / evaluated : 0.0);
+            bool exact = shape == BENCH_GRAPH_DAG || (fewest == (uint32_t)nodes && worst == (uint32_t)nodes);
+            if (full != (uint32_t)nodes || !exact) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Graph %s evaluated %u nodes on the full tick and %u to %u per tick, expected %d",
+                             shapeNames[shape], full, fewest, worst, nodes);
+                failures++;
+            }
+            graph_destroy(&graph);
+        }
+    }
+    return failures ? 1 : 0;
+}
+
+// One scheduler configuration of run_scheduler_benchmark: threads 0 walks the order on the
+// calling thread without a scheduler, serial runs the scheduler's serial mode
+static bool run_scheduler_config(BenchGraphShape shape, int nodes, uint32_t threads, bool serial, int ticks,
+                                 float *values, double *tickMs, uint64_t *steals) {
+    Graph graph;
+    graph_init(&graph);
+    Scheduler scheduler = {0};
+    SDL_srand(1);
+    int variables;
+    GraphNodeHandle driver = build_bench_graph(&graph, shape, nodes, &variables);
+    if (driver == GRAPH_NODE_INVALID || (threads > 0 && !scheduler_init(&scheduler, threads))) {
+        graph_destroy(&graph);
+        return false;
+    }
+    if (threads > 0) {
+        scheduler_set_serial(&scheduler, serial);
+        scheduler_attach(&scheduler, &graph);
+    }
+    graph_tick(&graph); // Pays for the rebuild
+
+    // Every tick is a full one: new variable values and every node scheduled
+    bool counted = true;
+    Uint64 total = 0;
+    for (int t = 0; t < ticks; t++) {
+        for (int v = 0; v < variables; v++) {
+            graph_set_variable(&graph, driver + (GraphNodeHandle)v, (float)(t * variables + v));
+        }
+        graph_invalidate(&graph);
+        Uint64 start = SDL_GetPerformanceCounter();
+        counted &= graph_tick(&graph) == (uint32_t)nodes;
+        total += SDL_GetPerformanceCounter() - start;
+    }
+    *tickMs = total * 1000.0 / SDL_GetPerformanceFrequency() / ticks;
+    *steals = scheduler.stats.steals;
+    memcpy(values, graph.values, (size_t)nodes * sizeof(float));
+    scheduler_destroy(&scheduler);
+    graph_destroy(&graph);
+    return counted;
+}
+
+// Full ticks of each benchmark graph shape at 1M nodes: the graph's own walk, the scheduler's
+// serial mode, then 1, 2, 4, ... threads up to maxThreads. Each configuration rebuilds the same
+// graph and must end with the same values as the walk. Returns nonzero on a mismatch.
+static int run_scheduler_benchmark(uint32_t maxThreads) {
+    static const char *shapeNames[] = { "chain", "fan-out", "random DAG" };
+    const int nodes = 1000000;
+    const int ticks = 20;
+    if (maxThreads == 0) maxThreads = (uint32_t)SDL_GetNumLogicalCPUCores();
+    maxThreads = SDL_clamp(maxThreads, 1, SCHEDULER_MAX_THREADS);
+    float *reference = malloc((size_t)nodes * sizeof(float));
+    float *values = malloc((size_t)nodes * sizeof(float));
+    if (!reference || !values) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate %d benchmark values", nodes);
+        free(reference);
+        free(values);
+        return 1;
+    }
+    int failures = 0;
+    for (int shape = 0; shape < BENCH_GRAPH_SHAPES; shape++) {
+        double walkMs, serialMs, oneMs = 0.0, ms;
+        uint64_t steals;
+        if (!run_scheduler_config(shape, nodes, 0, false, ticks, reference, &walkMs, &steals)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Graph %s walk did not evaluate every node", shapeNames[shape]);
+            failures++;
+            continue;
+        }
+        bool ok = run_scheduler_config(shape, nodes, maxThreads, true, ticks, values, &serialMs, &steals);
+        ok = ok && memcmp(values, reference, (size_t)nodes * sizeof(float)) == 0;
+        SDL_Log("Scheduler %s, %d nodes: walk %.3f ms per tick, serial mode %.3f ms%s",
+                shapeNames[shape], nodes, walkMs, serialMs, ok ? "" : ", MISMATCH");
+        failures += !ok;
+        for (uint32_t threads = 1;; threads = SDL_min(threads * 2, maxThreads)) {
+            ok = run_scheduler_config(shape, nodes, threads, false, ticks, values, &ms, &steals);
+            ok = ok && memcmp(values, reference, (size_t)nodes * sizeof(float)) == 0;
+            if (threads == 1) oneMs = ms;
+            SDL_Log("Scheduler %s, %u threads: %.3f ms per tick, %.2fx one thread, %.2fx the walk, %.0f steals per tick%s",
+                    shapeNames[shape], threads, ms, oneMs / ms, walkMs / ms, (double)steals / (ticks + 1), ok ? "" : ", MISMATCH");
+            failures += !ok;
+            if (threads == maxThreads) break;
+        }
+    }
+    free(reference);
+    free(values);
+    return failures ? 1 : 0;
+}
+
+// Every live node must hold the same value on the tape as in the graph
+static bool tape_matches(const Graph *graph, const Tape *tape) {
+    for (GraphNodeHandle node = 0; node < graph->nodeCount; node++) {
+        float expected, value;
+        if (!graph_get_value(graph, node, &expected)) continue;
+        if (!tape_get_value(tape, node, &value)) return false;
+        if (value != expected && !(value != value && expected != expected)) return false;
+    }
+    return true;
+}
+
+// Full ticks of each benchmark graph shape walked by the graph against the compiled tape, then
+// node additions and removals synced into the tape. Fails if the tape disagrees with the graph or
+// an edit needed a full compile or a graph rebuild.
+static int run_tape_benchmark(void) {
+    static const int nodeCounts[] = { 100000, 1000000 };
+    static const char *shapeNames[] = { "chain", "fan-out", "random DAG" };
+    const int ticks = 50;
+    const int edits = 100;
+    int failures = 0;
+    for (uint32_t c = 0; c < SDL_arraysize(nodeCounts); c++) {
+        int nodes = nodeCounts[c];
+        for (int shape = 0; shape < BENCH_GRAPH_SHAPES; shape++) {
+            Graph graph;
+            graph_init(&graph);
+            Tape tape;
+            SDL_srand(1);
+            int variables;
+            GraphNodeHandle driver = build_bench_graph(&graph, shape, nodes, &variables);
+            if (driver == GRAPH_NODE_INVALID || !tape_init(&tape, &graph)) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to build a %s graph tape of %d nodes", shapeNames[shape], nodes);
+                graph_destroy(&graph);
+                return 1;
+            }
+            graph_tick(&graph);
+
+            Uint64 walkTicks = 0, tapeTicks = 0;
+            for (int t = 0; t < ticks; t++) {
+                for (int v = 0; v < variables; v++) {
+                    graph_set_variable(&graph, driver + (GraphNodeHandle)v, (float)(t * variables + v));
+                }
+                graph_invalidate(&graph);
+                Uint64 start = SDL_GetPerformanceCounter();
+                graph_tick(&graph);
+                Uint64 middle = SDL_GetPerformanceCounter();
+                tape_run(&tape, (float)graph.stats.ticks);
+                walkTicks += middle - start;
+                tapeTicks += SDL_GetPerformanceCounter() - middle;
+            }
+            double walkMs = walkTicks * 1000.0 / SDL_GetPerformanceFrequency() / ticks;
+            double tapeMs = tapeTicks * 1000.0 / SDL_GetPerformanceFrequency() / ticks;
+            bool matched = tape_matches(&graph, &tape);
+
+            // One node per edit: add a function of two existing nodes, later remove a random node.
+            // Each edit is timed with its sync, graph side included.
+            uint32_t rebuilds = graph.stats.rebuilds;
+            Uint64 addTicks = 0, removeTicks = 0;
+            for (int e = 0; e < edits; e++) {
+                Uint64 start = SDL_GetPerformanceCounter();
+                GraphNodeHandle node = graph_add_node(&graph, GRAPH_NODE_FUNCTION, GRAPH_OP_ADD, 2);
+                graph_connect(&graph, (GraphNodeHandle)SDL_rand(nodes), node, 0);
+                graph_connect(&graph, (GraphNodeHandle)SDL_rand(nodes), node, 1);
+                tape_sync(&tape);
+                addTicks += SDL_GetPerformanceCounter() - start;
+            }
+            for (int e = 0; e < edits; e++) {
+                Uint64 start = SDL_GetPerformanceCounter();
+                graph_remove_node(&graph, (GraphNodeHandle)SDL_rand(nodes));
+                tape_sync(&tape);
+                removeTicks += SDL_GetPerformanceCounter() - start;
+            }
+            rebuilds = graph.stats.rebuilds - rebuilds;
+            double addUs = addTicks * 1e6 / SDL_GetPerformanceFrequency() / edits;
+            double removeUs = removeTicks * 1e6 / SDL_GetPerformanceFrequency() / edits;
+            graph_invalidate(&graph);
+            graph_tick(&graph);
+            tape_run(&tape, (float)graph.stats.ticks);
+            matched &= tape_matches(&graph, &tape);
+
+            SDL_Log("Tape %s, %d nodes: compile %.3f ms (%u instructions), walk %.3f ms, tape %.3f ms per full tick (%.1fx), "
+                    "edit and sync %.1f us per added node, %.1f us per removed node, %u full compiles, %u graph rebuilds",
+                    shapeNames[shape], nodes, tape.stats.lastCompileMs, tape.count, walkMs, tapeMs, walkMs / tapeMs,
+                    addUs, removeUs, tape.stats.compiles, rebuilds);
+            if (!matched || tape.stats.compiles != 1 || rebuilds != 0) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Tape %s: %s", shapeNames[shape],
+                             matched ? "edits were not applied incrementally" : "values differ from the graph");
+                failures++;
+            }
+            tape_destroy(&tape);
+            graph_destroy(&graph);
+        }
+    }
+    return failures ? 1 : 0;
+}
+
+// A chain ticked on the simulation thread while this thread reads snapshots at about 60 fps,
+// stalling every tenth frame, and streams increasing values into a variable. Fails if a snapshot
+// mixes two ticks, the variable ever goes backwards or the last value never arrives.
+static int run_simulation_benchmark(int seconds) {
+    const int nodes = 100000;
+    const uint32_t rate = 240;
+    Graph graph;
+    graph_init(&graph);
+    int variables;
+    GraphNodeHandle driver = build_bench_graph(&graph, BENCH_GRAPH_CHAIN, nodes, &variables);
+    GraphNodeHandle input = graph_add_node(&graph, GRAPH_NODE_VARIABLE, GRAPH_OP_ADD, 0);
+    Simulation simulation;
+    if (driver == GRAPH_NODE_INVALID || input == GRAPH_NODE_INVALID || !simulation_init(&simulation, &graph, rate, NULL, 0)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start the simulation benchmark");
+        graph_destroy(&graph);
+        return 1;
+    }
+
+    uint64_t iterations = 0, frames = 0, torn = 0, reordered = 0, firstTick = 0, lastTick = 0;
+    Uint64 firstNs = 0, lastNs = 0;
+    double totalAgeMs = 0.0, worstAgeMs = 0.0;
+    float sent = 0.0f, received = 0.0f;
+    Uint64 start = SDL_GetTicksNS();
+    Uint64 end = start + (Uint64)seconds * SDL_NS_PER_SECOND;
+    Uint64 drain = end + SDL_NS_PER_SECOND; // The last input has a second to show up
+    while (SDL_GetTicksNS() < drain && (SDL_GetTicksNS() < end || received != sent)) {
+        if (SDL_GetTicksNS() < end) {
+            SimulationInput set = { SIMULATION_INPUT_SET_VARIABLE, input, sent + 1.0f };
+            if (simulation_push_input(&simulation, &set)) sent += 1.0f;
+        }
+        const SimulationSnapshot *snapshot = simulation_acquire_snapshot(&simulation);
+        if (snapshot) {
+            float tick = snapshot->values[driver];
+            for (int i = 0; i < nodes; i++) {
+                if (snapshot->values[driver + i] != tick) {
+                    torn++;
+                    break;
+                }
+            }
+            if (snapshot->values[input] < received) reordered++;
+            received = snapshot->values[input];
+            if (!firstTick) {
+                firstTick = snapshot->tick;
+                firstNs = snapshot->publishedNs;
+            }
+            lastTick = snapshot->tick;
+            lastNs = snapshot->publishedNs;
+            totalAgeMs += simulation.stats.lastAgeMs;
+            if (simulation.stats.lastAgeMs > worstAgeMs) worstAgeMs = simulation.stats.lastAgeMs;
+            frames++;
+        }
+        SDL_Delay(++iterations % 10 ? 16 : 100);
+    }
+    double elapsed = (lastNs - firstNs) / 1e9;
+    uint64_t skipped = simulation.snapshots[simulation.front].skipped;
+    uint64_t dropped = simulation.stats.inputsDropped;
+    simulation_destroy(&simulation);
+    graph_destroy(&graph);
+
+    SDL_Log("Simulation, %d nodes at %u Hz: %.1f ticks/s over %.1f s with %llu frames read, snapshot age %.2f ms average, "
+            "%.2f ms worst, %llu ticks skipped, %.0f inputs sent, %llu refused",
+            nodes, rate, elapsed > 0.0 ? (lastTick - firstTick) / elapsed : 0.0, elapsed, (unsigned long long)frames,
+            frames ? totalAgeMs / frames : 0.0, worstAgeMs, (unsigned long long)skipped, sent, (unsigned long long)dropped);
+    if (torn || reordered || received != sent) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Simulation: %llu torn snapshots, %llu out-of-order inputs, last input %s",
+                     (unsigned long long)torn, (unsigned long long)reordered, received == sent ? "received" : "lost");
+        return 1;
+    }
+    return 0;
+}
+
+// Render a fixed number of frames offscreen and report frame cost; no window or display needed
+static int run_headless(const PresentConfig *config, int frames, const char *readbackPath, bool profile, const char *tracePath,
+                        int benchNodes, int benchLabels, int benchWires) {
+    if (!SDL_Init(0)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize SDL: %s", SDL_GetError());
+        return 1;
+    }
+    VulkanContext context = {0};
+    if (!vulkan_init_headless(config, &context, HEADLESS_WIDTH, HEADLESS_HEIGHT)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize headless Vulkan");
+        SDL_Quit();
+        return 1;
+    }
+    if (profile) profiler_set_enabled(&context.profiler, true);
+
+    bool success = true;
+    if (benchNodes > 0) {
+        success = run_thread_benchmark(&context, frames, benchNodes);
+    } else if (benchLabels > 0) {
+        success = run_text_benchmark(&context, frames, benchLabels);
+    } else if (benchWires > 0) {
+        success = run_wire_benchmark(&context, frames, benchWires);
+    } else {
+        double totalMs, worstMs;
+        Uint64 recordNs;
+        int rendered = render_headless_frames(&context, frames, &totalMs, &worstMs, &recordNs);
+        success = rendered == frames;
+        if (rendered > 0) {
+            SDL_Log("Headless: %d frames at %ux%u in %.3f ms, average %.3f ms, worst %.3f ms",
+                    rendered, context.swapchainExtent.width, context.swapchainExtent.height,
+                    totalMs, totalMs / rendered, worstMs);
+            vulkan_log_stats(&context);
+        }
+    }
+
+    if (success && readbackPath) {
+        success = vulkan_save_frame(&context, readbackPath);
+    }
+    if (profile) {
+        profiler_collect(&context.profiler);
+        profiler_write_trace(&context.profiler, tracePath ? tracePath : TRACE_FILE);
+    }
+    vulkan_cleanup(&context);
+    SDL_Quit();
+    return success ? 0 : 1;
+}
 
 int main(int argc, char *argv[]) {
+    // Parse command line; presentation defaults come from the environment
+    PresentConfig presentConfig;
+    vulkan_present_config_init(&presentConfig);
+    int benchResizeFrames = 0; // --bench-resize [frames]: resize every frame and report frame times
+    bool headless = false;     // --headless: render offscreen without a window
+    int headlessFrames = 600;  // --frames N: frames rendered in headless mode
+    const char *readbackPath = NULL; // --readback file.bmp: save the last headless frame
+    bool profile = false;      // --profile: start with the profiler enabled
+    const char *tracePath = NULL; // --trace file.json: trace written on exit (and by the T key)
+    bool continuous = false;   // --continuous: redraw every iteration instead of only when dirty
+    int benchThreadsNodes = 0; // --bench-threads [nodes]: headless record scaling over 1/2/4/8 threads
+    int benchTextLabels = 0;   // --bench-text [labels]: headless frames drawing a grid of labels
+    int benchWires = 0;        // --bench-wires [wires]: headless frames drawing wires between a grid of nodes
+    bool benchSpatial = false; // --bench-spatial: time node picking and range queries at 100k and 1M nodes
+    bool benchTransforms = false; // --bench-transforms: per-frame transform cost, AoS objects against the node store
+    bool benchHierarchy = false; // --bench-hierarchy: drag a node with 50 children, check only 51 transforms change
+    bool benchGraph = false;     // --bench-graph: tick chain, fan-out and random DAG graphs at 100k and 1M nodes
+    int benchSchedulerThreads = -1; // --bench-scheduler [threads]: full graph ticks on 1 to threads workers, 0 = all cores
+    bool benchTape = false;      // --bench-tape: full graph ticks walked against the compiled tape, plus incremental syncs
+    int benchSimulationSeconds = 0; // --bench-simulation [seconds]: simulation thread ticking under a stalling reader
+    uint32_t tickRate = SIMULATION_DEFAULT_RATE; // --tick-rate N: simulation ticks per second
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench-resize") == 0) {
+            benchResizeFrames = 600;
+            if (i + 1 < argc && argv[i + 1][0] != '-') benchResizeFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            headlessFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--readback") == 0 && i + 1 < argc) {
+            readbackPath = argv[++i];
+        } else if (strcmp(argv[i], "--present") == 0 && i + 1 < argc) {
+            if (!vulkan_parse_present_mode(argv[++i], &presentConfig.presentMode)) {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Unknown present mode '%s', expected fifo, fifo-relaxed, mailbox or immediate", argv[i]);
+            }
+        } else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc) {
+            presentConfig.framesInFlight = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pace") == 0 && i + 1 < argc) {
+            presentConfig.paceFps = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+            profile = true;
+        } else if (strcmp(argv[i], "--continuous") == 0) {
+            continuous = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            presentConfig.recordThreads = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-threads") == 0) {
+            benchThreadsNodes = 100000;
+            if (i + 1 < argc && argv[i + 1][0] != '-') benchThreadsNodes = atoi(argv[++i]);
+            headless = true;
+        } else if (strcmp(argv[i], "--bench-text") == 0) {
+            benchTextLabels = 10000;
+            if (i + 1 < argc && argv[i + 1][0] != '-') benchTextLabels = atoi(argv[++i]);
+            headless = true;
+        } else if (strcmp(argv[i], "--bench-wires") == 0) {
+            benchWires = 50000;
+            if (i + 1 < argc && argv[i + 1][0] != '-') benchWires = atoi(argv[++i]);
+            headless = true;
+        } else if (strcmp(argv[i], "--bench-spatial") == 0) {
+            benchSpatial = true;
+        } else if (strcmp(argv[i], "--bench-transforms") == 0) {
+            benchTransforms = true;
+        } else if (strcmp(argv[i], "--bench-hierarchy") == 0) {
+            benchHierarchy = true;
+        } else if (strcmp(argv[i], "--bench-graph") == 0) {
+            benchGraph = true;
+        } else if (strcmp(argv[i], "--bench-scheduler") == 0) {
+            benchSchedulerThreads = 0;
+            if (i + 1 < argc && argv[i + 1][0] != '-') benchSchedulerThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-tape") == 0) {
+            benchTape = true;
+        } else if (strcmp(argv[i], "--bench-simulation") == 0) {
+            benchSimulationSeconds = 5;
+            if (i + 1 < argc && argv[i + 1][0] != '-') benchSimulationSeconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            tickRate = (uint32_t)atoi(argv[++i]);
+        }
+    }
+    if (benchSpatial) {
+        return run_spatial_benchmark();
+    }
+    if (benchTransforms) {
+        return run_transform_benchmark();
+    }
+    if (benchHierarchy) {
+        return run_hierarchy_benchmark();
+    }
+    if (benchGraph) {
+        return run_graph_benchmark();
+    }
+    if (benchSchedulerThreads >= 0) {
+        return run_scheduler_benchmark((uint32_t)benchSchedulerThreads);
+    }
+    if (benchTape) {
+        return run_tape_benchmark();
+    }
+    if (benchSimulationSeconds > 0) {
+        return run_simulation_benchmark(benchSimulationSeconds);
+    }
+    if (headless) {
+        return run_headless(&presentConfig, headlessFrames, readbackPath, profile, tracePath, benchThreadsNodes, benchTextLabels, benchWires);
+    }
+
     // Initialize SDL
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize SDL: %s", SDL_GetError());
@@ -21,21 +871,67 @@ int main(int argc, char *argv[]) {
 
     // Initialize Vulkan
     VulkanContext context = {0};
-    if (!vulkan_init(window, &context)) {
+    if (!vulkan_init(window, &presentConfig, &context)) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize Vulkan");
         SDL_DestroyWindow(window);
         SDL_Quit();
         return 1;
     }
+    if (profile) profiler_set_enabled(&context.profiler, true);
+
+    // Simulation graph ticked on its own thread, which integrates the spin speed into the angle
+    // every tick; the snapshots carry the angle to this thread
+    Graph simulationGraph;
+    graph_init(&simulationGraph);
+    GraphNodeHandle spinSpeed = graph_add_node(&simulationGraph, GRAPH_NODE_VARIABLE, GRAPH_OP_ADD, 0);
+    GraphNodeHandle spinAngle = graph_add_node(&simulationGraph, GRAPH_NODE_VARIABLE, GRAPH_OP_ADD, 0);
+    SimulationIntegrator spin = { spinSpeed, spinAngle, 2.0f * SDL_PI_F };
+    Simulation simulation;
+    if (!simulation_init(&simulation, &simulationGraph, tickRate, &spin, 1)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start the simulation");
+        graph_destroy(&simulationGraph);
+        vulkan_cleanup(&context);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
 
     // Main loop
     bool running = true;
     SDL_Event event;
     bool dragging = false;
     vec2 dragStart = {0.0f, 0.0f};
-    int selectedObject = -1; // -1: none, 0: triangle, 1: square, 2: text
+    int selectedObject = -1; // -1: none, 1: node, 2: text
+    NodeHandle selectedNode = NODE_HANDLE_INVALID;
+    NodeHandle wireSource = NODE_HANDLE_INVALID; // Picked by the first W press
+    TextLabelHandle selectedLabel = TEXT_LABEL_INVALID;
+    NodeHandle spinNode = NODE_HANDLE_INVALID; // Rotated by the simulation, picked by the R key
+    uint64_t spinTick = 0;                     // Simulation tick last applied to spinNode
+    uint32_t spinInputs = 0;                   // Queue tail after the R key's inputs
+    Uint64 lastStatsTicks = SDL_GetTicks();
+    int benchFrame = 0;
+    double benchTotalMs = 0.0, benchWorstMs = 0.0;
 
     while (running) {
+        // Nothing to draw (or minimized): block until an event arrives instead of spinning
+        bool minimized = (SDL_GetWindowFlags(window) & SDL_WINDOW_MINIMIZED) != 0;
+        if (continuous || benchResizeFrames > 0 || spinNode != NODE_HANDLE_INVALID) vulkan_request_redraw(&context);
+        if (!context.dirty || minimized) {
+            SDL_WaitEventTimeout(NULL, IDLE_WAIT_MS);
+        }
+
+        // Sleep before sampling input so paced frames start with the freshest events
+        if (context.dirty && !minimized) vulkan_pace_frame(&context);
+        Uint64 frameStart = SDL_GetPerformanceCounter();
+        PROFILE_CPU_BEGIN(&context.profiler, "frame");
+        if (benchResizeFrames > 0) {
+            // Alternate between two sizes so every frame recreates the swapchain
+            bool large = benchFrame & 1;
+            SDL_SetWindowSize(window, large ? 800 : 600, large ? 600 : 480);
+            SDL_SyncWindow(window);
+        }
+
+        PROFILE_CPU_BEGIN(&context.profiler, "events");
         while (SDL_PollEvent(&event)) {
             switch (event.type) {
                 case SDL_EVENT_QUIT:
@@ -43,30 +939,34 @@ int main(int argc, char *argv[]) {
                     break;
                 case SDL_EVENT_WINDOW_RESIZED:
                     SDL_Log("Window resized to %dx%d", event.window.data1, event.window.data2);
+                    // Minimized windows report a zero extent; the swapchain is rebuilt once restored
+                    if (SDL_GetWindowFlags(window) & SDL_WINDOW_MINIMIZED) break;
                     if (!recreate_swapchain(&context, window)) {
                         SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to recreate swapchain, retrying");
                     }
                     break;
+                case SDL_EVENT_WINDOW_EXPOSED:
+                case SDL_EVENT_WINDOW_RESTORED:
+                    vulkan_request_redraw(&context);
+                    break;
                 case SDL_EVENT_MOUSE_BUTTON_DOWN:
                     if (event.button.button == SDL_BUTTON_LEFT) {
                         dragging = true;
                         dragStart[0] = event.button.x;
                         dragStart[1] = event.button.y;
                         // Convert screen to world coordinates
-                        float wx = (event.button.x - context.swapchainExtent.width / 2.0f) / context.camera.scale + context.camera.position[0];
-                        float wy = (event.button.y - context.swapchainExtent.height / 2.0f) / context.camera.scale + context.camera.position[1];
-                        // Check if clicking on square (simplified bounding box)
-                        float sx = context.objects[1].position[0];
-                        float sy = context.objects[1].position[1];
-                        if (wx >= sx - 0.25f && wx <= sx + 0.25f && wy >= sy - 0.25f && wy <= sy + 0.25f) {
-                            selectedObject = 1; // Square
+                        vec2 world;
+                        vulkan_screen_to_world(&context, event.button.x, event.button.y, world);
+                        float wx = world[0];
+                        float wy = world[1];
+                        // Check if clicking on a node (bounding box)
+                        selectedNode = node_pick(&context.nodes, wx, wy);
+                        if (selectedNode != NODE_HANDLE_INVALID) {
+                            selectedObject = 1; // Node
                         }
-                        // Check if clicking on text
-                        float tx = context.textContext->position[0];
-                        float ty = context.textContext->position[1];
-                        float tw = 100.0f / context.camera.scale; // Approximate text width
-                        float th = 24.0f / context.camera.scale;  // Approximate text height
-                        if (wx >= tx && wx <= tx + tw && wy >= ty && wy <= ty + th) {
+                        // Check if clicking on text, against the bounds measured when the label was laid out
+                        selectedLabel = text_label_pick(context.textContext, wx, wy);
+                        if (selectedLabel != TEXT_LABEL_INVALID) {
                             selectedObject = 2; // Text
                         }
                     } else if (event.button.button == SDL_BUTTON_MIDDLE) {
@@ -80,44 +980,150 @@ int main(int argc, char *argv[]) {
                     if (event.button.button == SDL_BUTTON_LEFT || event.button.button == SDL_BUTTON_MIDDLE) {
                         dragging = false;
                         selectedObject = -1;
+                        selectedNode = NODE_HANDLE_INVALID;
+                        selectedLabel = TEXT_LABEL_INVALID;
                     }
                     break;
                 case SDL_EVENT_MOUSE_MOTION:
                     if (dragging) {
                         float dx = (event.motion.x - dragStart[0]) / context.camera.scale;
                         float dy = (event.motion.y - dragStart[1]) / context.camera.scale;
-                        if (selectedObject == 1) { // Dragging square
-                            context.objects[1].position[0] += dx;
-                            context.objects[1].position[1] += dy;
-                            glm_translate_make(context.objects[1].modelMatrix, (vec3){context.objects[1].position[0], context.objects[1].position[1], 0.0f});
+                        float nodePosition[2];
+                        if (selectedObject == 1 && node_get_position(&context.nodes, selectedNode, nodePosition)) { // Dragging node
+                            node_set_position(&context.nodes, selectedNode, nodePosition[0] + dx, nodePosition[1] + dy);
                         } else if (selectedObject == 2) { // Dragging text
-                            context.textContext->position[0] += dx;
-                            context.textContext->position[1] += dy;
-                            glm_translate_make(context.textContext->modelMatrix, (vec3){context.textContext->position[0], context.textContext->position[1], 0.0f});
+                            float labelPosition[2];
+                            if (text_label_get_position(context.textContext, selectedLabel, labelPosition)) {
+                                text_label_set_position(context.textContext, selectedLabel,
+                                                        labelPosition[0] + dx, labelPosition[1] + dy);
+                            }
                         } else if (selectedObject == -1) { // Panning
                             context.camera.position[0] -= dx;
                             context.camera.position[1] -= dy;
                         }
                         dragStart[0] = event.motion.x;
                         dragStart[1] = event.motion.y;
+                        vulkan_request_redraw(&context);
+                    }
+                    break;
+                case SDL_EVENT_KEY_DOWN:
+                    if (event.key.key == SDLK_M) { // Dump device memory usage
+                        memory_log_stats(&context.allocator);
+                    }
+                    if (event.key.key == SDLK_P) { // Toggle the profiler
+                        profiler_set_enabled(&context.profiler, !context.profiler.enabled);
+                    }
+                    if (event.key.key == SDLK_T) { // Write the profiler ring as a Chrome trace
+                        vkDeviceWaitIdle(context.device);
+                        profiler_collect(&context.profiler);
+                        profiler_write_trace(&context.profiler, tracePath ? tracePath : TRACE_FILE);
+                    }
+                    if (event.key.key == SDLK_N || event.key.key == SDLK_C || event.key.key == SDLK_W || event.key.key == SDLK_R ||
+                        event.key.key == SDLK_DELETE) {
+                        float mx, my;
+                        vec2 world;
+                        SDL_GetMouseState(&mx, &my);
+                        vulkan_screen_to_world(&context, mx, my, world);
+                        if (event.key.key == SDLK_N) { // Add a node under the cursor
+                            NodeMesh mesh = (event.key.mod & SDL_KMOD_SHIFT) ? NODE_MESH_TRIANGLE : NODE_MESH_SQUARE;
+                            node_add(&context.nodes, mesh, world[0], world[1], 100.0f, (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+                        } else if (event.key.key == SDLK_C) { // Attach a small child node to the node under the cursor
+                            NodeHandle hovered = node_pick(&context.nodes, world[0], world[1]);
+                            float parentPosition[2];
+                            if (node_get_world_position(&context.nodes, hovered, parentPosition)) {
+                                NodeHandle child = node_add(&context.nodes, NODE_MESH_TRIANGLE, world[0] - parentPosition[0],
+                                                            world[1] - parentPosition[1], 25.0f, (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+                                node_set_parent(&context.nodes, child, hovered);
+                            }
+                        } else if (event.key.key == SDLK_W) { // First press picks the source node, the second connects it
+                            NodeHandle hovered = node_pick(&context.nodes, world[0], world[1]);
+                            if (wireSource == NODE_HANDLE_INVALID) {
+                                wireSource = hovered;
+                            } else {
+                                wire_add(context.wireContext, wireSource, hovered, WIRE_DEFAULT_WIDTH, (float[4]){0.9f, 0.7f, 0.2f, 1.0f});
+                                wireSource = NODE_HANDLE_INVALID;
+                            }
+                        } else if (event.key.key == SDLK_R) { // Spin the node under the cursor, or stop spinning over empty space
+                            spinNode = node_pick(&context.nodes, world[0], world[1]);
+                            // Spinning starts from the node's current rotation
+                            float angle;
+                            if (!node_get_rotation(&context.nodes, spinNode, &angle)) angle = 0.0f;
+                            SimulationInput start = { SIMULATION_INPUT_SET_VARIABLE, spinAngle, angle };
+                            SimulationInput speed = { SIMULATION_INPUT_SET_VARIABLE, spinSpeed,
+                                                      spinNode != NODE_HANDLE_INVALID ? SPIN_SPEED : 0.0f };
+                            if (!simulation_push_input(&simulation, &start) || !simulation_push_input(&simulation, &speed)) {
+                                spinNode = NODE_HANDLE_INVALID;
+                            }
+                            spinInputs = (uint32_t)SDL_GetAtomicInt(&simulation.inputs.tail);
+                        } else { // Remove the node under the cursor, and its wires with it
+                            NodeHandle hovered = node_pick(&context.nodes, world[0], world[1]);
+                            if (hovered == selectedNode) selectedNode = NODE_HANDLE_INVALID;
+                            if (hovered == wireSource) wireSource = NODE_HANDLE_INVALID;
+                            if (hovered == spinNode) spinNode = NODE_HANDLE_INVALID;
+                            node_remove(&context.nodes, hovered);
+                        }
+                        vulkan_request_redraw(&context);
                     }
                     break;
                 case SDL_EVENT_MOUSE_WHEEL:
                     context.camera.scale += event.wheel.y * 0.1f;
                     if (context.camera.scale < 0.1f) context.camera.scale = 0.1f; // Minimum zoom
                     if (context.camera.scale > 10.0f) context.camera.scale = 10.0f; // Maximum zoom
+                    vulkan_request_redraw(&context);
                     break;
             }
         }
+        PROFILE_CPU_END(&context.profiler);
 
-        if (!vulkan_render(&context)) {
+        // Latest finished tick; the simulation never waits for the frame, nor the frame for it
+        const SimulationSnapshot *snapshot = simulation_acquire_snapshot(&simulation);
+        // Ticks that had not drained the R key's inputs still hold the previous node's angle
+        if (snapshot && spinNode != NODE_HANDLE_INVALID && snapshot->tick != spinTick &&
+            (int32_t)(snapshot->inputs - spinInputs) >= 0) {
+            node_set_rotation(&context.nodes, spinNode, snapshot->values[spinAngle]);
+            spinTick = snapshot->tick;
+        }
+
+        // Events may have minimized the window; a zero extent has no swapchain to render into
+        minimized = (SDL_GetWindowFlags(window) & SDL_WINDOW_MINIMIZED) != 0;
+        if (!context.dirty || minimized) {
+            context.stats.framesSkipped++;
+        } else if (!vulkan_render(&context)) {
             if (!recreate_swapchain(&context, window)) {
                 SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to recreate swapchain, retrying");
             }
         }
+
+        if (benchResizeFrames > 0) {
+            double frameMs = (SDL_GetPerformanceCounter() - frameStart) * 1000.0 / SDL_GetPerformanceFrequency();
+            benchTotalMs += frameMs;
+            if (frameMs > benchWorstMs) benchWorstMs = frameMs;
+            if (++benchFrame == benchResizeFrames) {
+                SDL_Log("Resize benchmark: %d frames, average %.3f ms, worst %.3f ms",
+                        benchFrame, benchTotalMs / benchFrame, benchWorstMs);
+                running = false;
+            }
+        }
+
+        PROFILE_CPU_END(&context.profiler);
+
+        // Log render stats once per second
+        if (SDL_GetTicks() - lastStatsTicks >= 1000) {
+            vulkan_log_stats(&context);
+            simulation_log_stats(&simulation);
+            lastStatsTicks = SDL_GetTicks();
+        }
+    }
+
+    if (tracePath) {
+        vkDeviceWaitIdle(context.device);
+        profiler_collect(&context.profiler);
+        profiler_write_trace(&context.profiler, tracePath);
     }
 
     // Cleanup
+    simulation_destroy(&simulation);
+    graph_destroy(&simulationGraph);
     vulkan_cleanup(&context);
     SDL_DestroyWindow(window);
     SDL_Quit();
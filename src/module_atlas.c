@@ -0,0 +1,246 @@
+// module_atlas.c
+#include "module_atlas.h"
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t key_hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return (uint32_t)key & (ATLAS_HASH_BUCKETS - 1);
+}
+
+static void lru_unlink(GlyphAtlas *atlas, uint32_t index) {
+    AtlasEntry *entry = &atlas->entries[index];
+    if (entry->lruPrev != ATLAS_ENTRY_INVALID) atlas->entries[entry->lruPrev].lruNext = entry->lruNext;
+    else atlas->lruHead = entry->lruNext;
+    if (entry->lruNext != ATLAS_ENTRY_INVALID) atlas->entries[entry->lruNext].lruPrev = entry->lruPrev;
+    else atlas->lruTail = entry->lruPrev;
+}
+
+static void lru_append(GlyphAtlas *atlas, uint32_t index) {
+    AtlasEntry *entry = &atlas->entries[index];
+    entry->lruPrev = atlas->lruTail;
+    entry->lruNext = ATLAS_ENTRY_INVALID;
+    if (atlas->lruTail != ATLAS_ENTRY_INVALID) atlas->entries[atlas->lruTail].lruNext = index;
+    else atlas->lruHead = index;
+    atlas->lruTail = index;
+}
+
+// Take cellWidth columns from the first span of the shelf wide enough; false when none is
+static bool shelf_take(AtlasShelf *shelf, uint32_t cellWidth, uint32_t *x) {
+    for (uint32_t i = 0; i < shelf->freeCount; i++) {
+        AtlasSpan *span = &shelf->free[i];
+        if (span->width < cellWidth) continue;
+        *x = span->x;
+        span->x += cellWidth;
+        span->width -= cellWidth;
+        if (span->width == 0) {
+            memmove(span, span + 1, (shelf->freeCount - i - 1) * sizeof(AtlasSpan));
+            shelf->freeCount--;
+        }
+        shelf->glyphCount++;
+        return true;
+    }
+    return false;
+}
+
+// Return columns to the shelf, merging with the spans on either side. Columns that cannot get
+// a span of their own (out of memory) come back when the shelf empties.
+static void shelf_give(AtlasShelf *shelf, uint32_t x, uint32_t cellWidth) {
+    if (--shelf->glyphCount == 0) {
+        shelf->free[0] = (AtlasSpan){ 0, ATLAS_SIZE };
+        shelf->freeCount = 1;
+        return;
+    }
+    uint32_t i = 0;
+    while (i < shelf->freeCount && shelf->free[i].x < x) i++;
+    bool mergeLeft = i > 0 && shelf->free[i - 1].x + shelf->free[i - 1].width == x;
+    bool mergeRight = i < shelf->freeCount && x + cellWidth == shelf->free[i].x;
+    if (mergeLeft && mergeRight) {
+        shelf->free[i - 1].width += cellWidth + shelf->free[i].width;
+        memmove(&shelf->free[i], &shelf->free[i + 1], (shelf->freeCount - i - 1) * sizeof(AtlasSpan));
+        shelf->freeCount--;
+    } else if (mergeLeft) {
+        shelf->free[i - 1].width += cellWidth;
+    } else if (mergeRight) {
+        shelf->free[i].x = x;
+        shelf->free[i].width += cellWidth;
+    } else {
+        if (shelf->freeCount == shelf->freeCapacity) {
+            uint32_t capacity = shelf->freeCapacity ? shelf->freeCapacity * 2 : 8;
+            AtlasSpan *spans = realloc(shelf->free, capacity * sizeof(AtlasSpan));
+            if (!spans) return;
+            shelf->free = spans;
+            shelf->freeCapacity = capacity;
+        }
+        memmove(&shelf->free[i + 1], &shelf->free[i], (shelf->freeCount - i) * sizeof(AtlasSpan));
+        shelf->free[i] = (AtlasSpan){ x, cellWidth };
+        shelf->freeCount++;
+    }
+}
+
+static bool open_shelf(GlyphAtlas *atlas, uint32_t height) {
+    if (atlas->shelfTop + height > ATLAS_SIZE) return false;
+    if (atlas->shelfCount == atlas->shelfCapacity) {
+        uint32_t capacity = atlas->shelfCapacity ? atlas->shelfCapacity * 2 : 16;
+        AtlasShelf *shelves = realloc(atlas->shelves, capacity * sizeof(AtlasShelf));
+        if (!shelves) return false;
+        atlas->shelves = shelves;
+        atlas->shelfCapacity = capacity;
+    }
+    AtlasShelf *shelf = &atlas->shelves[atlas->shelfCount];
+    memset(shelf, 0, sizeof(AtlasShelf));
+    shelf->free = malloc(8 * sizeof(AtlasSpan));
+    if (!shelf->free) return false;
+    shelf->freeCapacity = 8;
+    shelf->free[0] = (AtlasSpan){ 0, ATLAS_SIZE };
+    shelf->freeCount = 1;
+    shelf->y = atlas->shelfTop;
+    shelf->height = height;
+    atlas->shelfTop += height;
+    atlas->shelfCount++;
+    return true;
+}
+
+// Best height fit among shelves at most twice the cell's height, then a new shelf, then any
+// shelf tall enough; a cell alone on a much taller shelf would strand the rest of its height
+static bool alloc_cell(GlyphAtlas *atlas, uint32_t cellWidth, uint32_t cellHeight, uint32_t *shelfIndex, uint32_t *x) {
+    uint32_t rounded = (cellHeight + ATLAS_SHELF_ROUNDING - 1) / ATLAS_SHELF_ROUNDING * ATLAS_SHELF_ROUNDING;
+    for (int pass = 0; pass < 2; pass++) {
+        uint32_t limit = pass == 0 ? rounded * 2 : ATLAS_SIZE;
+        uint32_t best = ATLAS_ENTRY_INVALID;
+        for (uint32_t s = 0; s < atlas->shelfCount; s++) {
+            const AtlasShelf *shelf = &atlas->shelves[s];
+            if (shelf->height < cellHeight || shelf->height > limit) continue;
+            if (best != ATLAS_ENTRY_INVALID && shelf->height >= atlas->shelves[best].height) continue;
+            for (uint32_t i = 0; i < shelf->freeCount; i++) {
+                if (shelf->free[i].width >= cellWidth) {
+                    best = s;
+                    break;
+                }
+            }
+        }
+        if (best != ATLAS_ENTRY_INVALID) {
+            *shelfIndex = best;
+            return shelf_take(&atlas->shelves[best], cellWidth, x);
+        }
+        if (pass == 0 && open_shelf(atlas, rounded)) {
+            *shelfIndex = atlas->shelfCount - 1;
+            return shelf_take(&atlas->shelves[*shelfIndex], cellWidth, x);
+        }
+    }
+    return false;
+}
+
+static void evict(GlyphAtlas *atlas, uint32_t index) {
+    AtlasEntry *entry = &atlas->entries[index];
+    uint32_t *link = &atlas->buckets[key_hash(entry->key)];
+    while (*link != index) link = &atlas->entries[*link].hashNext;
+    *link = entry->hashNext;
+    lru_unlink(atlas, index);
+
+    if (entry->width > 0) {
+        uint32_t cellWidth = entry->width + 2 * ATLAS_PADDING;
+        uint32_t cellX = entry->x - ATLAS_PADDING;
+        shelf_give(&atlas->shelves[entry->shelf], cellX, cellWidth);
+        atlas->usedTexels -= (uint64_t)cellWidth * (entry->height + 2 * ATLAS_PADDING);
+        // Emptied shelves at the top give their rows back, so a later shelf may take another height
+        while (atlas->shelfCount > 0 && atlas->shelves[atlas->shelfCount - 1].glyphCount == 0) {
+            AtlasShelf *top = &atlas->shelves[--atlas->shelfCount];
+            atlas->shelfTop = top->y;
+            free(top->free);
+        }
+    }
+
+    entry->hashNext = atlas->freeEntry;
+    atlas->freeEntry = index;
+    atlas->count--;
+    atlas->stats.evictions++;
+}
+
+void atlas_init(GlyphAtlas *atlas) {
+    memset(atlas, 0, sizeof(GlyphAtlas));
+    for (uint32_t b = 0; b < ATLAS_HASH_BUCKETS; b++) atlas->buckets[b] = ATLAS_ENTRY_INVALID;
+    for (uint32_t e = 0; e < ATLAS_MAX_ENTRIES; e++) {
+        atlas->entries[e].hashNext = e + 1 < ATLAS_MAX_ENTRIES ? e + 1 : ATLAS_ENTRY_INVALID;
+    }
+    atlas->freeEntry = 0;
+    atlas->lruHead = ATLAS_ENTRY_INVALID;
+    atlas->lruTail = ATLAS_ENTRY_INVALID;
+}
+
+void atlas_destroy(GlyphAtlas *atlas) {
+    for (uint32_t s = 0; s < atlas->shelfCount; s++) free(atlas->shelves[s].free);
+    free(atlas->shelves);
+    memset(atlas, 0, sizeof(GlyphAtlas));
+}
+
+void atlas_begin_frame(GlyphAtlas *atlas) {
+    atlas->frame++;
+}
+
+const AtlasEntry *atlas_lookup(GlyphAtlas *atlas, uint64_t key) {
+    for (uint32_t index = atlas->buckets[key_hash(key)]; index != ATLAS_ENTRY_INVALID; index = atlas->entries[index].hashNext) {
+        AtlasEntry *entry = &atlas->entries[index];
+        if (entry->key != key) continue;
+        if (entry->lastUsed != atlas->frame) {
+            entry->lastUsed = atlas->frame;
+            lru_unlink(atlas, index);
+            lru_append(atlas, index);
+        }
+        atlas->stats.hits++;
+        return entry;
+    }
+    atlas->stats.misses++;
+    return NULL;
+}
+
+const AtlasEntry *atlas_insert(GlyphAtlas *atlas, uint64_t key, const FontGlyph *glyph, uint32_t width, uint32_t height) {
+    uint32_t cellWidth = width > 0 ? width + 2 * ATLAS_PADDING : 0;
+    uint32_t cellHeight = height > 0 ? height + 2 * ATLAS_PADDING : 0;
+    if (cellWidth > ATLAS_SIZE || cellHeight > ATLAS_SIZE) return NULL;
+
+    // The least recently used entry goes first; once it was drawn this frame, so was everything after it
+    if (atlas->freeEntry == ATLAS_ENTRY_INVALID) {
+        if (atlas->lruHead == ATLAS_ENTRY_INVALID || atlas->entries[atlas->lruHead].lastUsed == atlas->frame) return NULL;
+        evict(atlas, atlas->lruHead);
+    }
+    uint32_t shelf = 0, cellX = 0;
+    while (cellWidth > 0 && !alloc_cell(atlas, cellWidth, cellHeight, &shelf, &cellX)) {
+        if (atlas->lruHead == ATLAS_ENTRY_INVALID || atlas->entries[atlas->lruHead].lastUsed == atlas->frame) return NULL;
+        evict(atlas, atlas->lruHead);
+    }
+
+    uint32_t index = atlas->freeEntry;
+    AtlasEntry *entry = &atlas->entries[index];
+    atlas->freeEntry = entry->hashNext;
+    entry->key = key;
+    entry->glyph = *glyph;
+    entry->width = width;
+    entry->height = height;
+    entry->shelf = shelf;
+    entry->lastUsed = atlas->frame;
+    if (cellWidth > 0) {
+        entry->x = cellX + ATLAS_PADDING;
+        entry->y = atlas->shelves[shelf].y + ATLAS_PADDING;
+        entry->glyph.u0 = (float)entry->x / ATLAS_SIZE;
+        entry->glyph.v0 = (float)entry->y / ATLAS_SIZE;
+        entry->glyph.u1 = (float)(entry->x + width) / ATLAS_SIZE;
+        entry->glyph.v1 = (float)(entry->y + height) / ATLAS_SIZE;
+        atlas->usedTexels += (uint64_t)cellWidth * cellHeight;
+    } else {
+        entry->x = entry->y = 0;
+    }
+    uint32_t *bucket = &atlas->buckets[key_hash(key)];
+    entry->hashNext = *bucket;
+    *bucket = index;
+    lru_append(atlas, index);
+    atlas->count++;
+    return entry;
+}
+
+float atlas_occupancy(const GlyphAtlas *atlas) {
+    return (float)((double)atlas->usedTexels / ((double)ATLAS_SIZE * ATLAS_SIZE));
+}
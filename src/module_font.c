@@ -0,0 +1,342 @@
+// module_font.c
+#include "module_font.h"
+#include <stdlib.h>
+#include <string.h>
+#include FT_MODULE_H
+#include FT_OUTLINE_H
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define FONT_INITIAL_METRICS 256 // Power of two
+
+// Map a whole file read-only; FreeType reads the face straight out of the mapping
+static bool map_file(const char *path, void **data, size_t *size) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER length;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &length) && length.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    CloseHandle(file);
+    if (!mapping) return false;
+    // The view keeps the mapping alive
+    *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    *size = (size_t)length.QuadPart;
+    return *data != NULL;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    void *mapped = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // The mapping outlives the descriptor
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+    *data = mapped;
+    *size = (size_t)info.st_size;
+    return true;
+#endif
+}
+
+static void unmap_file(void *data, size_t size) {
+    if (!data) return;
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+// Release what open_face created; the slot keeps its id, path and state
+static void close_face(Font *font) {
+    free(font->metrics);
+    if (font->face) FT_Done_Face(font->face);
+    if (font->library) FT_Done_FreeType(font->library);
+    unmap_file(font->data, font->size);
+    font->metrics = NULL;
+    font->metricsCapacity = 0;
+    font->metricsCount = 0;
+    font->face = NULL;
+    font->library = NULL;
+    font->data = NULL;
+    font->size = 0;
+}
+
+// Parse one face. Touches nothing but font, so the preload thread runs it too.
+static bool open_face(Font *font) {
+    Uint64 start = SDL_GetTicksNS();
+    if (!map_file(font->path, &font->data, &font->size)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map font %s", font->path);
+        return false;
+    }
+    if (FT_Init_FreeType(&font->library) != 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize FreeType");
+        close_face(font);
+        return false;
+    }
+    if (FT_New_Memory_Face(font->library, font->data, (FT_Long)font->size, 0, &font->face) != 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load font %s", font->path);
+        close_face(font);
+        return false;
+    }
+    font->metrics = calloc(FONT_INITIAL_METRICS, sizeof(FontMetricsSlot));
+    if (!font->metrics) {
+        close_face(font);
+        return false;
+    }
+    font->metricsCapacity = FONT_INITIAL_METRICS;
+    FT_Int spread = FONT_SDF_SPREAD;
+    FT_Property_Set(font->library, "sdf", "spread", &spread);
+    FT_Set_Pixel_Sizes(font->face, 0, FONT_SDF_SIZE);
+    font->ascent = font->face->size->metrics.ascender / 64.0f;
+    font->lineHeight = font->face->size->metrics.height / 64.0f;
+    SDL_Log("Font %u %s: %ld glyphs, %zu bytes mapped, SDF at %upx, parsed in %.3f ms", font->id, font->path,
+            font->face->num_glyphs, font->size, FONT_SDF_SIZE, (SDL_GetTicksNS() - start) / 1e6);
+    return true;
+}
+
+static int SDLCALL preload_main(void *userData) {
+    FontManager *manager = userData;
+    for (uint32_t i = manager->preloadFirst; i < manager->preloadEnd; i++) {
+        Font *font = &manager->fonts[i];
+        bool loaded = open_face(font);
+        SDL_LockMutex(manager->mutex);
+        font->state = loaded ? FONT_STATE_READY : FONT_STATE_FAILED;
+        SDL_BroadcastCondition(manager->loaded);
+        SDL_UnlockMutex(manager->mutex);
+    }
+    return 0;
+}
+
+static FontState wait_font(FontManager *manager, FontId id) {
+    Font *font = &manager->fonts[id];
+    SDL_LockMutex(manager->mutex);
+    while (font->state == FONT_STATE_PENDING) SDL_WaitCondition(manager->loaded, manager->mutex);
+    FontState state = font->state;
+    SDL_UnlockMutex(manager->mutex);
+    return state;
+}
+
+static FontId find_font(const FontManager *manager, const char *path) {
+    for (uint32_t i = 0; i < manager->count; i++) {
+        if (strcmp(manager->fonts[i].path, path) == 0) return i;
+    }
+    return FONT_ID_INVALID;
+}
+
+// Claim the next slot for path; the caller opens the face or hands it to the preload thread
+static Font *register_font(FontManager *manager, const char *path) {
+    if (manager->count == FONT_MAX_FONTS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Font limit of %u reached, cannot load %s", FONT_MAX_FONTS, path);
+        return NULL;
+    }
+    char *copy = SDL_strdup(path);
+    if (!copy) return NULL;
+    Font *font = &manager->fonts[manager->count];
+    memset(font, 0, sizeof(Font));
+    font->id = manager->count++;
+    font->path = copy;
+    font->state = FONT_STATE_PENDING;
+    return font;
+}
+
+bool font_manager_init(FontManager *manager) {
+    memset(manager, 0, sizeof(FontManager));
+    manager->mutex = SDL_CreateMutex();
+    manager->loaded = SDL_CreateCondition();
+    if (!manager->mutex || !manager->loaded) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create font manager lock: %s", SDL_GetError());
+        font_manager_destroy(manager);
+        return false;
+    }
+    return true;
+}
+
+void font_manager_destroy(FontManager *manager) {
+    if (manager->loader) SDL_WaitThread(manager->loader, NULL);
+    for (uint32_t i = 0; i < manager->count; i++) {
+        close_face(&manager->fonts[i]);
+        SDL_free(manager->fonts[i].path);
+    }
+    if (manager->loaded) SDL_DestroyCondition(manager->loaded);
+    if (manager->mutex) SDL_DestroyMutex(manager->mutex);
+    memset(manager, 0, sizeof(FontManager));
+}
+
+FontId font_manager_load(FontManager *manager, const char *path) {
+    FontId id = find_font(manager, path);
+    if (id != FONT_ID_INVALID) {
+        return wait_font(manager, id) == FONT_STATE_READY ? id : FONT_ID_INVALID;
+    }
+    Font *font = register_font(manager, path);
+    if (!font) return FONT_ID_INVALID;
+    // The slot is outside any preload range, so no other thread looks at it
+    font->state = open_face(font) ? FONT_STATE_READY : FONT_STATE_FAILED;
+    font->available = font->state == FONT_STATE_READY;
+    return font->available ? font->id : FONT_ID_INVALID;
+}
+
+bool font_manager_preload(FontManager *manager, const char *const *paths, uint32_t count, FontId *ids) {
+    // One preload at a time; its range must stay fixed while the thread walks it
+    if (manager->loader) {
+        SDL_WaitThread(manager->loader, NULL);
+        manager->loader = NULL;
+    }
+    uint32_t first = manager->count;
+    bool success = true;
+    for (uint32_t i = 0; i < count; i++) {
+        ids[i] = find_font(manager, paths[i]);
+        if (ids[i] != FONT_ID_INVALID) continue;
+        Font *font = register_font(manager, paths[i]);
+        ids[i] = font ? font->id : FONT_ID_INVALID;
+        success = success && font;
+    }
+    if (manager->count == first) return success;
+
+    manager->preloadFirst = first;
+    manager->preloadEnd = manager->count;
+    manager->loader = SDL_CreateThread(preload_main, "font preload", manager);
+    if (!manager->loader) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to start font preload thread, loading fonts now: %s", SDL_GetError());
+        preload_main(manager);
+    }
+    return success;
+}
+
+Font *font_manager_get(FontManager *manager, FontId id) {
+    if (id >= manager->count) return NULL;
+    Font *font = &manager->fonts[id];
+    if (font->available) return font;
+    SDL_LockMutex(manager->mutex);
+    bool ready = font->state == FONT_STATE_READY;
+    SDL_UnlockMutex(manager->mutex);
+    // The lock ordered the loader's writes before this read; later calls skip it
+    font->available = ready;
+    return ready ? font : NULL;
+}
+
+FontState font_manager_state(FontManager *manager, FontId id) {
+    if (id >= manager->count) return FONT_STATE_FAILED;
+    SDL_LockMutex(manager->mutex);
+    FontState state = manager->fonts[id].state;
+    SDL_UnlockMutex(manager->mutex);
+    return state;
+}
+
+static uint32_t metrics_hash(uint32_t codepoint) {
+    codepoint *= 0x9e3779b1u;
+    return codepoint ^ (codepoint >> 16);
+}
+
+static FontMetricsSlot *find_metrics(const Font *font, uint32_t codepoint) {
+    uint32_t mask = font->metricsCapacity - 1;
+    for (uint32_t i = metrics_hash(codepoint) & mask;; i = (i + 1) & mask) {
+        FontMetricsSlot *slot = &font->metrics[i];
+        if (!slot->used) return NULL;
+        if (slot->codepoint == codepoint) return slot;
+    }
+}
+
+// Keep the load factor at or below one half; a failed grow only leaves the glyph uncached
+static void store_metrics(Font *font, uint32_t codepoint, const FontGlyph *glyph) {
+    if ((font->metricsCount + 1) * 2 > font->metricsCapacity) {
+        uint32_t capacity = font->metricsCapacity * 2;
+        FontMetricsSlot *metrics = calloc(capacity, sizeof(FontMetricsSlot));
+        if (!metrics) return;
+        for (uint32_t s = 0; s < font->metricsCapacity; s++) {
+            if (!font->metrics[s].used) continue;
+            uint32_t i = metrics_hash(font->metrics[s].codepoint) & (capacity - 1);
+            while (metrics[i].used) i = (i + 1) & (capacity - 1);
+            metrics[i] = font->metrics[s];
+        }
+        free(font->metrics);
+        font->metrics = metrics;
+        font->metricsCapacity = capacity;
+    }
+    uint32_t mask = font->metricsCapacity - 1;
+    uint32_t i = metrics_hash(codepoint) & mask;
+    while (font->metrics[i].used) i = (i + 1) & mask;
+    font->metrics[i] = (FontMetricsSlot){ codepoint, *glyph, true };
+    font->metricsCount++;
+}
+
+// Quad the SDF renderer will produce for the loaded outline: its control box grown to whole
+// pixels, plus the spread on each side
+static void outline_metrics(FT_GlyphSlot slot, FontGlyph *glyph) {
+    FT_BBox box;
+    FT_Outline_Get_CBox(&slot->outline, &box);
+    glyph->x0 = SDL_floorf(box.xMin / 64.0f) - FONT_SDF_SPREAD;
+    glyph->x1 = SDL_ceilf(box.xMax / 64.0f) + FONT_SDF_SPREAD;
+    glyph->y0 = -SDL_ceilf(box.yMax / 64.0f) - FONT_SDF_SPREAD;
+    glyph->y1 = -SDL_floorf(box.yMin / 64.0f) + FONT_SDF_SPREAD;
+}
+
+bool font_glyph_metrics(Font *font, uint32_t codepoint, FontGlyph *glyph) {
+    const FontMetricsSlot *slot = find_metrics(font, codepoint);
+    if (slot) {
+        *glyph = slot->glyph;
+        return true;
+    }
+    memset(glyph, 0, sizeof(FontGlyph));
+    FT_GlyphSlot loaded = font->face->glyph;
+    if (FT_Load_Char(font->face, codepoint, FT_LOAD_DEFAULT) != 0) return false;
+    glyph->advance = loaded->advance.x / 64.0f;
+    if (loaded->format != FT_GLYPH_FORMAT_OUTLINE || loaded->outline.n_points == 0) {
+        glyph->empty = true;
+    } else {
+        outline_metrics(loaded, glyph);
+    }
+    store_metrics(font, codepoint, glyph);
+    return true;
+}
+
+bool font_render_glyph(Font *font, uint32_t codepoint, FontGlyph *glyph, FontBitmap *bitmap) {
+    memset(glyph, 0, sizeof(FontGlyph));
+    memset(bitmap, 0, sizeof(FontBitmap));
+    FT_GlyphSlot slot = font->face->glyph;
+    if (FT_Load_Char(font->face, codepoint, FT_LOAD_DEFAULT) != 0) return false;
+    glyph->advance = slot->advance.x / 64.0f;
+    if (slot->format != FT_GLYPH_FORMAT_OUTLINE || slot->outline.n_points == 0 ||
+        FT_Render_Glyph(slot, FT_RENDER_MODE_SDF) != 0 || slot->bitmap.width == 0 || slot->bitmap.rows == 0) {
+        glyph->empty = true;
+    } else {
+        bitmap->pixels = slot->bitmap.buffer;
+        bitmap->width = slot->bitmap.width;
+        bitmap->height = slot->bitmap.rows;
+        bitmap->pitch = slot->bitmap.pitch;
+        glyph->x0 = (float)slot->bitmap_left;
+        glyph->y0 = (float)-slot->bitmap_top;
+        glyph->x1 = glyph->x0 + bitmap->width;
+        glyph->y1 = glyph->y0 + bitmap->height;
+    }
+    // The rendered bitmap is authoritative over the outline estimate
+    FontMetricsSlot *cached = find_metrics(font, codepoint);
+    if (cached) {
+        cached->glyph = *glyph;
+    } else {
+        store_metrics(font, codepoint, glyph);
+    }
+    return true;
+}
+
+float font_kerning(const Font *font, uint32_t left, uint32_t right) {
+    if (!FT_HAS_KERNING(font->face)) return 0.0f;
+    FT_Vector delta;
+    if (FT_Get_Kerning(font->face, FT_Get_Char_Index(font->face, left), FT_Get_Char_Index(font->face, right),
+                       FT_KERNING_DEFAULT, &delta) != 0) {
+        return 0.0f;
+    }
+    return delta.x / 64.0f;
+}
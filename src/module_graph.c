@@ -0,0 +1,481 @@
+// module_graph.c
+#include "module_graph.h"
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GROW_ARRAY(array, capacity) do { \
+        void *grown = realloc((array), (capacity) * sizeof(*(array))); \
+        if (!grown) return false; \
+        (array) = grown; \
+    } while (0)
+
+void graph_init(Graph *graph) {
+    memset(graph, 0, sizeof(Graph));
+    graph->freeNode = GRAPH_NODE_INVALID;
+}
+
+void graph_destroy(Graph *graph) {
+    free(graph->kinds);
+    free(graph->ops);
+    free(graph->flags);
+    free(graph->values);
+    free(graph->portBase);
+    free(graph->portCounts);
+    free(graph->ranks);
+    free(graph->inputSources);
+    free(graph->outputOffsets);
+    free(graph->outputTargets);
+    free(graph->outputLogHead);
+    free(graph->outputLogTargets);
+    free(graph->outputLogNext);
+    free(graph->order);
+    free(graph->tickNodes);
+    free(graph->pending);
+    free(graph->heap);
+    free(graph->scratch);
+    graph_init(graph);
+}
+
+static bool grow_nodes(Graph *graph) {
+    uint32_t capacity = graph->nodeCapacity ? graph->nodeCapacity * 2 : 64;
+    GROW_ARRAY(graph->kinds, capacity);
+    GROW_ARRAY(graph->ops, capacity);
+    GROW_ARRAY(graph->flags, capacity);
+    GROW_ARRAY(graph->values, capacity);
+    GROW_ARRAY(graph->portBase, capacity);
+    GROW_ARRAY(graph->portCounts, capacity);
+    GROW_ARRAY(graph->ranks, capacity);
+    GROW_ARRAY(graph->order, capacity);
+    GROW_ARRAY(graph->tickNodes, capacity);
+    GROW_ARRAY(graph->pending, capacity);
+    GROW_ARRAY(graph->heap, capacity);
+    GROW_ARRAY(graph->scratch, capacity);
+    GROW_ARRAY(graph->outputOffsets, capacity + 1);
+    GROW_ARRAY(graph->outputLogHead, capacity);
+    graph->nodeCapacity = capacity;
+    return true;
+}
+
+static bool grow_ports(Graph *graph, uint32_t needed) {
+    uint32_t capacity = graph->portCapacity ? graph->portCapacity : 256;
+    while (capacity < graph->portCount + needed) capacity *= 2;
+    GROW_ARRAY(graph->inputSources, capacity);
+    graph->portCapacity = capacity;
+    return true;
+}
+
+static bool grow_output_log(Graph *graph) {
+    uint32_t capacity = graph->outputLogCapacity ? graph->outputLogCapacity * 2 : 256;
+    GROW_ARRAY(graph->outputLogTargets, capacity);
+    GROW_ARRAY(graph->outputLogNext, capacity);
+    graph->outputLogCapacity = capacity;
+    return true;
+}
+
+static bool node_live(const Graph *graph, GraphNodeHandle node) {
+    return node < graph->nodeCount && graph->kinds[node] != GRAPH_NODE_FREE;
+}
+
+static void pend(Graph *graph, GraphNodeHandle node) {
+    if (graph->flags[node] & GRAPH_FLAG_PENDING) return;
+    graph->flags[node] |= GRAPH_FLAG_PENDING;
+    graph->pending[graph->pendingCount++] = node;
+}
+
+// Copy the live port ranges into a fresh array, dropping the holes of removed nodes
+static bool compact_ports(Graph *graph) {
+    uint32_t *sources = malloc(graph->portCapacity * sizeof(uint32_t));
+    if (!sources) return false;
+    uint32_t count = 0;
+    for (uint32_t node = 0; node < graph->nodeCount; node++) {
+        if (graph->kinds[node] == GRAPH_NODE_FREE) continue;
+        memcpy(&sources[count], &graph->inputSources[graph->portBase[node]], graph->portCounts[node] * sizeof(uint32_t));
+        graph->portBase[node] = count;
+        count += graph->portCounts[node];
+    }
+    free(graph->inputSources);
+    graph->inputSources = sources;
+    graph->portCount = count;
+    graph->portHoles = 0;
+    return true;
+}
+
+// Rebuild the output CSR from the input ports, then rank the nodes with Kahn's algorithm.
+// O(nodes + edges); runs once per tick that follows an edit.
+static bool rebuild(Graph *graph) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (graph->portHoles * 2 > graph->portCount && !compact_ports(graph)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to compact graph ports");
+        return false;
+    }
+    if (graph->edgeCount > graph->targetCapacity) {
+        uint32_t capacity = graph->targetCapacity ? graph->targetCapacity : 256;
+        while (capacity < graph->edgeCount) capacity *= 2;
+        uint32_t *targets = realloc(graph->outputTargets, capacity * sizeof(uint32_t));
+        if (!targets) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow graph outputs");
+            return false;
+        }
+        graph->outputTargets = targets;
+        graph->targetCapacity = capacity;
+    }
+
+    uint32_t n = graph->nodeCount;
+    uint32_t *offsets = graph->outputOffsets;
+    memset(offsets, 0, (n + 1) * sizeof(uint32_t));
+    for (uint32_t node = 0; node < n; node++) {
+        if (graph->kinds[node] == GRAPH_NODE_FREE) continue;
+        const uint32_t *sources = &graph->inputSources[graph->portBase[node]];
+        for (uint32_t p = 0; p < graph->portCounts[node]; p++) {
+            if (sources[p] != GRAPH_NODE_INVALID) offsets[sources[p] + 1]++;
+        }
+    }
+    for (uint32_t node = 0; node < n; node++) {
+        offsets[node + 1] += offsets[node];
+    }
+    uint32_t *cursor = graph->scratch;
+    memcpy(cursor, offsets, n * sizeof(uint32_t));
+    for (uint32_t node = 0; node < n; node++) {
+        if (graph->kinds[node] == GRAPH_NODE_FREE) continue;
+        const uint32_t *sources = &graph->inputSources[graph->portBase[node]];
+        for (uint32_t p = 0; p < graph->portCounts[node]; p++) {
+            if (sources[p] != GRAPH_NODE_INVALID) graph->outputTargets[cursor[sources[p]]++] = node;
+        }
+    }
+
+    // In-degree counts connected ports, so a source feeding two ports of a node is released twice
+    uint32_t *degrees = graph->scratch;
+    uint32_t count = 0;
+    for (uint32_t node = 0; node < n; node++) {
+        if (graph->kinds[node] == GRAPH_NODE_FREE) continue;
+        degrees[node] = 0;
+        const uint32_t *sources = &graph->inputSources[graph->portBase[node]];
+        for (uint32_t p = 0; p < graph->portCounts[node]; p++) {
+            if (sources[p] != GRAPH_NODE_INVALID) degrees[node]++;
+        }
+        if (degrees[node] == 0) graph->order[count++] = node;
+    }
+    for (uint32_t head = 0; head < count; head++) {
+        uint32_t node = graph->order[head];
+        for (uint32_t e = offsets[node]; e < offsets[node + 1]; e++) {
+            uint32_t target = graph->outputTargets[e];
+            if (--degrees[target] == 0) graph->order[count++] = target;
+        }
+    }
+    graph->orderCount = count;
+
+    // Nodes never released sit on a cycle or below one. A node that leaves that state has missed
+    // every change while it was out, so it is evaluated again.
+    uint32_t cyclic = 0;
+    for (uint32_t node = 0; node < n; node++) {
+        if (graph->kinds[node] == GRAPH_NODE_FREE) continue;
+        if (degrees[node] != 0) {
+            graph->flags[node] |= GRAPH_FLAG_CYCLE;
+            graph->ranks[node] = GRAPH_RANK_NONE;
+            cyclic++;
+        } else if (graph->flags[node] & GRAPH_FLAG_CYCLE) {
+            graph->flags[node] &= ~GRAPH_FLAG_CYCLE;
+            pend(graph, node);
+        }
+    }
+    graph->tickCount = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t node = graph->order[i];
+        graph->ranks[node] = i;
+        if (graph->kinds[node] == GRAPH_NODE_TICK) graph->tickNodes[graph->tickCount++] = node;
+    }
+    if (cyclic > 0) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Graph has a cycle: %u nodes on or below it are not evaluated", cyclic);
+    }
+
+    // The CSR now holds every output
+    memset(graph->outputLogHead, 0xff, n * sizeof(uint32_t));
+    graph->outputLogCount = 0;
+    graph->outputNodes = n;
+    graph->topologyChanged = false;
+    graph->stats.rebuilds++;
+    graph->stats.rebuildMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    return true;
+}
+
+GraphNodeHandle graph_add_node(Graph *graph, GraphNodeKind kind, GraphOp op, uint32_t ports) {
+    if (kind >= GRAPH_NODE_FREE || op >= GRAPH_OP_COUNT) return GRAPH_NODE_INVALID;
+    if (kind != GRAPH_NODE_FUNCTION) ports = 0;
+    if (ports > GRAPH_MAX_PORTS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Graph node with %u ports, at most %d are supported", ports, GRAPH_MAX_PORTS);
+        return GRAPH_NODE_INVALID;
+    }
+    if (graph->portCount + ports > graph->portCapacity && !grow_ports(graph, ports)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow graph ports");
+        return GRAPH_NODE_INVALID;
+    }
+
+    GraphNodeHandle node;
+    if (graph->freeNode != GRAPH_NODE_INVALID) {
+        node = graph->freeNode;
+        graph->freeNode = graph->ranks[node];
+    } else {
+        if (graph->nodeCount == graph->nodeCapacity && !grow_nodes(graph)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow graph nodes");
+            return GRAPH_NODE_INVALID;
+        }
+        node = graph->nodeCount++;
+        graph->flags[node] = 0;
+    }
+
+    graph->kinds[node] = (uint8_t)kind;
+    graph->ops[node] = (uint8_t)op;
+    graph->flags[node] &= GRAPH_FLAG_PENDING; // A recycled handle may still sit in the pending list
+    graph->values[node] = 0.0f;
+    graph->portBase[node] = graph->portCount;
+    graph->portCounts[node] = ports;
+    graph->ranks[node] = GRAPH_RANK_NONE;
+    graph->outputLogHead[node] = GRAPH_NODE_INVALID;
+    for (uint32_t p = 0; p < ports; p++) {
+        graph->inputSources[graph->portCount++] = GRAPH_NODE_INVALID;
+    }
+    graph->liveCount++;
+    graph->topologyChanged = true;
+    pend(graph, node);
+    if (graph->listener.added) graph->listener.added(graph->listener.userData, node);
+    return node;
+}
+
+// Clear the ports of target still fed by node. CSR and log entries can be stale, since ports may
+// have been disconnected or the handles reused since, so only what the ports say counts.
+static void detach_output(Graph *graph, GraphNodeHandle node, uint32_t target) {
+    uint32_t *sources = &graph->inputSources[graph->portBase[target]];
+    bool detached = false;
+    for (uint32_t p = 0; p < graph->portCounts[target]; p++) {
+        if (sources[p] != node) continue;
+        sources[p] = GRAPH_NODE_INVALID;
+        graph->edgeCount--;
+        detached = true;
+    }
+    if (!detached) return;
+    pend(graph, target);
+    if (graph->listener.rewired) graph->listener.rewired(graph->listener.userData, target);
+}
+
+bool graph_remove_node(Graph *graph, GraphNodeHandle node) {
+    if (!node_live(graph, node)) return false;
+    // Outputs known at the last rebuild, then those connected since; the order waits for the next tick
+    if (node < graph->outputNodes) {
+        for (uint32_t e = graph->outputOffsets[node]; e < graph->outputOffsets[node + 1]; e++) {
+            detach_output(graph, node, graph->outputTargets[e]);
+        }
+    }
+    for (uint32_t e = graph->outputLogHead[node]; e != GRAPH_NODE_INVALID; e = graph->outputLogNext[e]) {
+        detach_output(graph, node, graph->outputLogTargets[e]);
+    }
+    graph->outputLogHead[node] = GRAPH_NODE_INVALID;
+    const uint32_t *sources = &graph->inputSources[graph->portBase[node]];
+    for (uint32_t p = 0; p < graph->portCounts[node]; p++) {
+        if (sources[p] != GRAPH_NODE_INVALID) graph->edgeCount--;
+    }
+    graph->portHoles += graph->portCounts[node];
+    graph->portCounts[node] = 0;
+    if (graph->listener.removed) graph->listener.removed(graph->listener.userData, node);
+
+    graph->kinds[node] = GRAPH_NODE_FREE;
+    graph->flags[node] &= GRAPH_FLAG_PENDING; // graph_tick drops it from the pending list
+    graph->ranks[node] = graph->freeNode;
+    graph->freeNode = node;
+    graph->liveCount--;
+    graph->topologyChanged = true;
+    return true;
+}
+
+bool graph_connect(Graph *graph, GraphNodeHandle from, GraphNodeHandle to, uint32_t port) {
+    if (!node_live(graph, from) || !node_live(graph, to) || from == to) return false;
+    if (port >= graph->portCounts[to]) return false;
+    uint32_t *source = &graph->inputSources[graph->portBase[to] + port];
+    if (*source == from) return true;
+    if (graph->outputLogCount == graph->outputLogCapacity && !grow_output_log(graph)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow graph output log");
+        return false;
+    }
+    uint32_t entry = graph->outputLogCount++;
+    graph->outputLogTargets[entry] = to;
+    graph->outputLogNext[entry] = graph->outputLogHead[from];
+    graph->outputLogHead[from] = entry;
+    if (*source == GRAPH_NODE_INVALID) graph->edgeCount++;
+    *source = from;
+    graph->topologyChanged = true;
+    pend(graph, to);
+    if (graph->listener.rewired) graph->listener.rewired(graph->listener.userData, to);
+    return true;
+}
+
+bool graph_disconnect(Graph *graph, GraphNodeHandle to, uint32_t port) {
+    if (!node_live(graph, to) || port >= graph->portCounts[to]) return false;
+    uint32_t *source = &graph->inputSources[graph->portBase[to] + port];
+    if (*source == GRAPH_NODE_INVALID) return true;
+    *source = GRAPH_NODE_INVALID;
+    graph->edgeCount--;
+    graph->topologyChanged = true;
+    pend(graph, to);
+    if (graph->listener.rewired) graph->listener.rewired(graph->listener.userData, to);
+    return true;
+}
+
+bool graph_set_variable(Graph *graph, GraphNodeHandle node, float value) {
+    if (!node_live(graph, node) || graph->kinds[node] != GRAPH_NODE_VARIABLE) return false;
+    if (graph->values[node] == value) return true;
+    graph->values[node] = value;
+    pend(graph, node);
+    return true;
+}
+
+bool graph_get_value(const Graph *graph, GraphNodeHandle node, float *value) {
+    if (!node_live(graph, node)) return false;
+    *value = graph->values[node];
+    return true;
+}
+
+void graph_invalidate(Graph *graph) {
+    for (uint32_t node = 0; node < graph->nodeCount; node++) {
+        if (graph->kinds[node] != GRAPH_NODE_FREE) pend(graph, node);
+    }
+}
+
+static void heap_push(Graph *graph, uint32_t node) {
+    graph->flags[node] |= GRAPH_FLAG_SCHEDULED;
+    uint32_t rank = graph->ranks[node];
+    uint32_t i = graph->heapCount++;
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (graph->ranks[graph->heap[parent]] <= rank) break;
+        graph->heap[i] = graph->heap[parent];
+        i = parent;
+    }
+    graph->heap[i] = node;
+}
+
+static uint32_t heap_pop(Graph *graph) {
+    uint32_t top = graph->heap[0];
+    uint32_t last = graph->heap[--graph->heapCount];
+    uint32_t rank = graph->ranks[last];
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t child = i * 2 + 1;
+        if (child >= graph->heapCount) break;
+        if (child + 1 < graph->heapCount && graph->ranks[graph->heap[child + 1]] < graph->ranks[graph->heap[child]]) child++;
+        if (graph->ranks[graph->heap[child]] >= rank) break;
+        graph->heap[i] = graph->heap[child];
+        i = child;
+    }
+    if (graph->heapCount > 0) graph->heap[i] = last;
+    graph->flags[top] &= ~GRAPH_FLAG_SCHEDULED;
+    return top;
+}
+
+void graph_set_listener(Graph *graph, const GraphListener *listener) {
+    if (listener) graph->listener = *listener;
+    else memset(&graph->listener, 0, sizeof(GraphListener));
+}
+
+bool graph_update_topology(Graph *graph) {
+    return !graph->topologyChanged || rebuild(graph);
+}
+
+void graph_set_executor(Graph *graph, const GraphExecutor *executor) {
+    if (executor) graph->executor = *executor;
+    else memset(&graph->executor, 0, sizeof(GraphExecutor));
+}
+
+bool graph_evaluate_node(Graph *graph, GraphNodeHandle node) {
+    if (graph->kinds[node] != GRAPH_NODE_FUNCTION) return true;
+    const uint32_t *sources = &graph->inputSources[graph->portBase[node]];
+    uint32_t ports = graph->portCounts[node];
+    GraphOp op = graph->ops[node];
+    float value = op == GRAPH_OP_MUL ? 1.0f : 0.0f;
+    bool first = true;
+    for (uint32_t p = 0; p < ports; p++) {
+        if (sources[p] == GRAPH_NODE_INVALID) continue;
+        float input = graph->values[sources[p]];
+        switch (op) {
+        case GRAPH_OP_ADD: value += input; break;
+        case GRAPH_OP_MUL: value *= input; break;
+        case GRAPH_OP_MIN: value = first ? input : SDL_min(value, input); break;
+        case GRAPH_OP_MAX: value = first ? input : SDL_max(value, input); break;
+        default: break;
+        }
+        first = false;
+    }
+    if (value == graph->values[node]) return false;
+    graph->values[node] = value;
+    return true;
+}
+
+// Evaluate every scheduled node from rank begin on by walking the order; outputs only need the
+// flag since they rank later
+static void sweep(Graph *graph, uint32_t begin, uint32_t *evaluated, uint32_t *changed) {
+    if (graph->executor.sweep && graph->executor.sweep(graph->executor.userData, graph, begin, evaluated, changed)) return;
+    for (uint32_t i = begin; i < graph->orderCount; i++) {
+        uint32_t node = graph->order[i];
+        if (!(graph->flags[node] & GRAPH_FLAG_SCHEDULED)) continue;
+        graph->flags[node] &= ~GRAPH_FLAG_SCHEDULED;
+        (*evaluated)++;
+        if (!graph_evaluate_node(graph, node)) continue;
+        (*changed)++;
+        for (uint32_t e = graph->outputOffsets[node]; e < graph->outputOffsets[node + 1]; e++) {
+            uint32_t target = graph->outputTargets[e];
+            if (!(graph->flags[target] & GRAPH_FLAG_CYCLE)) graph->flags[target] |= GRAPH_FLAG_SCHEDULED;
+        }
+    }
+}
+
+// Wide ticks flag their seeds and go straight to the sweep instead of filling the heap
+static void schedule(Graph *graph, uint32_t node, bool wide) {
+    if (wide) graph->flags[node] |= GRAPH_FLAG_SCHEDULED;
+    else heap_push(graph, node);
+}
+
+uint32_t graph_tick(Graph *graph) {
+    if (graph->topologyChanged && !rebuild(graph)) return 0;
+    graph->stats.ticks++;
+
+    bool wide = graph->tickCount + graph->pendingCount > graph->orderCount / GRAPH_SWEEP_FRACTION;
+    float tick = (float)graph->stats.ticks;
+    for (uint32_t i = 0; i < graph->tickCount; i++) {
+        uint32_t node = graph->tickNodes[i];
+        graph->values[node] = tick;
+        schedule(graph, node, wide);
+    }
+    for (uint32_t i = 0; i < graph->pendingCount; i++) {
+        uint32_t node = graph->pending[i];
+        graph->flags[node] &= ~GRAPH_FLAG_PENDING;
+        if (graph->kinds[node] == GRAPH_NODE_FREE) continue;
+        if (graph->flags[node] & (GRAPH_FLAG_CYCLE | GRAPH_FLAG_SCHEDULED)) continue;
+        schedule(graph, node, wide);
+    }
+    graph->pendingCount = 0;
+
+    // Ranks only grow along edges, so every node is popped after all of its changed inputs
+    uint32_t evaluated = 0, changed = 0;
+    if (wide) sweep(graph, 0, &evaluated, &changed);
+    while (graph->heapCount > 0) {
+        if (graph->heapCount > graph->orderCount / GRAPH_SWEEP_FRACTION) {
+            // The heap's entries are flagged already
+            uint32_t begin = graph->ranks[graph->heap[0]];
+            graph->heapCount = 0;
+            sweep(graph, begin, &evaluated, &changed);
+            break;
+        }
+        uint32_t node = heap_pop(graph);
+        evaluated++;
+        if (!graph_evaluate_node(graph, node)) continue;
+        changed++;
+        for (uint32_t e = graph->outputOffsets[node]; e < graph->outputOffsets[node + 1]; e++) {
+            uint32_t target = graph->outputTargets[e];
+            if (!(graph->flags[target] & (GRAPH_FLAG_SCHEDULED | GRAPH_FLAG_CYCLE))) heap_push(graph, target);
+        }
+    }
+
+    graph->stats.evaluated = evaluated;
+    graph->stats.changed = changed;
+    graph->stats.totalEvaluated += evaluated;
+    return evaluated;
+}
@@ -0,0 +1,104 @@
+// module_jobs.c
+#include "module_jobs.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Take the next job of the current batch; the mutex must be held
+static bool take_job(JobSystem *jobs, uint32_t *jobIndex) {
+    if (jobs->nextJob >= jobs->jobCount) return false;
+    *jobIndex = jobs->nextJob++;
+    return true;
+}
+
+// Run one job with the mutex released, then account for it
+static void run_job(JobSystem *jobs, uint32_t jobIndex) {
+    JobFunction function = jobs->function;
+    void *userData = jobs->userData;
+    SDL_UnlockMutex(jobs->mutex);
+    function(userData, jobIndex);
+    SDL_LockMutex(jobs->mutex);
+    if (--jobs->jobsRemaining == 0) SDL_SignalCondition(jobs->workDone);
+}
+
+static int worker_main(void *data) {
+    JobSystem *jobs = data;
+    SDL_LockMutex(jobs->mutex);
+    while (!jobs->quit) {
+        uint32_t jobIndex;
+        if (take_job(jobs, &jobIndex)) {
+            run_job(jobs, jobIndex);
+        } else {
+            SDL_WaitCondition(jobs->workReady, jobs->mutex);
+        }
+    }
+    SDL_UnlockMutex(jobs->mutex);
+    return 0;
+}
+
+bool job_system_init(JobSystem *jobs, uint32_t threads) {
+    memset(jobs, 0, sizeof(JobSystem));
+    threads = SDL_clamp(threads, 1, JOB_MAX_THREADS);
+    if (threads == 1) return true;
+
+    jobs->mutex = SDL_CreateMutex();
+    jobs->workReady = SDL_CreateCondition();
+    jobs->workDone = SDL_CreateCondition();
+    jobs->threads = calloc(threads - 1, sizeof(SDL_Thread *));
+    if (!jobs->mutex || !jobs->workReady || !jobs->workDone || !jobs->threads) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create job system: %s", SDL_GetError());
+        job_system_destroy(jobs);
+        return false;
+    }
+    for (uint32_t i = 0; i < threads - 1; i++) {
+        jobs->threads[i] = SDL_CreateThread(worker_main, "job worker", jobs);
+        if (!jobs->threads[i]) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create job worker %u: %s", i, SDL_GetError());
+            job_system_destroy(jobs);
+            return false;
+        }
+        jobs->threadCount++;
+    }
+    return true;
+}
+
+// Safe to call on a partially initialized (zeroed) job system
+void job_system_destroy(JobSystem *jobs) {
+    if (jobs->mutex) {
+        SDL_LockMutex(jobs->mutex);
+        jobs->quit = true;
+        SDL_BroadcastCondition(jobs->workReady);
+        SDL_UnlockMutex(jobs->mutex);
+    }
+    for (uint32_t i = 0; i < jobs->threadCount; i++) {
+        SDL_WaitThread(jobs->threads[i], NULL);
+    }
+    free(jobs->threads);
+    SDL_DestroyCondition(jobs->workDone);
+    SDL_DestroyCondition(jobs->workReady);
+    SDL_DestroyMutex(jobs->mutex);
+    memset(jobs, 0, sizeof(JobSystem));
+}
+
+void job_system_run(JobSystem *jobs, JobFunction function, void *userData, uint32_t jobCount) {
+    if (jobs->threadCount == 0) {
+        for (uint32_t i = 0; i < jobCount; i++) function(userData, i);
+        return;
+    }
+    SDL_LockMutex(jobs->mutex);
+    jobs->function = function;
+    jobs->userData = userData;
+    jobs->jobCount = jobCount;
+    jobs->nextJob = 0;
+    jobs->jobsRemaining = jobCount;
+    SDL_BroadcastCondition(jobs->workReady);
+
+    // The caller works through the batch too, then waits for the stragglers
+    uint32_t jobIndex;
+    while (take_job(jobs, &jobIndex)) {
+        run_job(jobs, jobIndex);
+    }
+    while (jobs->jobsRemaining > 0) {
+        SDL_WaitCondition(jobs->workDone, jobs->mutex);
+    }
+    SDL_UnlockMutex(jobs->mutex);
+}
@@ -0,0 +1,129 @@
+// module_layout.c
+#include "module_layout.h"
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void lru_unlink(LayoutCache *cache, LayoutRun *run) {
+    if (run->lruPrev) run->lruPrev->lruNext = run->lruNext;
+    else cache->lruHead = run->lruNext;
+    if (run->lruNext) run->lruNext->lruPrev = run->lruPrev;
+    else cache->lruTail = run->lruPrev;
+}
+
+static void lru_append(LayoutCache *cache, LayoutRun *run) {
+    run->lruPrev = cache->lruTail;
+    run->lruNext = NULL;
+    if (cache->lruTail) cache->lruTail->lruNext = run;
+    else cache->lruHead = run;
+    cache->lruTail = run;
+}
+
+static bool grow_buckets(LayoutCache *cache) {
+    uint32_t count = cache->bucketCount ? cache->bucketCount * 2 : LAYOUT_INITIAL_BUCKETS;
+    LayoutRun **buckets = calloc(count, sizeof(LayoutRun *));
+    if (!buckets) return false;
+    for (uint32_t b = 0; b < cache->bucketCount; b++) {
+        LayoutRun *run = cache->buckets[b];
+        while (run) {
+            LayoutRun *next = run->hashNext;
+            LayoutRun **bucket = &buckets[run->hash & (count - 1)];
+            run->hashNext = *bucket;
+            *bucket = run;
+            run = next;
+        }
+    }
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucketCount = count;
+    return true;
+}
+
+static void evict(LayoutCache *cache, LayoutRun *run) {
+    LayoutRun **link = &cache->buckets[run->hash & (cache->bucketCount - 1)];
+    while (*link != run) link = &(*link)->hashNext;
+    *link = run->hashNext;
+    lru_unlink(cache, run);
+    cache->bytes -= run->bytes;
+    cache->count--;
+    cache->stats.evictions++;
+    free(run);
+}
+
+void layout_cache_init(LayoutCache *cache, size_t budget) {
+    memset(cache, 0, sizeof(LayoutCache));
+    cache->budget = budget;
+}
+
+void layout_cache_destroy(LayoutCache *cache) {
+    LayoutRun *run = cache->lruHead;
+    while (run) {
+        LayoutRun *next = run->lruNext;
+        free(run);
+        run = next;
+    }
+    free(cache->buckets);
+    memset(cache, 0, sizeof(LayoutCache));
+}
+
+// FNV-1a over the bytes, then the font id, with a final avalanche for the bucket mask
+uint64_t layout_hash(const char *string, uint32_t font) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const unsigned char *c = (const unsigned char *)string; *c; c++) {
+        hash = (hash ^ *c) * 0x100000001b3ull;
+    }
+    hash = (hash ^ font) * 0x100000001b3ull;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+LayoutRun *layout_cache_find(LayoutCache *cache, uint64_t hash, uint32_t font, const char *string) {
+    if (cache->bucketCount > 0) {
+        for (LayoutRun *run = cache->buckets[hash & (cache->bucketCount - 1)]; run; run = run->hashNext) {
+            if (run->hash != hash || run->font != font || strcmp(run->string, string) != 0) continue;
+            if (run != cache->lruTail) {
+                lru_unlink(cache, run);
+                lru_append(cache, run);
+            }
+            cache->stats.hits++;
+            return run;
+        }
+    }
+    cache->stats.misses++;
+    return NULL;
+}
+
+LayoutRun *layout_cache_insert(LayoutCache *cache, uint64_t hash, uint32_t font, const char *string,
+                               const LayoutGlyph *glyphs, uint32_t glyphCount, const SpatialRect *bounds) {
+    // Keep chains short; a failed grow only lengthens them, unless there is no table yet
+    if (cache->count >= cache->bucketCount && !grow_buckets(cache) && cache->bucketCount == 0) return NULL;
+
+    // One block: the run, its glyphs, then the string
+    size_t length = strlen(string);
+    size_t bytes = sizeof(LayoutRun) + glyphCount * sizeof(LayoutGlyph) + length + 1;
+    LayoutRun *run = malloc(bytes);
+    if (!run) return NULL;
+    run->hash = hash;
+    run->font = font;
+    run->length = (uint32_t)length;
+    run->glyphs = (LayoutGlyph *)(run + 1);
+    run->string = (char *)(run->glyphs + glyphCount);
+    memcpy(run->glyphs, glyphs, glyphCount * sizeof(LayoutGlyph));
+    memcpy(run->string, string, length + 1);
+    run->glyphCount = glyphCount;
+    run->bounds = *bounds;
+    run->bytes = bytes;
+
+    LayoutRun **bucket = &cache->buckets[hash & (cache->bucketCount - 1)];
+    run->hashNext = *bucket;
+    *bucket = run;
+    lru_append(cache, run);
+    cache->count++;
+    cache->bytes += bytes;
+    while (cache->bytes > cache->budget && cache->lruHead != run) {
+        evict(cache, cache->lruHead);
+    }
+    return run;
+}
@@ -0,0 +1,282 @@
+// module_memory.c
+#include "module_memory.h"
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+bool memory_allocator_init(MemoryAllocator *allocator, VkDevice device, VkPhysicalDevice physicalDevice) {
+    memset(allocator, 0, sizeof(MemoryAllocator));
+    allocator->device = device;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &allocator->properties);
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+    allocator->bufferImageGranularity = deviceProperties.limits.bufferImageGranularity;
+    if (allocator->bufferImageGranularity == 0) allocator->bufferImageGranularity = 1;
+    allocator->maxAllocationCount = deviceProperties.limits.maxMemoryAllocationCount;
+    return true;
+}
+
+static void destroy_block(MemoryAllocator *allocator, MemoryBlock *block) {
+    if (block->mapped) vkUnmapMemory(allocator->device, block->memory);
+    vkFreeMemory(allocator->device, block->memory, NULL);
+    free(block->freeRanges);
+    free(block);
+    allocator->deviceAllocationCount--;
+}
+
+void memory_allocator_destroy(MemoryAllocator *allocator) {
+    if (allocator->allocationCount > 0) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Memory allocator destroyed with %u live allocations", allocator->allocationCount);
+    }
+    for (uint32_t t = 0; t < VK_MAX_MEMORY_TYPES; t++) {
+        MemoryPool *pool = &allocator->pools[t];
+        for (uint32_t i = 0; i < pool->count; i++) {
+            destroy_block(allocator, pool->blocks[i]);
+        }
+        free(pool->blocks);
+    }
+    memset(allocator, 0, sizeof(MemoryAllocator));
+}
+
+uint32_t memory_find_type(const MemoryAllocator *allocator, uint32_t typeBits, VkMemoryPropertyFlags properties) {
+    for (uint32_t i = 0; i < allocator->properties.memoryTypeCount; i++) {
+        if ((typeBits & (1u << i)) && (allocator->properties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+// Small heaps (e.g. host-visible device-local BAR memory) get proportionally smaller blocks
+static VkDeviceSize block_size_for_type(const MemoryAllocator *allocator, uint32_t memoryType) {
+    uint32_t heapIndex = allocator->properties.memoryTypes[memoryType].heapIndex;
+    VkDeviceSize heapSize = allocator->properties.memoryHeaps[heapIndex].size;
+    VkDeviceSize blockSize = MEMORY_BLOCK_SIZE;
+    if (heapSize / 8 < blockSize) blockSize = heapSize / 8;
+    return blockSize;
+}
+
+static MemoryBlock *create_block(MemoryAllocator *allocator, uint32_t memoryType, VkDeviceSize size, bool dedicated) {
+    MemoryPool *pool = &allocator->pools[memoryType];
+    if (pool->count == pool->capacity) {
+        uint32_t capacity = pool->capacity ? pool->capacity * 2 : 4;
+        MemoryBlock **blocks = realloc(pool->blocks, capacity * sizeof(MemoryBlock *));
+        if (!blocks) return NULL;
+        pool->blocks = blocks;
+        pool->capacity = capacity;
+    }
+    if (allocator->maxAllocationCount && allocator->deviceAllocationCount >= allocator->maxAllocationCount) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Reached maxMemoryAllocationCount (%u)", allocator->maxAllocationCount);
+        return NULL;
+    }
+
+    MemoryBlock *block = calloc(1, sizeof(MemoryBlock));
+    if (!block) return NULL;
+    block->freeCapacity = 4;
+    block->freeRanges = malloc(block->freeCapacity * sizeof(MemoryRange));
+    if (!block->freeRanges) {
+        free(block);
+        return NULL;
+    }
+    VkMemoryAllocateInfo allocInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = size,
+        .memoryTypeIndex = memoryType
+    };
+    if (vkAllocateMemory(allocator->device, &allocInfo, NULL, &block->memory) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate %llu bytes of memory type %u",
+                     (unsigned long long)size, memoryType);
+        free(block->freeRanges);
+        free(block);
+        return NULL;
+    }
+    if (allocator->properties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        // Mapped once for the block's lifetime; sub-allocations cannot map shared memory themselves
+        if (vkMapMemory(allocator->device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map memory block");
+            vkFreeMemory(allocator->device, block->memory, NULL);
+            free(block->freeRanges);
+            free(block);
+            return NULL;
+        }
+    }
+    block->size = size;
+    block->dedicated = dedicated;
+    block->freeRanges[0] = (MemoryRange){ 0, size };
+    block->freeCount = 1;
+    pool->blocks[pool->count++] = block;
+    allocator->deviceAllocationCount++;
+    return block;
+}
+
+// First fit; alignment padding in front of the allocation stays in the free list
+static bool block_suballocate(MemoryBlock *block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize *offset) {
+    // Free ranges never outnumber allocations + 1, so reserving here keeps memory_free from allocating
+    if (block->freeCapacity < block->allocationCount + 2) {
+        uint32_t capacity = block->freeCapacity * 2;
+        while (capacity < block->allocationCount + 2) capacity *= 2;
+        MemoryRange *ranges = realloc(block->freeRanges, capacity * sizeof(MemoryRange));
+        if (!ranges) return false;
+        block->freeRanges = ranges;
+        block->freeCapacity = capacity;
+    }
+
+    for (uint32_t i = 0; i < block->freeCount; i++) {
+        MemoryRange *range = &block->freeRanges[i];
+        VkDeviceSize start = align_up(range->offset, alignment);
+        VkDeviceSize end = range->offset + range->size;
+        if (start + size > end) continue;
+
+        VkDeviceSize front = start - range->offset;
+        VkDeviceSize tail = end - (start + size);
+        if (front > 0 && tail > 0) {
+            range->size = front;
+            memmove(&block->freeRanges[i + 2], &block->freeRanges[i + 1], (block->freeCount - i - 1) * sizeof(MemoryRange));
+            block->freeRanges[i + 1] = (MemoryRange){ start + size, tail };
+            block->freeCount++;
+        } else if (front > 0) {
+            range->size = front;
+        } else if (tail > 0) {
+            range->offset = start + size;
+            range->size = tail;
+        } else {
+            memmove(&block->freeRanges[i], &block->freeRanges[i + 1], (block->freeCount - i - 1) * sizeof(MemoryRange));
+            block->freeCount--;
+        }
+        block->used += size;
+        block->allocationCount++;
+        *offset = start;
+        return true;
+    }
+    return false;
+}
+
+// Return a range to the free list, merging it with its neighbours
+static void block_release(MemoryBlock *block, VkDeviceSize offset, VkDeviceSize size) {
+    uint32_t next = 0;
+    while (next < block->freeCount && block->freeRanges[next].offset < offset) next++;
+    bool mergePrev = next > 0 && block->freeRanges[next - 1].offset + block->freeRanges[next - 1].size == offset;
+    bool mergeNext = next < block->freeCount && offset + size == block->freeRanges[next].offset;
+
+    if (mergePrev && mergeNext) {
+        block->freeRanges[next - 1].size += size + block->freeRanges[next].size;
+        memmove(&block->freeRanges[next], &block->freeRanges[next + 1], (block->freeCount - next - 1) * sizeof(MemoryRange));
+        block->freeCount--;
+    } else if (mergePrev) {
+        block->freeRanges[next - 1].size += size;
+    } else if (mergeNext) {
+        block->freeRanges[next].offset = offset;
+        block->freeRanges[next].size += size;
+    } else {
+        memmove(&block->freeRanges[next + 1], &block->freeRanges[next], (block->freeCount - next) * sizeof(MemoryRange));
+        block->freeRanges[next] = (MemoryRange){ offset, size };
+        block->freeCount++;
+    }
+    block->used -= size;
+    block->allocationCount--;
+}
+
+bool memory_allocate(MemoryAllocator *allocator, const VkMemoryRequirements *requirements,
+                     VkMemoryPropertyFlags properties, bool optimalImage, MemoryAllocation *allocation) {
+    memset(allocation, 0, sizeof(MemoryAllocation));
+    uint32_t memoryType = memory_find_type(allocator, requirements->memoryTypeBits, properties);
+    if (memoryType == UINT32_MAX) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to find suitable memory type");
+        return false;
+    }
+
+    VkDeviceSize size = requirements->size;
+    VkDeviceSize alignment = requirements->alignment ? requirements->alignment : 1;
+    if (optimalImage && allocator->bufferImageGranularity > 1) {
+        // Give optimal-tiling images whole granularity pages so they never share one with a buffer
+        if (alignment < allocator->bufferImageGranularity) alignment = allocator->bufferImageGranularity;
+        size = align_up(size, allocator->bufferImageGranularity);
+    }
+
+    MemoryBlock *block = NULL;
+    VkDeviceSize offset = 0;
+    VkDeviceSize blockSize = block_size_for_type(allocator, memoryType);
+    if (size > blockSize / 2) {
+        // Large resources get their own block instead of fragmenting a shared one
+        block = create_block(allocator, memoryType, size, true);
+        if (!block || !block_suballocate(block, size, alignment, &offset)) return false;
+    } else {
+        MemoryPool *pool = &allocator->pools[memoryType];
+        for (uint32_t i = 0; i < pool->count; i++) {
+            if (!pool->blocks[i]->dedicated && block_suballocate(pool->blocks[i], size, alignment, &offset)) {
+                block = pool->blocks[i];
+                break;
+            }
+        }
+        if (!block) {
+            block = create_block(allocator, memoryType, blockSize, false);
+            if (!block || !block_suballocate(block, size, alignment, &offset)) return false;
+        }
+    }
+
+    allocation->block = block;
+    allocation->memory = block->memory;
+    allocation->offset = offset;
+    allocation->size = size;
+    allocation->mapped = block->mapped ? (char *)block->mapped + offset : NULL;
+    allocation->memoryType = memoryType;
+    allocator->allocationCount++;
+    return true;
+}
+
+void memory_free(MemoryAllocator *allocator, MemoryAllocation *allocation) {
+    MemoryBlock *block = allocation->block;
+    if (!block) return;
+    block_release(block, allocation->offset, allocation->size);
+    allocator->allocationCount--;
+
+    // Keep one empty shared block per type so alloc/free churn does not hit the driver
+    MemoryPool *pool = &allocator->pools[allocation->memoryType];
+    if (block->allocationCount == 0 && (block->dedicated || pool->count > 1)) {
+        for (uint32_t i = 0; i < pool->count; i++) {
+            if (pool->blocks[i] == block) {
+                pool->blocks[i] = pool->blocks[--pool->count];
+                break;
+            }
+        }
+        destroy_block(allocator, block);
+    }
+    memset(allocation, 0, sizeof(MemoryAllocation));
+}
+
+void memory_get_stats(const MemoryAllocator *allocator, uint32_t memoryType, MemoryStats *stats) {
+    memset(stats, 0, sizeof(MemoryStats));
+    const MemoryPool *pool = &allocator->pools[memoryType];
+    for (uint32_t i = 0; i < pool->count; i++) {
+        const MemoryBlock *block = pool->blocks[i];
+        stats->blockCount++;
+        stats->allocationCount += block->allocationCount;
+        stats->bytesReserved += block->size;
+        stats->bytesUsed += block->used;
+        stats->freeRangeCount += block->freeCount;
+        for (uint32_t r = 0; r < block->freeCount; r++) {
+            if (block->freeRanges[r].size > stats->largestFreeRange) stats->largestFreeRange = block->freeRanges[r].size;
+        }
+    }
+}
+
+void memory_log_stats(const MemoryAllocator *allocator) {
+    SDL_Log("Device memory: %u sub-allocations in %u vkAllocateMemory blocks (limit %u)",
+            allocator->allocationCount, allocator->deviceAllocationCount, allocator->maxAllocationCount);
+    for (uint32_t t = 0; t < allocator->properties.memoryTypeCount; t++) {
+        MemoryStats stats;
+        memory_get_stats(allocator, t, &stats);
+        if (stats.blockCount == 0) continue;
+        // Fragmentation: share of free bytes not reachable by the largest single allocation
+        VkDeviceSize freeBytes = stats.bytesReserved - stats.bytesUsed;
+        double fragmentation = freeBytes ? 100.0 * (1.0 - (double)stats.largestFreeRange / freeBytes) : 0.0;
+        SDL_Log("  type %u (flags 0x%x): %u blocks, %u allocations, %.2f / %.2f MiB used, %u free ranges, fragmentation %.1f%%",
+                t, allocator->properties.memoryTypes[t].propertyFlags, stats.blockCount, stats.allocationCount,
+                stats.bytesUsed / (1024.0 * 1024.0), stats.bytesReserved / (1024.0 * 1024.0),
+                stats.freeRangeCount, fragmentation);
+    }
+}
@@ -0,0 +1,310 @@
+// module_node.c
+#include "module_node.h"
+#include <SDL3/SDL.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Half extent of each mesh in model space, the node bounds kept in the spatial index
+static const float meshHalfExtent[NODE_MESH_COUNT] = {
+    0.5f,  // Triangle
+    0.25f  // Square
+};
+
+void node_store_init(NodeStore *store) {
+    memset(store, 0, sizeof(NodeStore));
+    store->freeHead = NODE_HANDLE_INVALID;
+    spatial_init(&store->spatial, SPATIAL_CELL_SIZE);
+    transform_init(&store->transforms);
+}
+
+void node_store_destroy(NodeStore *store) {
+    for (int m = 0; m < NODE_MESH_COUNT; m++) {
+        NodeMeshBatch *batch = &store->batches[m];
+        free(batch->positions);
+        free(batch->scales);
+        free(batch->rotations);
+        free(batch->colors);
+        free(batch->instances);
+        free(batch->handles);
+    }
+    free(store->slotMesh);
+    free(store->slotIndex);
+    free(store->slotTransform);
+    spatial_destroy(&store->spatial);
+    transform_destroy(&store->transforms);
+    node_store_init(store);
+}
+
+void node_store_set_listener(NodeStore *store, const NodeListener *listener) {
+    if (listener) store->listener = *listener;
+    else memset(&store->listener, 0, sizeof(NodeListener));
+}
+
+static uint32_t pack_color(const float color[4]) {
+    uint32_t packed = 0;
+    for (int c = 0; c < 4; c++) {
+        packed |= (uint32_t)(SDL_clamp(color[c], 0.0f, 1.0f) * 255.0f + 0.5f) << (c * 8);
+    }
+    return packed;
+}
+
+// Axis-aligned world bounds of the instance's mesh square
+static SpatialRect node_bounds(const NodeInstance *instance, NodeMesh mesh) {
+    float h = meshHalfExtent[mesh];
+    float ex = h * (fabsf(instance->basis[0]) + fabsf(instance->basis[2]));
+    float ey = h * (fabsf(instance->basis[1]) + fabsf(instance->basis[3]));
+    const float *t = instance->translation;
+    return (SpatialRect){ t[0] - ex, t[1] - ey, t[0] + ex, t[1] + ey };
+}
+
+#define GROW_ARRAY(array, capacity) do { \
+        void *grown = realloc((array), (capacity) * sizeof(*(array))); \
+        if (!grown) return false; \
+        (array) = grown; \
+    } while (0)
+
+static bool grow_batch(NodeMeshBatch *batch) {
+    uint32_t capacity = batch->capacity ? batch->capacity * 2 : 64;
+    GROW_ARRAY(batch->positions, capacity);
+    GROW_ARRAY(batch->scales, capacity);
+    GROW_ARRAY(batch->rotations, capacity);
+    GROW_ARRAY(batch->colors, capacity);
+    GROW_ARRAY(batch->instances, capacity);
+    GROW_ARRAY(batch->handles, capacity);
+    batch->capacity = capacity;
+    return true;
+}
+
+static bool grow_slots(NodeStore *store) {
+    uint32_t capacity = store->slotCapacity ? store->slotCapacity * 2 : 64;
+    GROW_ARRAY(store->slotMesh, capacity);
+    GROW_ARRAY(store->slotIndex, capacity);
+    GROW_ARRAY(store->slotTransform, capacity);
+    store->slotCapacity = capacity;
+    return true;
+}
+
+static bool node_valid(const NodeStore *store, NodeHandle handle) {
+    return handle < store->slotCount && store->slotMesh[handle] < NODE_MESH_COUNT;
+}
+
+// Push the node's position and rotation to its transform entry, dirtying its subtree
+static bool node_moved(NodeStore *store, NodeHandle handle) {
+    const NodeMeshBatch *batch = &store->batches[store->slotMesh[handle]];
+    uint32_t index = store->slotIndex[handle];
+    TransformAffine local;
+    transform_affine_make(batch->positions[index][0], batch->positions[index][1], batch->rotations[index], &local);
+    return transform_set_local(&store->transforms, store->slotTransform[handle], &local);
+}
+
+NodeHandle node_add(NodeStore *store, NodeMesh mesh, float x, float y, float scale, const float color[4]) {
+    NodeMeshBatch *batch = &store->batches[mesh];
+    if (batch->count == batch->capacity && !grow_batch(batch)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow node batch");
+        return NODE_HANDLE_INVALID;
+    }
+
+    // Reuse a released handle before issuing a new one
+    NodeHandle handle;
+    if (store->freeHead != NODE_HANDLE_INVALID) {
+        handle = store->freeHead;
+        store->freeHead = store->slotIndex[handle];
+    } else {
+        if (store->slotCount == store->slotCapacity && !grow_slots(store)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow node handle table");
+            return NODE_HANDLE_INVALID;
+        }
+        handle = store->slotCount++;
+    }
+
+    uint32_t index = batch->count++;
+    batch->positions[index][0] = x;
+    batch->positions[index][1] = y;
+    batch->scales[index][0] = scale;
+    batch->scales[index][1] = scale;
+    batch->rotations[index] = 0.0f;
+    batch->colors[index] = pack_color(color);
+    batch->instances[index].color = batch->colors[index];
+    batch->instances[index].flags = 0;
+    batch->handles[index] = handle;
+
+    // The instance and spatial bounds are filled in by the next transform update
+    TransformAffine local;
+    transform_affine_make(x, y, 0.0f, &local);
+    store->slotTransform[handle] = transform_add(&store->transforms, TRANSFORM_HANDLE_INVALID, handle, &local);
+    if (store->slotTransform[handle] == TRANSFORM_HANDLE_INVALID) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to add node transform");
+        batch->count--;
+        store->slotIndex[handle] = store->freeHead;
+        store->freeHead = handle;
+        store->slotMesh[handle] = NODE_MESH_COUNT;
+        return NODE_HANDLE_INVALID;
+    }
+    store->slotMesh[handle] = mesh;
+    store->slotIndex[handle] = index;
+    store->count++;
+    return handle;
+}
+
+bool node_remove(NodeStore *store, NodeHandle handle) {
+    if (!node_valid(store, handle)) return false;
+    if (store->listener.removed) store->listener.removed(store->listener.userData, handle);
+    spatial_remove(&store->spatial, handle);
+    transform_remove(&store->transforms, store->slotTransform[handle]);
+
+    // Swap the last node into the hole to keep the batch dense
+    NodeMeshBatch *batch = &store->batches[store->slotMesh[handle]];
+    uint32_t index = store->slotIndex[handle];
+    uint32_t last = --batch->count;
+    if (index != last) {
+        memcpy(batch->positions[index], batch->positions[last], sizeof(batch->positions[0]));
+        memcpy(batch->scales[index], batch->scales[last], sizeof(batch->scales[0]));
+        batch->rotations[index] = batch->rotations[last];
+        batch->colors[index] = batch->colors[last];
+        batch->instances[index] = batch->instances[last];
+        batch->handles[index] = batch->handles[last];
+        store->slotIndex[batch->handles[index]] = index;
+    }
+
+    store->slotMesh[handle] = NODE_MESH_COUNT;
+    store->slotIndex[handle] = store->freeHead;
+    store->freeHead = handle;
+    store->count--;
+    return true;
+}
+
+bool node_get_position(const NodeStore *store, NodeHandle handle, float position[2]) {
+    if (!node_valid(store, handle)) return false;
+    const float *stored = store->batches[store->slotMesh[handle]].positions[store->slotIndex[handle]];
+    position[0] = stored[0];
+    position[1] = stored[1];
+    return true;
+}
+
+bool node_get_rotation(const NodeStore *store, NodeHandle handle, float *radians) {
+    if (!node_valid(store, handle)) return false;
+    *radians = store->batches[store->slotMesh[handle]].rotations[store->slotIndex[handle]];
+    return true;
+}
+
+bool node_get_world_position(const NodeStore *store, NodeHandle handle, float position[2]) {
+    if (!node_valid(store, handle)) return false;
+    const TransformAffine *world = transform_get_world(&store->transforms, store->slotTransform[handle]);
+    position[0] = world->tx;
+    position[1] = world->ty;
+    return true;
+}
+
+bool node_set_position(NodeStore *store, NodeHandle handle, float x, float y) {
+    if (!node_valid(store, handle)) return false;
+    float *position = store->batches[store->slotMesh[handle]].positions[store->slotIndex[handle]];
+    position[0] = x;
+    position[1] = y;
+    return node_moved(store, handle);
+}
+
+bool node_set_scale(NodeStore *store, NodeHandle handle, float scaleX, float scaleY) {
+    if (!node_valid(store, handle)) return false;
+    float *scale = store->batches[store->slotMesh[handle]].scales[store->slotIndex[handle]];
+    scale[0] = scaleX;
+    scale[1] = scaleY;
+    return node_moved(store, handle); // Rebuilds the subtree too; scale changes are rare
+}
+
+bool node_set_rotation(NodeStore *store, NodeHandle handle, float radians) {
+    if (!node_valid(store, handle)) return false;
+    store->batches[store->slotMesh[handle]].rotations[store->slotIndex[handle]] = radians;
+    return node_moved(store, handle);
+}
+
+bool node_set_color(NodeStore *store, NodeHandle handle, const float color[4]) {
+    if (!node_valid(store, handle)) return false;
+    NodeMeshBatch *batch = &store->batches[store->slotMesh[handle]];
+    uint32_t index = store->slotIndex[handle];
+    batch->colors[index] = pack_color(color);
+    batch->instances[index].color = batch->colors[index];
+    return true;
+}
+
+bool node_set_parent(NodeStore *store, NodeHandle child, NodeHandle parent) {
+    if (!node_valid(store, child)) return false;
+    if (parent != NODE_HANDLE_INVALID && !node_valid(store, parent)) return false;
+    TransformHandle parentTransform = parent == NODE_HANDLE_INVALID ? TRANSFORM_HANDLE_INVALID : store->slotTransform[parent];
+    return transform_set_parent(&store->transforms, store->slotTransform[child], parentTransform);
+}
+
+// Rebuild one node's instance from its new world transform, scaled by its own mesh scale
+static void update_visit(void *userData, uint32_t owner, const TransformAffine *world) {
+    NodeStore *store = userData;
+    NodeMesh mesh = store->slotMesh[owner];
+    NodeMeshBatch *batch = &store->batches[mesh];
+    uint32_t index = store->slotIndex[owner];
+    const float *scale = batch->scales[index];
+    NodeInstance *instance = &batch->instances[index];
+    instance->basis[0] = world->a * scale[0];
+    instance->basis[1] = world->b * scale[0];
+    instance->basis[2] = world->c * scale[1];
+    instance->basis[3] = world->d * scale[1];
+    instance->translation[0] = world->tx;
+    instance->translation[1] = world->ty;
+    SpatialRect bounds = node_bounds(instance, mesh);
+    if (!spatial_update(&store->spatial, owner, &bounds)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to index node %u", owner);
+    }
+    if (store->listener.moved) store->listener.moved(store->listener.userData, owner, world->tx, world->ty);
+}
+
+uint32_t node_store_update_transforms(NodeStore *store) {
+    return transform_update(&store->transforms, update_visit, store);
+}
+
+typedef struct {
+    const NodeStore *store;
+    float x, y;
+    NodeHandle top;
+} PickQuery;
+
+// Later meshes and later instances draw on top; keep the candidate drawn last whose transformed
+// square (not just its bounds) contains the point
+static bool pick_visit(void *userData, uint32_t item, const SpatialRect *bounds) {
+    (void)bounds;
+    PickQuery *query = userData;
+    const NodeStore *store = query->store;
+    uint32_t mesh = store->slotMesh[item];
+    uint32_t index = store->slotIndex[item];
+    if (query->top != NODE_HANDLE_INVALID &&
+        (mesh < store->slotMesh[query->top] ||
+         (mesh == store->slotMesh[query->top] && index < store->slotIndex[query->top]))) {
+        return true;
+    }
+
+    // Map the point into mesh space through the inverse of the instance basis
+    const NodeInstance *instance = &store->batches[mesh].instances[index];
+    const float *m = instance->basis;
+    float det = m[0] * m[3] - m[2] * m[1];
+    if (det == 0.0f) return true;
+    float dx = query->x - instance->translation[0];
+    float dy = query->y - instance->translation[1];
+    float lx = (m[3] * dx - m[2] * dy) / det;
+    float ly = (m[0] * dy - m[1] * dx) / det;
+    if (fabsf(lx) <= meshHalfExtent[mesh] && fabsf(ly) <= meshHalfExtent[mesh]) {
+        query->top = item;
+    }
+    return true;
+}
+
+NodeHandle node_pick(const NodeStore *store, float x, float y) {
+    PickQuery query = { store, x, y, NODE_HANDLE_INVALID };
+    SpatialRect point = { x, y, x, y };
+    spatial_query_rect(&store->spatial, &point, pick_visit, &query);
+    return query.top;
+}
+
+void node_query_rect(const NodeStore *store, const SpatialRect *rect, SpatialVisitor visit, void *userData) {
+    spatial_query_rect(&store->spatial, rect, visit, userData);
+}
+
+NodeHandle node_nearest(const NodeStore *store, float x, float y, float maxDistance) {
+    return spatial_nearest(&store->spatial, x, y, maxDistance);
+}
@@ -0,0 +1,202 @@
+// module_profiler.c
+#include "module_profiler.h"
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t now_ns(const Profiler *profiler) {
+    return SDL_GetTicksNS() - profiler->originNs;
+}
+
+static void record_event(Profiler *profiler, const char *name, uint64_t startNs, uint64_t durationNs,
+                         uint64_t frame, ProfileTrack track, uint32_t depth) {
+    ProfileEvent *event = &profiler->events[profiler->eventCount++ % PROFILER_RING_SIZE];
+    event->name = name;
+    event->startNs = startNs;
+    event->durationNs = durationNs;
+    event->frame = frame;
+    event->track = (uint8_t)track;
+    event->depth = (uint8_t)depth;
+}
+
+bool profiler_init(Profiler *profiler, VkDevice device, VkPhysicalDevice physicalDevice,
+                   uint32_t queueFamily, uint32_t framesInFlight) {
+    memset(profiler, 0, sizeof(Profiler));
+    profiler->device = device;
+    profiler->originNs = SDL_GetTicksNS();
+    profiler->events = calloc(PROFILER_RING_SIZE, sizeof(ProfileEvent));
+    profiler->gpuFrames = calloc(framesInFlight, sizeof(ProfilerGpuFrame));
+    if (!profiler->events || !profiler->gpuFrames) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate profiler buffers");
+        profiler_destroy(profiler);
+        return false;
+    }
+    profiler->gpuFrameCount = framesInFlight;
+
+    // GPU scopes need timestamp support on the queue that records the frame
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, NULL);
+    VkQueueFamilyProperties *families = malloc(familyCount * sizeof(VkQueueFamilyProperties));
+    uint32_t validBits = 0;
+    if (families) {
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families);
+        if (queueFamily < familyCount) validBits = families[queueFamily].timestampValidBits;
+        free(families);
+    }
+    profiler->timestampPeriod = properties.limits.timestampPeriod;
+    profiler->timestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+    profiler->gpuSupported = validBits > 0 && properties.limits.timestampPeriod > 0.0f;
+
+    VkQueryPoolCreateInfo queryPoolInfo = {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = PROFILER_MAX_GPU_SCOPES * 2
+    };
+    for (uint32_t i = 0; profiler->gpuSupported && i < framesInFlight; i++) {
+        if (vkCreateQueryPool(device, &queryPoolInfo, NULL, &profiler->gpuFrames[i].queryPool) != VK_SUCCESS) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to create timestamp query pool, GPU scopes disabled");
+            profiler->gpuSupported = false;
+        }
+    }
+    if (!profiler->gpuSupported) {
+        SDL_Log("Profiler: GPU timestamps unavailable, recording CPU scopes only");
+    }
+    return true;
+}
+
+void profiler_destroy(Profiler *profiler) {
+    for (uint32_t i = 0; profiler->gpuFrames && i < profiler->gpuFrameCount; i++) {
+        if (profiler->gpuFrames[i].queryPool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(profiler->device, profiler->gpuFrames[i].queryPool, NULL);
+        }
+    }
+    free(profiler->gpuFrames);
+    free(profiler->events);
+    memset(profiler, 0, sizeof(Profiler));
+}
+
+void profiler_set_enabled(Profiler *profiler, bool enabled) {
+    // Scopes opened before a toggle can no longer be matched
+    profiler->enabled = enabled && profiler->events != NULL;
+    profiler->cpuDepth = 0;
+    SDL_Log("Profiler %s", profiler->enabled ? "enabled" : "disabled");
+}
+
+void profiler_cpu_begin(Profiler *profiler, const char *name) {
+    if (profiler->cpuDepth == PROFILER_MAX_DEPTH) return;
+    profiler->cpuStack[profiler->cpuDepth].name = name;
+    profiler->cpuStack[profiler->cpuDepth].startNs = now_ns(profiler);
+    profiler->cpuDepth++;
+}
+
+void profiler_cpu_end(Profiler *profiler) {
+    if (profiler->cpuDepth == 0) return;
+    uint32_t depth = --profiler->cpuDepth;
+    uint64_t startNs = profiler->cpuStack[depth].startNs;
+    record_event(profiler, profiler->cpuStack[depth].name, startNs, now_ns(profiler) - startNs,
+                 profiler->frame, PROFILE_TRACK_CPU, depth);
+}
+
+// Convert the slot's timestamps into events placed relative to its submit time
+static void collect_gpu_frame(Profiler *profiler, ProfilerGpuFrame *gpuFrame) {
+    gpuFrame->pending = false;
+    if (gpuFrame->scopeCount == 0) return;
+    uint64_t timestamps[PROFILER_MAX_GPU_SCOPES * 2];
+    VkResult result = vkGetQueryPoolResults(profiler->device, gpuFrame->queryPool, 0, gpuFrame->scopeCount * 2,
+                                            sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) return;
+    uint64_t base = timestamps[0];
+    for (uint32_t i = 0; i < gpuFrame->scopeCount; i++) {
+        uint64_t begin = (timestamps[i * 2] - base) & profiler->timestampMask;
+        uint64_t end = (timestamps[i * 2 + 1] - base) & profiler->timestampMask;
+        uint64_t startNs = gpuFrame->submitNs + (uint64_t)(begin * profiler->timestampPeriod);
+        uint64_t durationNs = end > begin ? (uint64_t)((end - begin) * profiler->timestampPeriod) : 0;
+        record_event(profiler, gpuFrame->names[i], startNs, durationNs, gpuFrame->frame,
+                     PROFILE_TRACK_GPU, gpuFrame->depths[i]);
+    }
+}
+
+void profiler_gpu_frame_begin(Profiler *profiler, VkCommandBuffer commandBuffer, uint32_t frameSlot) {
+    profiler->currentGpuFrame = NULL;
+    if (!profiler->gpuSupported || frameSlot >= profiler->gpuFrameCount) return;
+    ProfilerGpuFrame *gpuFrame = &profiler->gpuFrames[frameSlot];
+    if (gpuFrame->pending) {
+        collect_gpu_frame(profiler, gpuFrame);
+    }
+    if (!profiler->enabled) return;
+
+    vkCmdResetQueryPool(commandBuffer, gpuFrame->queryPool, 0, PROFILER_MAX_GPU_SCOPES * 2);
+    gpuFrame->scopeCount = 0;
+    gpuFrame->openCount = 0;
+    gpuFrame->frame = profiler->frame;
+    profiler->currentGpuFrame = gpuFrame;
+}
+
+void profiler_gpu_frame_end(Profiler *profiler, VkCommandBuffer commandBuffer) {
+    ProfilerGpuFrame *gpuFrame = profiler->currentGpuFrame;
+    if (gpuFrame) {
+        while (gpuFrame->openCount > 0) {
+            profiler_gpu_end(profiler, commandBuffer);
+        }
+        gpuFrame->submitNs = now_ns(profiler);
+        gpuFrame->pending = true;
+        profiler->currentGpuFrame = NULL;
+    }
+    profiler->frame++;
+}
+
+void profiler_gpu_begin(Profiler *profiler, VkCommandBuffer commandBuffer, const char *name) {
+    ProfilerGpuFrame *gpuFrame = profiler->currentGpuFrame;
+    if (gpuFrame->scopeCount == PROFILER_MAX_GPU_SCOPES || gpuFrame->openCount == PROFILER_MAX_DEPTH) return;
+    uint32_t scope = gpuFrame->scopeCount++;
+    gpuFrame->names[scope] = name;
+    gpuFrame->depths[scope] = (uint8_t)gpuFrame->openCount;
+    gpuFrame->openScopes[gpuFrame->openCount++] = scope;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, gpuFrame->queryPool, scope * 2);
+}
+
+void profiler_gpu_end(Profiler *profiler, VkCommandBuffer commandBuffer) {
+    ProfilerGpuFrame *gpuFrame = profiler->currentGpuFrame;
+    if (gpuFrame->openCount == 0) return;
+    uint32_t scope = gpuFrame->openScopes[--gpuFrame->openCount];
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, gpuFrame->queryPool, scope * 2 + 1);
+}
+
+void profiler_collect(Profiler *profiler) {
+    for (uint32_t i = 0; profiler->gpuSupported && i < profiler->gpuFrameCount; i++) {
+        if (profiler->gpuFrames[i].pending) {
+            collect_gpu_frame(profiler, &profiler->gpuFrames[i]);
+        }
+    }
+}
+
+// Chrome trace_event format: complete ("X") events, CPU on thread 1 and GPU on thread 2
+bool profiler_write_trace(const Profiler *profiler, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open trace file %s", path);
+        return false;
+    }
+    fprintf(file, "{\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+    uint64_t count = profiler->eventCount < PROFILER_RING_SIZE ? profiler->eventCount : PROFILER_RING_SIZE;
+    for (uint64_t i = profiler->eventCount - count; i < profiler->eventCount; i++) {
+        const ProfileEvent *event = &profiler->events[i % PROFILER_RING_SIZE];
+        fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"frame\":%llu}}",
+                event->name, event->track == PROFILE_TRACK_GPU ? "gpu" : "cpu",
+                event->startNs / 1000.0, event->durationNs / 1000.0,
+                event->track == PROFILE_TRACK_GPU ? 2 : 1, (unsigned long long)event->frame);
+    }
+    fprintf(file, "\n]}\n");
+    bool success = fclose(file) == 0;
+    if (success) {
+        SDL_Log("Wrote %llu profiler events to %s", (unsigned long long)count, path);
+    } else {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write trace file %s", path);
+    }
+    return success;
+}
@@ -0,0 +1,366 @@
+// module_scheduler.c
+#include "module_scheduler.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SCHEDULER_NONE UINT32_MAX
+#define SCHEDULER_SPINS_PER_YIELD 256 // Idle spins between yields of the time slice
+#define SCHEDULER_WOKEN 0x40000000    // Counter bit set by a changed input; the count lives below it
+
+static SchedulerRing *create_ring(uint32_t capacity) {
+    SchedulerRing *ring = malloc(sizeof(SchedulerRing) + capacity * sizeof(SDL_AtomicInt));
+    if (!ring) return NULL;
+    ring->retired = NULL;
+    ring->mask = capacity - 1;
+    return ring;
+}
+
+static void free_rings(SchedulerRing *ring) {
+    while (ring) {
+        SchedulerRing *retired = ring->retired;
+        free(ring);
+        ring = retired;
+    }
+}
+
+// Between passes only: no thief can be reading the ring being replaced
+static bool reserve_ring(SchedulerWorker *worker, uint32_t entries) {
+    SchedulerRing *ring = worker->ring;
+    if (ring && ring->mask + 1 >= entries) return true;
+    uint32_t capacity = ring ? (ring->mask + 1) * 2 : SCHEDULER_INITIAL_RING;
+    while (capacity < entries) capacity *= 2;
+    SchedulerRing *grown = create_ring(capacity);
+    if (!grown) return false;
+    free_rings(ring);
+    worker->ring = grown;
+    return true;
+}
+
+// Owner only: move the live range [top, bottom) into a ring twice the size
+static SchedulerRing *grow_ring(SchedulerWorker *worker, SchedulerRing *ring, int top, int bottom) {
+    SchedulerRing *grown = create_ring((ring->mask + 1) * 2);
+    if (!grown) return NULL;
+    for (int i = top; i < bottom; i++) {
+        SDL_SetAtomicInt(&grown->items[i & grown->mask], SDL_GetAtomicInt(&ring->items[i & ring->mask]));
+    }
+    grown->retired = ring;
+    SDL_SetAtomicPointer(&worker->ring, grown);
+    return grown;
+}
+
+static bool deque_push(SchedulerWorker *worker, uint32_t node) {
+    int bottom = SDL_GetAtomicInt(&worker->bottom);
+    int top = SDL_GetAtomicInt(&worker->top);
+    SchedulerRing *ring = SDL_GetAtomicPointer(&worker->ring);
+    if ((uint32_t)(bottom - top) > ring->mask) {
+        ring = grow_ring(worker, ring, top, bottom);
+        if (!ring) return false;
+    }
+    SDL_SetAtomicInt(&ring->items[bottom & ring->mask], (int)node);
+    SDL_SetAtomicInt(&worker->bottom, bottom + 1);
+    return true;
+}
+
+static uint32_t deque_pop(SchedulerWorker *worker) {
+    int bottom = SDL_GetAtomicInt(&worker->bottom) - 1;
+    SchedulerRing *ring = SDL_GetAtomicPointer(&worker->ring);
+    SDL_SetAtomicInt(&worker->bottom, bottom);
+    int top = SDL_GetAtomicInt(&worker->top);
+    if (top > bottom) {
+        SDL_SetAtomicInt(&worker->bottom, bottom + 1);
+        return SCHEDULER_NONE;
+    }
+    uint32_t node = (uint32_t)SDL_GetAtomicInt(&ring->items[bottom & ring->mask]);
+    if (top == bottom) {
+        // The last entry goes to whoever moves top first, the owner or a thief
+        if (!SDL_CompareAndSwapAtomicInt(&worker->top, top, top + 1)) node = SCHEDULER_NONE;
+        SDL_SetAtomicInt(&worker->bottom, bottom + 1);
+    }
+    return node;
+}
+
+static uint32_t deque_steal(SchedulerWorker *worker) {
+    int top = SDL_GetAtomicInt(&worker->top);
+    int bottom = SDL_GetAtomicInt(&worker->bottom);
+    if (top >= bottom) return SCHEDULER_NONE;
+    SchedulerRing *ring = SDL_GetAtomicPointer(&worker->ring);
+    uint32_t node = (uint32_t)SDL_GetAtomicInt(&ring->items[top & ring->mask]);
+    if (!SDL_CompareAndSwapAtomicInt(&worker->top, top, top + 1)) return SCHEDULER_NONE;
+    return node;
+}
+
+static void flush_releases(Scheduler *scheduler, SchedulerWorker *worker) {
+    if (worker->released == 0) return;
+    SDL_AddAtomicInt(&scheduler->remaining, -(int)worker->released);
+    worker->released = 0;
+}
+
+// Release one input of a node, marking it woken if that input changed; true for the last input
+static bool count_down(SDL_AtomicInt *counter, bool changed) {
+    if (!changed) return (SDL_AddAtomicInt(counter, -1) & ~SCHEDULER_WOKEN) == 1;
+    int value;
+    do {
+        value = SDL_GetAtomicInt(counter);
+    } while (!SDL_CompareAndSwapAtomicInt(counter, value, (value | SCHEDULER_WOKEN) - 1));
+    return (value & ~SCHEDULER_WOKEN) == 1;
+}
+
+// Run a node whose inputs are all final, then count down its outputs. The first output that
+// becomes ready runs next on this thread; the others go on the deque for anyone to take, or on the
+// worker's spill stack when the deque cannot grow, which this thread empties before returning.
+static void release(Scheduler *scheduler, SchedulerWorker *worker, uint32_t node) {
+    Graph *graph = scheduler->graph;
+    while (node != SCHEDULER_NONE) {
+        bool changed = false;
+        if ((graph->flags[node] & GRAPH_FLAG_SCHEDULED) || (SDL_GetAtomicInt(&scheduler->counters[node]) & SCHEDULER_WOKEN)) {
+            graph->flags[node] &= ~GRAPH_FLAG_SCHEDULED;
+            worker->evaluated++;
+            changed = graph_evaluate_node(graph, node);
+            if (changed) worker->changed++;
+        }
+        uint32_t next = SCHEDULER_NONE;
+        for (uint32_t e = graph->outputOffsets[node]; e < graph->outputOffsets[node + 1]; e++) {
+            // A target still counting down is not running, so its flags are safe to read
+            uint32_t target = graph->outputTargets[e];
+            if (graph->flags[target] & GRAPH_FLAG_CYCLE) continue;
+            if (!count_down(&scheduler->counters[target], changed)) continue;
+            if (next == SCHEDULER_NONE) {
+                next = target;
+            } else if (!deque_push(worker, target)) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow scheduler deque");
+                // Run it here rather than lose it; a node becomes ready once per pass, so its slot is free
+                scheduler->spill[target] = worker->spilled;
+                worker->spilled = target;
+            }
+        }
+        if (++worker->released == SCHEDULER_FLUSH_RELEASES) flush_releases(scheduler, worker);
+        if (next == SCHEDULER_NONE && worker->spilled != SCHEDULER_NONE) {
+            next = worker->spilled;
+            worker->spilled = scheduler->spill[next];
+        }
+        node = next;
+    }
+}
+
+static uint32_t steal(Scheduler *scheduler, uint32_t index) {
+    SchedulerWorker *worker = &scheduler->workers[index];
+    uint32_t victims = scheduler->passThreads - 1;
+    if (victims == 0) return SCHEDULER_NONE;
+    worker->random ^= worker->random << 13;
+    worker->random ^= worker->random >> 17;
+    worker->random ^= worker->random << 5;
+    uint32_t first = worker->random % victims;
+    for (uint32_t v = 0; v < victims; v++) {
+        uint32_t victim = (index + 1 + (first + v) % victims) % scheduler->passThreads;
+        uint32_t node = deque_steal(&scheduler->workers[victim]);
+        if (node != SCHEDULER_NONE) {
+            worker->steals++;
+            return node;
+        }
+    }
+    return SCHEDULER_NONE;
+}
+
+static void run_pass(Scheduler *scheduler, uint32_t index) {
+    Graph *graph = scheduler->graph;
+    SchedulerWorker *worker = &scheduler->workers[index];
+    SDL_SetAtomicInt(&worker->top, 0);
+    SDL_SetAtomicInt(&worker->bottom, 0);
+    worker->evaluated = worker->changed = worker->steals = worker->released = 0;
+    worker->spilled = SCHEDULER_NONE;
+
+    // Count the inputs of this worker's slice of the order that are part of the pass; nodes with
+    // none start out on its deque. Nobody releases anything until every slice is counted.
+    uint32_t begin = scheduler->begin;
+    uint32_t count = graph->orderCount - begin;
+    uint32_t first = begin + (uint32_t)((uint64_t)count * index / scheduler->passThreads);
+    uint32_t last = begin + (uint32_t)((uint64_t)count * (index + 1) / scheduler->passThreads);
+    for (uint32_t i = first; i < last; i++) {
+        uint32_t node = graph->order[i];
+        const uint32_t *sources = &graph->inputSources[graph->portBase[node]];
+        int inputs = 0;
+        for (uint32_t p = 0; p < graph->portCounts[node]; p++) {
+            if (sources[p] != GRAPH_NODE_INVALID && graph->ranks[sources[p]] >= begin) inputs++;
+        }
+        scheduler->counters[node].value = inputs; // Published by the barrier below
+        if (inputs == 0) deque_push(worker, node); // Reserved for the whole slice, cannot fail
+    }
+    SDL_AddAtomicInt(&scheduler->initPending, -1);
+    for (uint32_t spins = 1; SDL_GetAtomicInt(&scheduler->initPending) > 0; spins++) {
+        if (spins % SCHEDULER_SPINS_PER_YIELD == 0) SDL_Delay(0);
+        else SDL_CPUPauseInstruction();
+    }
+
+    uint32_t idle = 0;
+    for (;;) {
+        uint32_t node = deque_pop(worker);
+        if (node == SCHEDULER_NONE) node = steal(scheduler, index);
+        if (node != SCHEDULER_NONE) {
+            release(scheduler, worker, node);
+            idle = 0;
+            continue;
+        }
+        flush_releases(scheduler, worker);
+        if (SDL_GetAtomicInt(&scheduler->remaining) == 0) break;
+        // Give the core up now and then, in case the thread that holds the work shares it
+        if (++idle % SCHEDULER_SPINS_PER_YIELD == 0) SDL_Delay(0);
+        else SDL_CPUPauseInstruction();
+    }
+}
+
+static int worker_main(void *data) {
+    SchedulerWorker *worker = data;
+    Scheduler *scheduler = worker->scheduler;
+    uint32_t index = (uint32_t)(worker - scheduler->workers);
+    uint32_t seen = 0;
+    SDL_LockMutex(scheduler->mutex);
+    for (;;) {
+        while (!scheduler->quit && scheduler->generation == seen) {
+            SDL_WaitCondition(scheduler->workReady, scheduler->mutex);
+        }
+        if (scheduler->quit) break;
+        seen = scheduler->generation;
+        SDL_UnlockMutex(scheduler->mutex);
+        run_pass(scheduler, index);
+        SDL_LockMutex(scheduler->mutex);
+        if (--scheduler->active == 0) SDL_SignalCondition(scheduler->workDone);
+    }
+    SDL_UnlockMutex(scheduler->mutex);
+    return 0;
+}
+
+static bool grow_counters(Scheduler *scheduler, uint32_t capacity) {
+    SDL_AtomicInt *counters = realloc(scheduler->counters, capacity * sizeof(SDL_AtomicInt));
+    if (!counters) return false;
+    scheduler->counters = counters;
+    uint32_t *spill = realloc(scheduler->spill, capacity * sizeof(uint32_t));
+    if (!spill) return false;
+    scheduler->spill = spill;
+    scheduler->counterCapacity = capacity;
+    return true;
+}
+
+// GraphExecutor.sweep; returns false, having run nothing, when memory for the pass is short
+static bool scheduler_sweep(void *userData, Graph *graph, uint32_t begin, uint32_t *evaluated, uint32_t *changed) {
+    Scheduler *scheduler = userData;
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (graph->nodeCount > scheduler->counterCapacity && !grow_counters(scheduler, graph->nodeCapacity)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow scheduler counters");
+        return false;
+    }
+    uint32_t threads = scheduler->serial ? 1 : scheduler->threadCount;
+    uint32_t count = graph->orderCount - begin;
+    for (uint32_t w = 0; w < threads; w++) {
+        uint32_t slice = (uint32_t)((uint64_t)count * (w + 1) / threads - (uint64_t)count * w / threads);
+        if (!reserve_ring(&scheduler->workers[w], slice)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow scheduler deque");
+            return false;
+        }
+    }
+
+    scheduler->graph = graph;
+    scheduler->begin = begin;
+    scheduler->passThreads = threads;
+    SDL_SetAtomicInt(&scheduler->remaining, (int)count);
+    SDL_SetAtomicInt(&scheduler->initPending, (int)threads);
+    if (threads > 1) {
+        SDL_LockMutex(scheduler->mutex);
+        scheduler->generation++;
+        scheduler->active = threads - 1;
+        SDL_BroadcastCondition(scheduler->workReady);
+        SDL_UnlockMutex(scheduler->mutex);
+    }
+    run_pass(scheduler, 0);
+    if (threads > 1) {
+        SDL_LockMutex(scheduler->mutex);
+        while (scheduler->active > 0) {
+            SDL_WaitCondition(scheduler->workDone, scheduler->mutex);
+        }
+        SDL_UnlockMutex(scheduler->mutex);
+    }
+
+    for (uint32_t w = 0; w < threads; w++) {
+        SchedulerWorker *worker = &scheduler->workers[w];
+        *evaluated += worker->evaluated;
+        *changed += worker->changed;
+        scheduler->stats.steals += worker->steals;
+        SchedulerRing *ring = worker->ring;
+        free_rings(ring->retired);
+        ring->retired = NULL;
+    }
+    scheduler->graph = NULL;
+    scheduler->stats.passes++;
+    scheduler->stats.lastThreads = threads;
+    scheduler->stats.lastPassMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    return true;
+}
+
+bool scheduler_init(Scheduler *scheduler, uint32_t threads) {
+    memset(scheduler, 0, sizeof(Scheduler));
+    if (threads == 0) threads = (uint32_t)SDL_GetNumLogicalCPUCores();
+    threads = SDL_clamp(threads, 1, SCHEDULER_MAX_THREADS);
+    scheduler->workers = calloc(threads, sizeof(SchedulerWorker));
+    if (!scheduler->workers) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate scheduler workers");
+        return false;
+    }
+    for (uint32_t w = 0; w < threads; w++) {
+        scheduler->workers[w].scheduler = scheduler;
+        scheduler->workers[w].random = w * 0x9e3779b9u + 1;
+    }
+    scheduler->threadCount = 1;
+    if (threads == 1) return true;
+
+    scheduler->mutex = SDL_CreateMutex();
+    scheduler->workReady = SDL_CreateCondition();
+    scheduler->workDone = SDL_CreateCondition();
+    scheduler->threads = calloc(threads - 1, sizeof(SDL_Thread *));
+    if (!scheduler->mutex || !scheduler->workReady || !scheduler->workDone || !scheduler->threads) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create scheduler: %s", SDL_GetError());
+        scheduler_destroy(scheduler);
+        return false;
+    }
+    for (uint32_t i = 0; i < threads - 1; i++) {
+        scheduler->threads[i] = SDL_CreateThread(worker_main, "graph worker", &scheduler->workers[i + 1]);
+        if (!scheduler->threads[i]) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create graph worker %u: %s", i, SDL_GetError());
+            scheduler_destroy(scheduler);
+            return false;
+        }
+        scheduler->threadCount++;
+    }
+    return true;
+}
+
+// Safe to call on a partially initialized (zeroed) scheduler
+void scheduler_destroy(Scheduler *scheduler) {
+    if (scheduler->mutex) {
+        SDL_LockMutex(scheduler->mutex);
+        scheduler->quit = true;
+        SDL_BroadcastCondition(scheduler->workReady);
+        SDL_UnlockMutex(scheduler->mutex);
+    }
+    for (uint32_t i = 0; i + 1 < scheduler->threadCount; i++) {
+        SDL_WaitThread(scheduler->threads[i], NULL);
+    }
+    for (uint32_t w = 0; w < scheduler->threadCount; w++) {
+        free_rings(scheduler->workers[w].ring);
+    }
+    free(scheduler->threads);
+    free(scheduler->workers);
+    free(scheduler->counters);
+    free(scheduler->spill);
+    SDL_DestroyCondition(scheduler->workDone);
+    SDL_DestroyCondition(scheduler->workReady);
+    SDL_DestroyMutex(scheduler->mutex);
+    memset(scheduler, 0, sizeof(Scheduler));
+}
+
+void scheduler_set_serial(Scheduler *scheduler, bool serial) {
+    scheduler->serial = serial;
+}
+
+void scheduler_attach(Scheduler *scheduler, Graph *graph) {
+    GraphExecutor executor = { scheduler_sweep, scheduler };
+    graph_set_executor(graph, &executor);
+}
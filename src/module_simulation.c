@@ -0,0 +1,161 @@
+// module_simulation.c
+#include "module_simulation.h"
+#include <stdlib.h>
+#include <string.h>
+
+static Uint64 period_ns(uint32_t rate) {
+    return SDL_NS_PER_SECOND / (rate ? rate : SIMULATION_DEFAULT_RATE);
+}
+
+static uint32_t drain_inputs(Simulation *simulation) {
+    SimulationInputQueue *queue = &simulation->inputs;
+    uint32_t head = (uint32_t)SDL_GetAtomicInt(&queue->head);
+    uint32_t tail = (uint32_t)SDL_GetAtomicInt(&queue->tail);
+    for (; head != tail; head++) {
+        const SimulationInput *input = &queue->items[head & (SIMULATION_INPUT_CAPACITY - 1)];
+        if (input->type == SIMULATION_INPUT_SET_VARIABLE) {
+            graph_set_variable(simulation->graph, input->node, input->value);
+        } else if (input->type == SIMULATION_INPUT_SET_RATE && input->value >= 1.0f) {
+            simulation->periodNs = period_ns((uint32_t)input->value);
+        }
+    }
+    // Hands the drained items back to the producer
+    SDL_SetAtomicInt(&queue->head, (int)head);
+    return head;
+}
+
+static void integrate(Simulation *simulation) {
+    Graph *graph = simulation->graph;
+    for (uint32_t i = 0; i < simulation->integratorCount; i++) {
+        const SimulationIntegrator *integrator = &simulation->integrators[i];
+        float rate, value;
+        if (!graph_get_value(graph, integrator->rate, &rate) || !graph_get_value(graph, integrator->target, &value)) continue;
+        value += rate;
+        if (integrator->wrap > 0.0f) {
+            value = SDL_fmodf(value, integrator->wrap);
+            if (value < 0.0f) value += integrator->wrap;
+        }
+        graph_set_variable(graph, integrator->target, value);
+    }
+}
+
+// Copy the graph into the back snapshot and swap it with the middle one
+static void publish(Simulation *simulation, uint32_t inputs, uint64_t skipped, Uint64 tickNs) {
+    const Graph *graph = simulation->graph;
+    SimulationSnapshot *snapshot = &simulation->snapshots[simulation->back];
+    if (graph->nodeCount > snapshot->capacity) {
+        float *values = realloc(snapshot->values, graph->nodeCount * sizeof(float));
+        if (!values) return; // The render thread keeps the previous tick
+        snapshot->values = values;
+        snapshot->capacity = graph->nodeCount;
+    }
+    memcpy(snapshot->values, graph->values, graph->nodeCount * sizeof(float));
+    snapshot->count = graph->nodeCount;
+    snapshot->tick = graph->stats.ticks;
+    snapshot->skipped = skipped;
+    snapshot->tickNs = tickNs;
+    snapshot->inputs = inputs;
+    snapshot->publishedNs = SDL_GetTicksNS();
+    simulation->back = (uint32_t)SDL_SetAtomicInt(&simulation->middle, (int)(simulation->back | SIMULATION_SNAPSHOT_FRESH)) &
+                       ~SIMULATION_SNAPSHOT_FRESH;
+}
+
+static int simulation_main(void *data) {
+    Simulation *simulation = data;
+    uint64_t skipped = 0;
+    Uint64 next = SDL_GetTicksNS();
+    while (!SDL_GetAtomicInt(&simulation->quit)) {
+        Uint64 now = SDL_GetTicksNS();
+        if (now < next) {
+            SDL_DelayPrecise(next - now);
+            continue;
+        }
+        // Past a stall, skip ahead rather than running the whole backlog in a burst
+        Uint64 behind = now - next;
+        if (behind > simulation->periodNs * SIMULATION_MAX_CATCHUP) {
+            skipped += behind / simulation->periodNs;
+            next = now;
+        }
+        uint32_t inputs = drain_inputs(simulation);
+        // Before the tick, so nodes reading an integrated variable see this tick's value
+        integrate(simulation);
+        graph_tick(simulation->graph);
+        publish(simulation, inputs, skipped, SDL_GetTicksNS() - now);
+        next += simulation->periodNs;
+    }
+    return 0;
+}
+
+bool simulation_init(Simulation *simulation, Graph *graph, uint32_t rate, const SimulationIntegrator *integrators,
+                     uint32_t integratorCount) {
+    memset(simulation, 0, sizeof(Simulation));
+    if (integratorCount > SIMULATION_MAX_INTEGRATORS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Too many simulation integrators: %u", integratorCount);
+        return false;
+    }
+    simulation->graph = graph;
+    simulation->periodNs = period_ns(rate);
+    if (integratorCount > 0) memcpy(simulation->integrators, integrators, integratorCount * sizeof(SimulationIntegrator));
+    simulation->integratorCount = integratorCount;
+    simulation->front = 0;
+    SDL_SetAtomicInt(&simulation->middle, 1);
+    simulation->back = 2;
+    simulation->stats.loggedNs = SDL_GetTicksNS();
+    simulation->thread = SDL_CreateThread(simulation_main, "simulation", simulation);
+    if (!simulation->thread) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create simulation thread: %s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+void simulation_destroy(Simulation *simulation) {
+    if (simulation->thread) {
+        SDL_SetAtomicInt(&simulation->quit, 1);
+        SDL_WaitThread(simulation->thread, NULL);
+    }
+    for (uint32_t i = 0; i < SDL_arraysize(simulation->snapshots); i++) {
+        free(simulation->snapshots[i].values);
+    }
+    memset(simulation, 0, sizeof(Simulation));
+}
+
+bool simulation_push_input(Simulation *simulation, const SimulationInput *input) {
+    SimulationInputQueue *queue = &simulation->inputs;
+    uint32_t tail = (uint32_t)SDL_GetAtomicInt(&queue->tail);
+    if (tail - (uint32_t)SDL_GetAtomicInt(&queue->head) == SIMULATION_INPUT_CAPACITY) {
+        simulation->stats.inputsDropped++;
+        return false;
+    }
+    queue->items[tail & (SIMULATION_INPUT_CAPACITY - 1)] = *input;
+    // Publishes the item to the simulation thread
+    SDL_SetAtomicInt(&queue->tail, (int)(tail + 1));
+    return true;
+}
+
+const SimulationSnapshot *simulation_acquire_snapshot(Simulation *simulation) {
+    if (SDL_GetAtomicInt(&simulation->middle) & SIMULATION_SNAPSHOT_FRESH) {
+        simulation->front = (uint32_t)SDL_SetAtomicInt(&simulation->middle, (int)simulation->front) & ~SIMULATION_SNAPSHOT_FRESH;
+        simulation->stats.framesRead++;
+    }
+    const SimulationSnapshot *snapshot = &simulation->snapshots[simulation->front];
+    if (snapshot->tick == 0) return NULL;
+    SimulationStats *stats = &simulation->stats;
+    stats->lastAgeMs = (SDL_GetTicksNS() - snapshot->publishedNs) / 1e6;
+    if (stats->lastAgeMs > stats->worstAgeMs) stats->worstAgeMs = stats->lastAgeMs;
+    return snapshot;
+}
+
+void simulation_log_stats(Simulation *simulation) {
+    SimulationStats *stats = &simulation->stats;
+    const SimulationSnapshot *snapshot = &simulation->snapshots[simulation->front];
+    Uint64 now = SDL_GetTicksNS();
+    double seconds = (now - stats->loggedNs) / 1e9;
+    SDL_Log("Simulation: %.1f ticks/s, tick %.3f ms, snapshot age %.2f ms (worst %.2f ms), %llu ticks skipped, %llu inputs dropped",
+            seconds > 0.0 ? (snapshot->tick - stats->loggedTick) / seconds : 0.0, snapshot->tickNs / 1e6,
+            stats->lastAgeMs, stats->worstAgeMs, (unsigned long long)snapshot->skipped,
+            (unsigned long long)stats->inputsDropped);
+    stats->loggedTick = snapshot->tick;
+    stats->loggedNs = now;
+    stats->worstAgeMs = 0.0;
+}
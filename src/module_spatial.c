@@ -0,0 +1,250 @@
+// module_spatial.c
+#include "module_spatial.h"
+#include <SDL3/SDL.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPATIAL_INITIAL_CELLS 256
+#define SPATIAL_CELL_LIMIT 1073741824.0f // Cell coordinates are clamped to +-2^30 so ring math cannot overflow
+
+static int32_t cell_coord(const SpatialIndex *index, float value) {
+    float cell = floorf(value * index->inverseCellSize);
+    return (int32_t)SDL_clamp(cell, -SPATIAL_CELL_LIMIT, SPATIAL_CELL_LIMIT);
+}
+
+static uint32_t cell_hash(int32_t x, int32_t y) {
+    uint32_t h = (uint32_t)x * 0x8da6b343u ^ (uint32_t)y * 0xd8163841u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    return h;
+}
+
+static SpatialCell *find_cell(const SpatialIndex *index, int32_t x, int32_t y) {
+    if (index->cellCapacity == 0) return NULL;
+    uint32_t mask = index->cellCapacity - 1;
+    for (uint32_t i = cell_hash(x, y) & mask;; i = (i + 1) & mask) {
+        SpatialCell *cell = &index->cells[i];
+        if (!cell->used) return NULL;
+        if (cell->x == x && cell->y == y) return cell;
+    }
+}
+
+// Rehash into a table twice the size; cells move with their item arrays, so item slots stay valid
+static bool grow_cells(SpatialIndex *index) {
+    uint32_t capacity = index->cellCapacity ? index->cellCapacity * 2 : SPATIAL_INITIAL_CELLS;
+    SpatialCell *cells = calloc(capacity, sizeof(SpatialCell));
+    if (!cells) return false;
+    for (uint32_t c = 0; c < index->cellCapacity; c++) {
+        SpatialCell *cell = &index->cells[c];
+        if (!cell->used) continue;
+        uint32_t i = cell_hash(cell->x, cell->y) & (capacity - 1);
+        while (cells[i].used) i = (i + 1) & (capacity - 1);
+        cells[i] = *cell;
+    }
+    free(index->cells);
+    index->cells = cells;
+    index->cellCapacity = capacity;
+    return true;
+}
+
+static SpatialCell *get_cell(SpatialIndex *index, int32_t x, int32_t y) {
+    SpatialCell *cell = find_cell(index, x, y);
+    if (cell) return cell;
+    // Keep the load factor at or below one half
+    if ((index->cellCount + 1) * 2 > index->cellCapacity && !grow_cells(index)) return NULL;
+    uint32_t mask = index->cellCapacity - 1;
+    uint32_t i = cell_hash(x, y) & mask;
+    while (index->cells[i].used) i = (i + 1) & mask;
+    cell = &index->cells[i];
+    *cell = (SpatialCell){ .x = x, .y = y, .used = true };
+    if (index->cellCount == 0) {
+        index->minCellX = index->maxCellX = x;
+        index->minCellY = index->maxCellY = y;
+    } else {
+        index->minCellX = SDL_min(index->minCellX, x);
+        index->maxCellX = SDL_max(index->maxCellX, x);
+        index->minCellY = SDL_min(index->minCellY, y);
+        index->maxCellY = SDL_max(index->maxCellY, y);
+    }
+    index->cellCount++;
+    return cell;
+}
+
+void spatial_init(SpatialIndex *index, float cellSize) {
+    memset(index, 0, sizeof(SpatialIndex));
+    index->cellSize = cellSize > 0.0f ? cellSize : SPATIAL_CELL_SIZE;
+    index->inverseCellSize = 1.0f / index->cellSize;
+}
+
+void spatial_destroy(SpatialIndex *index) {
+    for (uint32_t c = 0; c < index->cellCapacity; c++) {
+        free(index->cells[c].items);
+    }
+    free(index->cells);
+    free(index->items);
+    spatial_init(index, index->cellSize);
+}
+
+static bool grow_items(SpatialIndex *index, uint32_t item) {
+    uint32_t capacity = index->itemCapacity ? index->itemCapacity : 64;
+    while (capacity <= item) capacity *= 2;
+    SpatialItem *items = realloc(index->items, capacity * sizeof(SpatialItem));
+    if (!items) return false;
+    for (uint32_t i = index->itemCapacity; i < capacity; i++) {
+        items[i].slot = SPATIAL_ITEM_INVALID;
+    }
+    index->items = items;
+    index->itemCapacity = capacity;
+    return true;
+}
+
+bool spatial_insert(SpatialIndex *index, uint32_t item, const SpatialRect *bounds) {
+    if (item >= index->itemCapacity && !grow_items(index, item)) return false;
+    if (index->items[item].slot != SPATIAL_ITEM_INVALID) spatial_remove(index, item);
+
+    int32_t cellX = cell_coord(index, (bounds->minX + bounds->maxX) * 0.5f);
+    int32_t cellY = cell_coord(index, (bounds->minY + bounds->maxY) * 0.5f);
+    SpatialCell *cell = get_cell(index, cellX, cellY);
+    if (!cell) return false;
+    if (cell->count == cell->capacity) {
+        uint32_t capacity = cell->capacity ? cell->capacity * 2 : 8;
+        uint32_t *items = realloc(cell->items, capacity * sizeof(uint32_t));
+        if (!items) return false;
+        cell->items = items;
+        cell->capacity = capacity;
+    }
+
+    SpatialItem *entry = &index->items[item];
+    entry->bounds = *bounds;
+    entry->cellX = cellX;
+    entry->cellY = cellY;
+    entry->slot = cell->count;
+    cell->items[cell->count++] = item;
+    index->maxHalfWidth = SDL_max(index->maxHalfWidth, (bounds->maxX - bounds->minX) * 0.5f);
+    index->maxHalfHeight = SDL_max(index->maxHalfHeight, (bounds->maxY - bounds->minY) * 0.5f);
+    index->count++;
+    return true;
+}
+
+bool spatial_update(SpatialIndex *index, uint32_t item, const SpatialRect *bounds) {
+    if (item >= index->itemCapacity || index->items[item].slot == SPATIAL_ITEM_INVALID) {
+        return spatial_insert(index, item, bounds);
+    }
+    SpatialItem *entry = &index->items[item];
+    if (cell_coord(index, (bounds->minX + bounds->maxX) * 0.5f) != entry->cellX ||
+        cell_coord(index, (bounds->minY + bounds->maxY) * 0.5f) != entry->cellY) {
+        spatial_remove(index, item);
+        return spatial_insert(index, item, bounds);
+    }
+    entry->bounds = *bounds;
+    index->maxHalfWidth = SDL_max(index->maxHalfWidth, (bounds->maxX - bounds->minX) * 0.5f);
+    index->maxHalfHeight = SDL_max(index->maxHalfHeight, (bounds->maxY - bounds->minY) * 0.5f);
+    return true;
+}
+
+void spatial_remove(SpatialIndex *index, uint32_t item) {
+    if (item >= index->itemCapacity || index->items[item].slot == SPATIAL_ITEM_INVALID) return;
+    SpatialItem *entry = &index->items[item];
+    SpatialCell *cell = find_cell(index, entry->cellX, entry->cellY);
+    // Swap the cell's last item into the hole
+    uint32_t last = cell->items[--cell->count];
+    if (entry->slot != cell->count) {
+        cell->items[entry->slot] = last;
+        index->items[last].slot = entry->slot;
+    }
+    entry->slot = SPATIAL_ITEM_INVALID;
+    index->count--;
+}
+
+static bool overlaps(const SpatialRect *a, const SpatialRect *b) {
+    return a->minX <= b->maxX && a->maxX >= b->minX && a->minY <= b->maxY && a->maxY >= b->minY;
+}
+
+static bool visit_cell(const SpatialIndex *index, const SpatialCell *cell, const SpatialRect *rect,
+                       SpatialVisitor visit, void *userData) {
+    for (uint32_t i = 0; i < cell->count; i++) {
+        uint32_t item = cell->items[i];
+        const SpatialRect *bounds = &index->items[item].bounds;
+        if (overlaps(bounds, rect) && !visit(userData, item, bounds)) return false;
+    }
+    return true;
+}
+
+void spatial_query_rect(const SpatialIndex *index, const SpatialRect *rect, SpatialVisitor visit, void *userData) {
+    if (index->count == 0) return;
+    int32_t x0 = SDL_max(cell_coord(index, rect->minX - index->maxHalfWidth), index->minCellX);
+    int32_t x1 = SDL_min(cell_coord(index, rect->maxX + index->maxHalfWidth), index->maxCellX);
+    int32_t y0 = SDL_max(cell_coord(index, rect->minY - index->maxHalfHeight), index->minCellY);
+    int32_t y1 = SDL_min(cell_coord(index, rect->maxY + index->maxHalfHeight), index->maxCellY);
+    if (x0 > x1 || y0 > y1) return;
+
+    // A query wider than the populated area is cheaper as a walk over the used cells
+    uint64_t span = (uint64_t)(x1 - x0 + 1) * (uint64_t)(y1 - y0 + 1);
+    if (span > index->cellCount) {
+        for (uint32_t c = 0; c < index->cellCapacity; c++) {
+            const SpatialCell *cell = &index->cells[c];
+            if (!cell->used || cell->x < x0 || cell->x > x1 || cell->y < y0 || cell->y > y1) continue;
+            if (!visit_cell(index, cell, rect, visit, userData)) return;
+        }
+        return;
+    }
+    for (int32_t y = y0; y <= y1; y++) {
+        for (int32_t x = x0; x <= x1; x++) {
+            const SpatialCell *cell = find_cell(index, x, y);
+            if (cell && !visit_cell(index, cell, rect, visit, userData)) return;
+        }
+    }
+}
+
+static float distance_to(const SpatialRect *bounds, float x, float y) {
+    float dx = SDL_max(SDL_max(bounds->minX - x, x - bounds->maxX), 0.0f);
+    float dy = SDL_max(SDL_max(bounds->minY - y, y - bounds->maxY), 0.0f);
+    return sqrtf(dx * dx + dy * dy);
+}
+
+static void nearest_in_cell(const SpatialIndex *index, int32_t x, int32_t y, float px, float py,
+                            uint32_t *best, float *bestDistance) {
+    if (x < index->minCellX || x > index->maxCellX || y < index->minCellY || y > index->maxCellY) return;
+    const SpatialCell *cell = find_cell(index, x, y);
+    if (!cell) return;
+    for (uint32_t i = 0; i < cell->count; i++) {
+        uint32_t item = cell->items[i];
+        float distance = distance_to(&index->items[item].bounds, px, py);
+        if (distance <= *bestDistance) {
+            *best = item;
+            *bestDistance = distance;
+        }
+    }
+}
+
+// Search square rings of cells outward from the point (clamped onto the used range). An item
+// centered in ring r is at least (r - 1) cells minus its half diagonal away, which ends the search.
+uint32_t spatial_nearest(const SpatialIndex *index, float x, float y, float maxDistance) {
+    if (index->count == 0) return SPATIAL_ITEM_INVALID;
+    int32_t cx = SDL_clamp(cell_coord(index, x), index->minCellX, index->maxCellX);
+    int32_t cy = SDL_clamp(cell_coord(index, y), index->minCellY, index->maxCellY);
+    int32_t maxRing = SDL_max(SDL_max(cx - index->minCellX, index->maxCellX - cx),
+                              SDL_max(cy - index->minCellY, index->maxCellY - cy));
+    float halfDiagonal = sqrtf(index->maxHalfWidth * index->maxHalfWidth + index->maxHalfHeight * index->maxHalfHeight);
+
+    uint32_t best = SPATIAL_ITEM_INVALID;
+    float bestDistance = maxDistance;
+    for (int32_t r = 0; r <= maxRing; r++) {
+        if ((r - 1) * index->cellSize - halfDiagonal > bestDistance) break;
+        if (r == 0) {
+            nearest_in_cell(index, cx, cy, x, y, &best, &bestDistance);
+            continue;
+        }
+        for (int32_t i = -r; i <= r; i++) {
+            nearest_in_cell(index, cx + i, cy - r, x, y, &best, &bestDistance);
+            nearest_in_cell(index, cx + i, cy + r, x, y, &best, &bestDistance);
+        }
+        for (int32_t i = -r + 1; i <= r - 1; i++) {
+            nearest_in_cell(index, cx - r, cy + i, x, y, &best, &bestDistance);
+            nearest_in_cell(index, cx + r, cy + i, x, y, &best, &bestDistance);
+        }
+    }
+    return best;
+}
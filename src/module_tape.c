@@ -0,0 +1,296 @@
+// module_tape.c
+#include "module_tape.h"
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Grow array by doubling until needed entries fit
+#define RESERVE_ARRAY(array, capacity, needed) do { \
+        if ((needed) > (capacity)) { \
+            uint32_t grown = (capacity) ? (capacity) : 256; \
+            while (grown < (needed)) grown *= 2; \
+            void *resized = realloc((array), grown * sizeof(*(array))); \
+            if (!resized) return false; \
+            (array) = resized; \
+            (capacity) = grown; \
+        } \
+    } while (0)
+
+static bool reserve_nodes(Tape *tape, uint32_t nodes) {
+    if (nodes <= tape->nodeCapacity) return true;
+    uint32_t old = tape->nodeCapacity;
+    uint32_t capacity = old;
+    RESERVE_ARRAY(tape->nodeInstruction, capacity, nodes);
+    capacity = old;
+    RESERVE_ARRAY(tape->nodeRegister, capacity, nodes);
+    capacity = old;
+    RESERVE_ARRAY(tape->nodeFlags, capacity, nodes);
+    memset(&tape->nodeInstruction[old], 0xff, (capacity - old) * sizeof(uint32_t));
+    memset(&tape->nodeRegister[old], 0xff, (capacity - old) * sizeof(uint32_t));
+    memset(&tape->nodeFlags[old], 0, capacity - old);
+    tape->nodeCapacity = capacity;
+    return true;
+}
+
+static bool is_nary(const TapeInstruction *instruction) {
+    return instruction->opcode >= TAPE_OP_ADDN && instruction->opcode <= TAPE_OP_MAXN;
+}
+
+// Write the node's instruction at index; its register and those of its inputs are assigned. In
+// place, an N-input instruction reuses the operands of the one it replaces when they fit.
+static bool emit(Tape *tape, uint32_t node, uint32_t index, bool inPlace) {
+    const Graph *graph = tape->graph;
+    uint32_t previousBase = 0, previousCount = 0;
+    if (inPlace && is_nary(&tape->code[index])) {
+        previousBase = tape->code[index].a;
+        previousCount = tape->code[index].count;
+    }
+    TapeInstruction instruction = { .output = tape->nodeRegister[node] };
+    if (graph->kinds[node] == GRAPH_NODE_VARIABLE) {
+        instruction.opcode = TAPE_OP_LOAD;
+        instruction.a = node;
+    } else if (graph->kinds[node] == GRAPH_NODE_TICK) {
+        instruction.opcode = TAPE_OP_TICK;
+    } else {
+        uint32_t inputs[GRAPH_MAX_PORTS];
+        uint32_t n = 0;
+        const uint32_t *sources = &graph->inputSources[graph->portBase[node]];
+        for (uint32_t p = 0; p < graph->portCounts[node]; p++) {
+            if (sources[p] != GRAPH_NODE_INVALID) inputs[n++] = tape->nodeRegister[sources[p]];
+        }
+        // The 2- and N-input opcodes list the ops in GraphOp order
+        GraphOp op = graph->ops[node];
+        if (n == 0) {
+            instruction.opcode = TAPE_OP_CONST;
+            instruction.a = op == GRAPH_OP_MUL ? 1 : 0;
+        } else if (n == 1) {
+            instruction.opcode = TAPE_OP_COPY;
+            instruction.a = inputs[0];
+        } else if (n == 2) {
+            instruction.opcode = (uint8_t)(TAPE_OP_ADD2 + op);
+            instruction.a = inputs[0];
+            instruction.b = inputs[1];
+        } else if (n <= previousCount) {
+            memcpy(&tape->operands[previousBase], inputs, n * sizeof(uint32_t));
+            instruction.opcode = (uint8_t)(TAPE_OP_ADDN + op);
+            instruction.count = (uint8_t)n;
+            instruction.a = previousBase;
+            previousCount -= n; // Only the tail of the old slot is lost
+        } else {
+            RESERVE_ARRAY(tape->operands, tape->operandCapacity, tape->operandCount + n);
+            memcpy(&tape->operands[tape->operandCount], inputs, n * sizeof(uint32_t));
+            instruction.opcode = (uint8_t)(TAPE_OP_ADDN + op);
+            instruction.count = (uint8_t)n;
+            instruction.a = tape->operandCount;
+            tape->operandCount += n;
+        }
+    }
+    tape->orphanedOperands += previousCount;
+    tape->code[index] = instruction;
+    return true;
+}
+
+// Every connected input must already be on the tape, ahead of index
+static bool inputs_precede(const Tape *tape, uint32_t node, uint32_t index) {
+    const Graph *graph = tape->graph;
+    const uint32_t *sources = &graph->inputSources[graph->portBase[node]];
+    for (uint32_t p = 0; p < graph->portCounts[node]; p++) {
+        if (sources[p] == GRAPH_NODE_INVALID) continue;
+        uint32_t source = tape->nodeInstruction[sources[p]];
+        if (source == TAPE_NONE || source >= index) return false;
+    }
+    return true;
+}
+
+// Lay the graph's order out as the tape, register i being written by instruction i
+static bool compile(Tape *tape) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    Graph *graph = tape->graph;
+    if (!graph_update_topology(graph) || !reserve_nodes(tape, graph->nodeCapacity)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to compile graph tape");
+        return false;
+    }
+    RESERVE_ARRAY(tape->code, tape->capacity, graph->orderCount);
+    RESERVE_ARRAY(tape->registers, tape->registerCapacity, graph->orderCount);
+    // An empty graph leaves the tables unallocated
+    if (graph->nodeCount > 0) {
+        memset(tape->nodeInstruction, 0xff, graph->nodeCount * sizeof(uint32_t));
+        memset(tape->nodeRegister, 0xff, graph->nodeCount * sizeof(uint32_t));
+        memset(tape->nodeFlags, 0, graph->nodeCount);
+        memset(tape->registers, 0, graph->orderCount * sizeof(float));
+    }
+    for (uint32_t i = 0; i < graph->orderCount; i++) {
+        tape->nodeInstruction[graph->order[i]] = i;
+        tape->nodeRegister[graph->order[i]] = i;
+    }
+    tape->count = graph->orderCount;
+    tape->registerCount = graph->orderCount;
+    tape->operandCount = 0;
+    tape->orphanedOperands = 0;
+    tape->nops = 0;
+    for (uint32_t i = 0; i < graph->orderCount; i++) {
+        if (!emit(tape, graph->order[i], i, false)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow graph tape operands");
+            tape->stale = true;
+            return false;
+        }
+    }
+    tape->editedCount = 0;
+    tape->stale = false;
+    tape->stats.compiles++;
+    tape->stats.lastCompileMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    return true;
+}
+
+static bool flag_edit(Tape *tape, uint32_t node, uint8_t flag) {
+    if (!reserve_nodes(tape, tape->graph->nodeCapacity)) return false;
+    if (tape->nodeFlags[node]) {
+        tape->nodeFlags[node] |= flag;
+        return true;
+    }
+    RESERVE_ARRAY(tape->edited, tape->editedCapacity, tape->editedCount + 1);
+    tape->nodeFlags[node] = flag;
+    tape->edited[tape->editedCount++] = node;
+    return true;
+}
+
+// An edit the tape cannot record is caught up by compiling from scratch
+static void node_added(void *userData, GraphNodeHandle node) {
+    Tape *tape = userData;
+    if (!flag_edit(tape, node, TAPE_FLAG_ADDED)) tape->stale = true;
+}
+
+static void node_rewired(void *userData, GraphNodeHandle node) {
+    Tape *tape = userData;
+    if (!flag_edit(tape, node, TAPE_FLAG_REWIRED)) tape->stale = true;
+}
+
+static void node_removed(void *userData, GraphNodeHandle node) {
+    Tape *tape = userData;
+    if (node >= tape->nodeCapacity) return;
+    uint32_t index = tape->nodeInstruction[node];
+    if (index != TAPE_NONE) {
+        if (is_nary(&tape->code[index])) tape->orphanedOperands += tape->code[index].count;
+        tape->code[index].opcode = TAPE_OP_NOP;
+        tape->nops++;
+    }
+    tape->nodeInstruction[node] = TAPE_NONE;
+    tape->nodeRegister[node] = TAPE_NONE;
+    tape->nodeFlags[node] = 0; // Its entry in edited is skipped
+}
+
+bool tape_init(Tape *tape, Graph *graph) {
+    memset(tape, 0, sizeof(Tape));
+    tape->graph = graph;
+    GraphListener listener = { node_added, node_removed, node_rewired, tape };
+    graph_set_listener(graph, &listener);
+    return compile(tape);
+}
+
+void tape_destroy(Tape *tape) {
+    if (tape->graph) graph_set_listener(tape->graph, NULL);
+    free(tape->code);
+    free(tape->operands);
+    free(tape->registers);
+    free(tape->nodeInstruction);
+    free(tape->nodeRegister);
+    free(tape->nodeFlags);
+    free(tape->edited);
+    memset(tape, 0, sizeof(Tape));
+}
+
+bool tape_sync(Tape *tape) {
+    tape->stats.lastSyncMs = 0.0;
+    if (tape->stale || tape->nops * TAPE_RECOMPILE_FRACTION > tape->count ||
+        tape->orphanedOperands * TAPE_RECOMPILE_FRACTION > tape->operandCount) {
+        return compile(tape);
+    }
+    if (tape->editedCount == 0) return true;
+    Uint64 start = SDL_GetPerformanceCounter();
+    const Graph *graph = tape->graph;
+    for (uint32_t e = 0; e < tape->editedCount; e++) {
+        uint32_t node = tape->edited[e];
+        uint8_t flags = tape->nodeFlags[node];
+        tape->nodeFlags[node] = 0;
+        if (!flags || graph->kinds[node] == GRAPH_NODE_FREE) continue;
+        if (flags & TAPE_FLAG_ADDED) {
+            RESERVE_ARRAY(tape->code, tape->capacity, tape->count + 1);
+            RESERVE_ARRAY(tape->registers, tape->registerCapacity, tape->registerCount + 1);
+            tape->nodeInstruction[node] = tape->count++;
+            tape->nodeRegister[node] = tape->registerCount;
+            tape->registers[tape->registerCount++] = 0.0f;
+            tape->code[tape->nodeInstruction[node]].opcode = TAPE_OP_NOP; // Until emitted below
+        }
+        // Inputs that moved behind the node, a cycle, or a node leaving one need a new order
+        uint32_t index = tape->nodeInstruction[node];
+        if (index == TAPE_NONE || !inputs_precede(tape, node, index) || !emit(tape, node, index, true)) {
+            for (uint32_t rest = e + 1; rest < tape->editedCount; rest++) {
+                tape->nodeFlags[tape->edited[rest]] = 0;
+            }
+            return compile(tape);
+        }
+    }
+    tape->editedCount = 0;
+    tape->stats.syncs++;
+    tape->stats.lastSyncMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    return true;
+}
+
+bool tape_run(Tape *tape, float tick) {
+    if ((tape->stale || tape->editedCount > 0) && !tape_sync(tape)) return false;
+    const TapeInstruction *code = tape->code;
+    const uint32_t *operands = tape->operands;
+    const float *values = tape->graph->values;
+    float *r = tape->registers;
+    for (uint32_t i = 0, count = tape->count; i < count; i++) {
+        const TapeInstruction *in = &code[i];
+        switch (in->opcode) {
+        case TAPE_OP_NOP: break;
+        case TAPE_OP_LOAD: r[in->output] = values[in->a]; break;
+        case TAPE_OP_TICK: r[in->output] = tick; break;
+        case TAPE_OP_CONST: r[in->output] = (float)in->a; break;
+        case TAPE_OP_COPY: r[in->output] = r[in->a]; break;
+        case TAPE_OP_ADD2: r[in->output] = r[in->a] + r[in->b]; break;
+        case TAPE_OP_MUL2: r[in->output] = r[in->a] * r[in->b]; break;
+        case TAPE_OP_MIN2: r[in->output] = SDL_min(r[in->a], r[in->b]); break;
+        case TAPE_OP_MAX2: r[in->output] = SDL_max(r[in->a], r[in->b]); break;
+        case TAPE_OP_ADDN: {
+            const uint32_t *inputs = &operands[in->a];
+            float value = 0.0f;
+            for (uint32_t p = 0; p < in->count; p++) value += r[inputs[p]];
+            r[in->output] = value;
+            break;
+        }
+        case TAPE_OP_MULN: {
+            const uint32_t *inputs = &operands[in->a];
+            float value = 1.0f;
+            for (uint32_t p = 0; p < in->count; p++) value *= r[inputs[p]];
+            r[in->output] = value;
+            break;
+        }
+        case TAPE_OP_MINN: {
+            const uint32_t *inputs = &operands[in->a];
+            float value = r[inputs[0]];
+            for (uint32_t p = 1; p < in->count; p++) value = SDL_min(value, r[inputs[p]]);
+            r[in->output] = value;
+            break;
+        }
+        case TAPE_OP_MAXN: {
+            const uint32_t *inputs = &operands[in->a];
+            float value = r[inputs[0]];
+            for (uint32_t p = 1; p < in->count; p++) value = SDL_max(value, r[inputs[p]]);
+            r[in->output] = value;
+            break;
+        }
+        default: break;
+        }
+    }
+    return true;
+}
+
+bool tape_get_value(const Tape *tape, GraphNodeHandle node, float *value) {
+    if (node >= tape->nodeCapacity || tape->nodeRegister[node] == TAPE_NONE) return false;
+    if (tape->graph->kinds[node] == GRAPH_NODE_FREE) return false;
+    *value = tape->registers[tape->nodeRegister[node]];
+    return true;
+}
@@ -3,57 +3,19 @@
 #include "vulkan_utils.h"
 #include <string.h>
 #include <stdlib.h>
-#include <SDL3_ttf/SDL_ttf.h>
 #include "shader_text_vert_spv.h"
 #include "shader_text_frag_spv.h"
 
 
-static const TextVertex vertices[] = {
-    {-0.5f, -0.1f, 0.0f, 0.0f}, // Bottom-left: v=0 (texture bottom)
-    { 0.5f, -0.1f, 1.0f, 0.0f}, // Bottom-right: v=0
-    {-0.5f,  0.1f, 0.0f, 1.0f}, // Top-left: v=1 (texture top)
-    { 0.5f,  0.1f, 1.0f, 1.0f}  // Top-right: v=1
-};
-
-static const uint32_t indices[] = {0, 1, 2, 2, 1, 3};
-
-
-static bool createTextureImage(VulkanContext *vulkanContext, SDL_Surface *surface, VkImage *image, VkDeviceMemory *imageMemory) {
-    SDL_Surface *convertedSurface = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA8888);
-    if (!convertedSurface) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to convert surface to RGBA8888: %s", SDL_GetError());
-        return false;
-    }
-    SDL_Log("Converted surface: %dx%d, format=%s", convertedSurface->w, convertedSurface->h, SDL_GetPixelFormatName(convertedSurface->format));
-
-    VkDeviceSize imageSize = convertedSurface->w * convertedSurface->h * 4;
-    SDL_Log("Creating texture image: %dx%d, size=%zu bytes", convertedSurface->w, convertedSurface->h, imageSize);
-
-    VkBuffer stagingBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
-    if (!createBuffer(vulkanContext->device, vulkanContext->physicalDevice, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &stagingBufferMemory)) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create staging buffer");
-        SDL_DestroySurface(convertedSurface);
-        return false;
-    }
-
-    void *data;
-    if (vkMapMemory(vulkanContext->device, stagingBufferMemory, 0, imageSize, 0, &data) != VK_SUCCESS) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map staging buffer memory");
-        vkDestroyBuffer(vulkanContext->device, stagingBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, stagingBufferMemory, NULL);
-        SDL_DestroySurface(convertedSurface);
-        return false;
-    }
-    memcpy(data, convertedSurface->pixels, imageSize);
-    vkUnmapMemory(vulkanContext->device, stagingBufferMemory);
+// Sampled R8 image the glyph atlas packs into; text_prepare clears it before the first copy
+static bool createTextureImage(VulkanContext *vulkanContext, VkImage *image, MemoryAllocation *imageAllocation) {
+    SDL_Log("Creating texture image: %ux%u, size=%u bytes", ATLAS_SIZE, ATLAS_SIZE, ATLAS_SIZE * ATLAS_SIZE);
 
     VkImageCreateInfo imageInfo = {
         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
         .imageType = VK_IMAGE_TYPE_2D,
-        .format = VK_FORMAT_R8G8B8A8_SRGB,
-        .extent = { (uint32_t)convertedSurface->w, (uint32_t)convertedSurface->h, 1 },
+        .format = VK_FORMAT_R8_UNORM,
+        .extent = { ATLAS_SIZE, ATLAS_SIZE, 1 },
         .mipLevels = 1,
         .arrayLayers = 1,
         .samples = VK_SAMPLE_COUNT_1_BIT,
@@ -62,118 +24,228 @@ static bool createTextureImage(VulkanContext *vulkanContext, SDL_Surface *surfac
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
         .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
     };
-    *image = VK_NULL_HANDLE;
-    if (vkCreateImage(vulkanContext->device, &imageInfo, NULL, image) != VK_SUCCESS) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create image");
-        vkDestroyBuffer(vulkanContext->device, stagingBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, stagingBufferMemory, NULL);
-        SDL_DestroySurface(convertedSurface);
+    if (!createImage(&vulkanContext->allocator, &imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageAllocation)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create texture image");
         return false;
     }
+    SDL_Log("Texture image bound at offset %llu of memory type %u",
+            (unsigned long long)imageAllocation->offset, imageAllocation->memoryType);
+    return true;
+}
 
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(vulkanContext->device, *image, &memRequirements);
-    SDL_Log("Image memory requirements: size=%zu, alignment=%u, memoryTypeBits=0x%x", memRequirements.size, memRequirements.alignment, memRequirements.memoryTypeBits);
-
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(vulkanContext->physicalDevice, &memProperties);
-    uint32_t memoryTypeIndex = findMemoryType(vulkanContext->physicalDevice, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    if (memoryTypeIndex == UINT32_MAX) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to find suitable memory type for image");
-        vkDestroyImage(vulkanContext->device, *image, NULL);
-        vkDestroyBuffer(vulkanContext->device, stagingBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, stagingBufferMemory, NULL);
-        SDL_DestroySurface(convertedSurface);
-        return false;
+static uint32_t pack_color(const float color[4]) {
+    uint32_t packed = 0;
+    for (int c = 0; c < 4; c++) {
+        packed |= (uint32_t)(SDL_clamp(color[c], 0.0f, 1.0f) * 255.0f + 0.5f) << (c * 8);
     }
+    return packed;
+}
 
-    VkMemoryAllocateInfo allocInfo = {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = memRequirements.size,
-        .memoryTypeIndex = memoryTypeIndex
-    };
-    *imageMemory = VK_NULL_HANDLE;
-    SDL_Log("Allocating image memory: size=%zu, memoryTypeIndex=%u", memRequirements.size, memoryTypeIndex);
-    if (vkAllocateMemory(vulkanContext->device, &allocInfo, NULL, imageMemory) != VK_SUCCESS) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate image memory");
-        vkDestroyImage(vulkanContext->device, *image, NULL);
-        vkDestroyBuffer(vulkanContext->device, stagingBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, stagingBufferMemory, NULL);
-        SDL_DestroySurface(convertedSurface);
-        return false;
-    }
+static TextLabel *get_label(const TextContext *textContext, TextLabelHandle label) {
+    if (label >= textContext->labelCapacity || !textContext->labels[label].text) return NULL;
+    return &textContext->labels[label];
+}
 
-    if (vkBindImageMemory(vulkanContext->device, *image, *imageMemory, 0) != VK_SUCCESS) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to bind image memory");
-        vkFreeMemory(vulkanContext->device, *imageMemory, NULL);
-        vkDestroyImage(vulkanContext->device, *image, NULL);
-        vkDestroyBuffer(vulkanContext->device, stagingBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, stagingBufferMemory, NULL);
-        SDL_DestroySurface(convertedSurface);
-        return false;
+TextLabelHandle text_label_add(TextContext *textContext, const char *text, float x, float y, float size, const float color[4]) {
+    if (textContext->freeLabel == TEXT_LABEL_INVALID) {
+        uint32_t capacity = textContext->labelCapacity ? textContext->labelCapacity * 2 : TEXT_INITIAL_LABELS;
+        TextLabel *labels = realloc(textContext->labels, capacity * sizeof(TextLabel));
+        if (!labels) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow labels to %u", capacity);
+            return TEXT_LABEL_INVALID;
+        }
+        // Chain the new slots so the lowest is handed out first
+        for (uint32_t i = textContext->labelCapacity; i < capacity; i++) {
+            labels[i].text = NULL;
+            labels[i].nextFree = i + 1 < capacity ? i + 1 : TEXT_LABEL_INVALID;
+        }
+        textContext->freeLabel = textContext->labelCapacity;
+        textContext->labels = labels;
+        textContext->labelCapacity = capacity;
     }
+    char *copy = SDL_strdup(text);
+    if (!copy) return TEXT_LABEL_INVALID;
+    TextLabelHandle handle = textContext->freeLabel;
+    TextLabel *label = &textContext->labels[handle];
+    textContext->freeLabel = label->nextFree;
+    label->text = copy;
+    label->length = (uint32_t)SDL_strlen(copy);
+    label->font = textContext->defaultFont;
+    label->layoutHash = layout_hash(copy, label->font);
+    label->position[0] = x;
+    label->position[1] = y;
+    label->size = size;
+    label->color = pack_color(color);
+    label->measured = false;
+    label->nextFree = TEXT_LABEL_INVALID;
+    textContext->labelCount++;
+    return handle;
+}
+
+void text_label_remove(TextContext *textContext, TextLabelHandle label) {
+    TextLabel *slot = get_label(textContext, label);
+    if (!slot) return;
+    SDL_free(slot->text);
+    slot->text = NULL;
+    slot->nextFree = textContext->freeLabel;
+    textContext->freeLabel = label;
+    textContext->labelCount--;
+}
 
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands(vulkanContext->device, vulkanContext->commandPool);
-    transitionImageLayout(commandBuffer, *image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    copyBufferToImage(commandBuffer, stagingBuffer, *image, convertedSurface->w, convertedSurface->h);
-    transitionImageLayout(commandBuffer, *image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-    endSingleTimeCommands(vulkanContext->device, vulkanContext->commandPool, vulkanContext->graphicsQueue, commandBuffer);
+bool text_label_set_string(TextContext *textContext, TextLabelHandle label, const char *text) {
+    TextLabel *slot = get_label(textContext, label);
+    if (!slot) return false;
+    char *copy = SDL_strdup(text);
+    if (!copy) return false;
+    SDL_free(slot->text);
+    slot->text = copy;
+    slot->length = (uint32_t)SDL_strlen(copy);
+    slot->layoutHash = layout_hash(copy, slot->font);
+    slot->measured = false;
+    return true;
+}
+
+bool text_label_set_font(TextContext *textContext, TextLabelHandle label, FontId font) {
+    TextLabel *slot = get_label(textContext, label);
+    if (!slot || font >= textContext->fonts.count) return false;
+    slot->font = font;
+    slot->layoutHash = layout_hash(slot->text, font);
+    slot->measured = false;
+    return true;
+}
 
-    vkDestroyBuffer(vulkanContext->device, stagingBuffer, NULL);
-    vkFreeMemory(vulkanContext->device, stagingBufferMemory, NULL);
-    SDL_DestroySurface(convertedSurface);
+bool text_label_get_position(const TextContext *textContext, TextLabelHandle label, float position[2]) {
+    const TextLabel *slot = get_label(textContext, label);
+    if (!slot) return false;
+    position[0] = slot->position[0];
+    position[1] = slot->position[1];
     return true;
 }
 
+bool text_label_get_bounds(const TextContext *textContext, TextLabelHandle label, SpatialRect *bounds) {
+    const TextLabel *slot = get_label(textContext, label);
+    if (!slot || !slot->measured) return false;
+    float scale = slot->size / FONT_SDF_SIZE;
+    *bounds = (SpatialRect){
+        slot->position[0] + slot->localBounds.minX * scale, slot->position[1] + slot->localBounds.minY * scale,
+        slot->position[0] + slot->localBounds.maxX * scale, slot->position[1] + slot->localBounds.maxY * scale
+    };
+    return true;
+}
 
+TextLabelHandle text_label_pick(const TextContext *textContext, float x, float y) {
+    // Later labels draw on top, so they win
+    for (uint32_t i = textContext->labelCapacity; i-- > 0;) {
+        SpatialRect bounds;
+        if (!text_label_get_bounds(textContext, i, &bounds)) continue;
+        if (x >= bounds.minX && x <= bounds.maxX && y >= bounds.minY && y <= bounds.maxY) return i;
+    }
+    return TEXT_LABEL_INVALID;
+}
 
+void text_label_set_position(TextContext *textContext, TextLabelHandle label, float x, float y) {
+    TextLabel *slot = get_label(textContext, label);
+    if (!slot) return;
+    slot->position[0] = x;
+    slot->position[1] = y;
+}
 
-bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
-    SDL_Log("Initializing text module");
-    if (!TTF_Init()) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize SDL_ttf: %s", SDL_GetError());
+static bool create_instance_buffer(VulkanContext *vulkanContext, TextContext *textContext, uint32_t capacity) {
+    VkDeviceSize bufferSize = (VkDeviceSize)vulkanContext->framesInFlight * capacity * sizeof(GlyphInstance);
+    if (!createBuffer(&vulkanContext->allocator, bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    &textContext->instanceBuffer, &textContext->instanceAllocation)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create glyph instance buffer");
         return false;
     }
+    textContext->glyphCapacity = capacity;
+    return true;
+}
 
-    TTF_Font *font = TTF_OpenFont("assets/fonts/Kenney Pixel.ttf", 24);
-    if (!font) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load font: %s", SDL_GetError());
-        TTF_Quit();
+static bool create_transform_buffer(VulkanContext *vulkanContext, TextContext *textContext, uint32_t capacity) {
+    VkDeviceSize alignment = vulkanContext->storageAlignment;
+    textContext->transformRegionSize = (capacity * sizeof(LabelTransform) + alignment - 1) & ~(alignment - 1);
+    VkDeviceSize bufferSize = textContext->transformRegionSize * vulkanContext->framesInFlight;
+    if (!createBuffer(&vulkanContext->allocator, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    &textContext->transformBuffer, &textContext->transformAllocation)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create label transform buffer");
         return false;
     }
+    textContext->transformCapacity = capacity;
+    return true;
+}
+
+static void write_transform_descriptor(VulkanContext *vulkanContext, TextContext *textContext) {
+    VkDescriptorBufferInfo transformInfo = {
+        .buffer = textContext->transformBuffer,
+        .offset = 0,
+        .range = textContext->transformRegionSize
+    };
+    VkWriteDescriptorSet descriptorWrite = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = textContext->descriptorSet,
+        .dstBinding = 2,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+        .pBufferInfo = &transformInfo
+    };
+    vkUpdateDescriptorSets(vulkanContext->device, 1, &descriptorWrite, 0, NULL);
+}
+
+// Growing is rare (capacity doubles), so it is allowed to drain the GPU, like the node ring
+static bool ensure_text_capacity(VulkanContext *vulkanContext, TextContext *textContext, uint32_t glyphs, uint32_t labels) {
+    if (glyphs > textContext->glyphCapacity) {
+        uint32_t capacity = SDL_max(textContext->glyphCapacity, TEXT_INITIAL_GLYPHS);
+        while (capacity < glyphs) capacity *= 2;
+        vkDeviceWaitIdle(vulkanContext->device);
+        destroyBuffer(&vulkanContext->allocator, &textContext->instanceBuffer, &textContext->instanceAllocation);
+        if (!create_instance_buffer(vulkanContext, textContext, capacity)) {
+            textContext->glyphCapacity = 0;
+            return false;
+        }
+        SDL_Log("Glyph instance regions grown to %u glyphs", capacity);
+    }
+    if (labels > textContext->transformCapacity) {
+        uint32_t capacity = SDL_max(textContext->transformCapacity, TEXT_INITIAL_LABELS);
+        while (capacity < labels) capacity *= 2;
+        vkDeviceWaitIdle(vulkanContext->device);
+        destroyBuffer(&vulkanContext->allocator, &textContext->transformBuffer, &textContext->transformAllocation);
+        if (!create_transform_buffer(vulkanContext, textContext, capacity)) {
+            textContext->transformCapacity = 0;
+            return false;
+        }
+        write_transform_descriptor(vulkanContext, textContext);
+        SDL_Log("Label transform regions grown to %u labels", capacity);
+    }
+    return true;
+}
 
-    // SDL_Color color = {255, 255, 255, 255}; // White text
-    SDL_Color color = {255, 255, 255, 255}; // White text
-    const char *text = "Hello World";
-    size_t text_len = strlen(text);
-    SDL_Surface *surface = TTF_RenderText_Solid(font, text, text_len, color);
-    if (!surface) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to render text: %s", SDL_GetError());
-        TTF_CloseFont(font);
-        TTF_Quit();
+bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
+    SDL_Log("Initializing text module");
+    // The face is parsed in the background; labels appear on the first frame after it is ready
+    if (!font_manager_init(&textContext->fonts) ||
+        !font_manager_preload(&textContext->fonts, (const char *[]){ TEXT_FONT_PATH }, 1, &textContext->defaultFont)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load font");
+        font_manager_destroy(&textContext->fonts);
         return false;
     }
+    atlas_init(&textContext->atlas);
+    layout_cache_init(&textContext->layouts, LAYOUT_CACHE_BYTES);
 
-    // Initialize text position
-    glm_vec2_zero(textContext->position);
-    glm_mat4_identity(textContext->modelMatrix);
+    textContext->freeLabel = TEXT_LABEL_INVALID;
 
-    SDL_Log("Text surface created: %dx%d, format=%s", surface->w, surface->h, SDL_GetPixelFormatName(surface->format));
-    SDL_SaveBMP(surface, "text_surface.bmp"); // Debug: Save surface to inspect
+    // Labels are laid out every frame, rasterizing glyphs the atlas misses
+    textContext->titleLabel = text_label_add(textContext, "Hello World", 0.0f, 0.0f, 24.0f, (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+    if (textContext->titleLabel == TEXT_LABEL_INVALID) {
+        text_cleanup(vulkanContext, textContext);
+        return false;
+    }
 
-    if (!createTextureImage(vulkanContext, surface, &textContext->textureImage, &textContext->textureImageMemory)) {
+    if (!createTextureImage(vulkanContext, &textContext->textureImage, &textContext->textureImageAllocation)) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create texture image");
-        if (textContext->textureImage != VK_NULL_HANDLE) {
-            vkDestroyImage(vulkanContext->device, textContext->textureImage, NULL);
-            textContext->textureImage = VK_NULL_HANDLE;
-        }
-        if (textContext->textureImageMemory != VK_NULL_HANDLE) {
-            vkFreeMemory(vulkanContext->device, textContext->textureImageMemory, NULL);
-            textContext->textureImageMemory = VK_NULL_HANDLE;
-        }
-        SDL_DestroySurface(surface);
-        TTF_CloseFont(font);
-        TTF_Quit();
+        text_cleanup(vulkanContext, textContext);
         return false;
     }
 
@@ -181,7 +253,7 @@ bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
         .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
         .image = textContext->textureImage,
         .viewType = VK_IMAGE_VIEW_TYPE_2D,
-        .format = VK_FORMAT_R8G8B8A8_SRGB,
+        .format = VK_FORMAT_R8_UNORM,
         .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
         .subresourceRange.baseMipLevel = 0,
         .subresourceRange.levelCount = 1,
@@ -190,12 +262,11 @@ bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
     };
     if (vkCreateImageView(vulkanContext->device, &viewInfo, NULL, &textContext->textureImageView) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create texture image view");
-        SDL_DestroySurface(surface);
-        TTF_CloseFont(font);
-        TTF_Quit();
+        text_cleanup(vulkanContext, textContext);
         return false;
     }
 
+    // Distances must be filtered linearly for the edge to land between texels
     VkSamplerCreateInfo samplerInfo = {
         .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
         .magFilter = VK_FILTER_LINEAR,
@@ -215,67 +286,25 @@ bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
     };
     if (vkCreateSampler(vulkanContext->device, &samplerInfo, NULL, &textContext->textureSampler) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create texture sampler");
-        vkDestroyImageView(vulkanContext->device, textContext->textureImageView, NULL);
-        SDL_DestroySurface(surface);
-        TTF_CloseFont(font);
-        TTF_Quit();
+        text_cleanup(vulkanContext, textContext);
         return false;
     }
 
-    VkDeviceSize bufferSize = sizeof(vertices);
-    textContext->vertexBuffer = VK_NULL_HANDLE;
-    textContext->vertexBufferMemory = VK_NULL_HANDLE;
-    if (!createBuffer(vulkanContext->device, vulkanContext->physicalDevice, bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &textContext->vertexBuffer, &textContext->vertexBufferMemory)) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create vertex buffer");
-        if (textContext->vertexBuffer != VK_NULL_HANDLE) {
-            vkDestroyBuffer(vulkanContext->device, textContext->vertexBuffer, NULL);
-        }
-        if (textContext->vertexBufferMemory != VK_NULL_HANDLE) {
-            vkFreeMemory(vulkanContext->device, textContext->vertexBufferMemory, NULL);
-        }
-        vkDestroySampler(vulkanContext->device, textContext->textureSampler, NULL);
-        vkDestroyImageView(vulkanContext->device, textContext->textureImageView, NULL);
-        vkDestroyImage(vulkanContext->device, textContext->textureImage, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->textureImageMemory, NULL);
-        SDL_DestroySurface(surface);
-        TTF_CloseFont(font);
-        TTF_Quit();
+    if (!create_instance_buffer(vulkanContext, textContext, TEXT_INITIAL_GLYPHS) ||
+        !create_transform_buffer(vulkanContext, textContext, TEXT_INITIAL_LABELS)) {
+        text_cleanup(vulkanContext, textContext);
         return false;
     }
-    void *data;
-    vkMapMemory(vulkanContext->device, textContext->vertexBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, vertices, bufferSize);
-    vkUnmapMemory(vulkanContext->device, textContext->vertexBufferMemory);
-
-    bufferSize = sizeof(indices);
-    textContext->indexBuffer = VK_NULL_HANDLE;
-    textContext->indexBufferMemory = VK_NULL_HANDLE;
-    if (!createBuffer(vulkanContext->device, vulkanContext->physicalDevice, bufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &textContext->indexBuffer, &textContext->indexBufferMemory)) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create index buffer");
-        if (textContext->indexBuffer != VK_NULL_HANDLE) {
-            vkDestroyBuffer(vulkanContext->device, textContext->indexBuffer, NULL);
-        }
-        if (textContext->indexBufferMemory != VK_NULL_HANDLE) {
-            vkFreeMemory(vulkanContext->device, textContext->indexBufferMemory, NULL);
-        }
-        vkDestroyBuffer(vulkanContext->device, textContext->vertexBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->vertexBufferMemory, NULL);
-        vkDestroySampler(vulkanContext->device, textContext->textureSampler, NULL);
-        vkDestroyImageView(vulkanContext->device, textContext->textureImageView, NULL);
-        vkDestroyImage(vulkanContext->device, textContext->textureImage, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->textureImageMemory, NULL);
-        SDL_DestroySurface(surface);
-        TTF_CloseFont(font);
-        TTF_Quit();
+
+    VkDeviceSize bufferSize = (VkDeviceSize)vulkanContext->framesInFlight * TEXT_STAGING_BYTES;
+    if (!createBuffer(&vulkanContext->allocator, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &textContext->stagingBuffer, &textContext->stagingAllocation)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create glyph staging buffer");
+        text_cleanup(vulkanContext, textContext);
         return false;
     }
-    vkMapMemory(vulkanContext->device, textContext->indexBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, indices, bufferSize);
-    vkUnmapMemory(vulkanContext->device, textContext->indexBufferMemory);
 
-    VkDescriptorSetLayoutBinding bindings[2] = {
+    VkDescriptorSetLayoutBinding bindings[3] = {
     {
         .binding = 0,
         .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
@@ -285,7 +314,14 @@ bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
     },
     {
         .binding = 1,
-        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .pImmutableSamplers = NULL
+    },
+    {
+        .binding = 2,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
         .descriptorCount = 1,
         .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
         .pImmutableSamplers = NULL
@@ -293,45 +329,29 @@ bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
     };
     VkDescriptorSetLayoutCreateInfo layoutInfo = {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-        .bindingCount = 2,
+        .bindingCount = 3,
         .pBindings = bindings
     };
     if (vkCreateDescriptorSetLayout(vulkanContext->device, &layoutInfo, NULL, &textContext->descriptorSetLayout) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create descriptor set layout");
-        vkDestroyBuffer(vulkanContext->device, textContext->indexBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->indexBufferMemory, NULL);
-        vkDestroyBuffer(vulkanContext->device, textContext->vertexBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->vertexBufferMemory, NULL);
-        vkDestroySampler(vulkanContext->device, textContext->textureSampler, NULL);
-        vkDestroyImageView(vulkanContext->device, textContext->textureImageView, NULL);
-        SDL_DestroySurface(surface);
-        TTF_CloseFont(font);
-        TTF_Quit();
+        text_cleanup(vulkanContext, textContext);
         return false;
     }
 
-    VkDescriptorPoolSize poolSizes[2] = {
-        { .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .descriptorCount = 1 },
-        { .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 1 }
+    VkDescriptorPoolSize poolSizes[3] = {
+        { .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, .descriptorCount = 1 },
+        { .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 1 },
+        { .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, .descriptorCount = 1 }
     };
     VkDescriptorPoolCreateInfo poolInfo = {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
         .maxSets = 1,
-        .poolSizeCount = 2,
+        .poolSizeCount = 3,
         .pPoolSizes = poolSizes
     };
     if (vkCreateDescriptorPool(vulkanContext->device, &poolInfo, NULL, &textContext->descriptorPool) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create descriptor pool");
-        vkDestroyDescriptorSetLayout(vulkanContext->device, textContext->descriptorSetLayout, NULL);
-        vkDestroyBuffer(vulkanContext->device, textContext->indexBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->indexBufferMemory, NULL);
-        vkDestroyBuffer(vulkanContext->device, textContext->vertexBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->vertexBufferMemory, NULL);
-        vkDestroySampler(vulkanContext->device, textContext->textureSampler, NULL);
-        vkDestroyImageView(vulkanContext->device, textContext->textureImageView, NULL);
-        SDL_DestroySurface(surface);
-        TTF_CloseFont(font);
-        TTF_Quit();
+        text_cleanup(vulkanContext, textContext);
         return false;
     }
 
@@ -343,17 +363,7 @@ bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
     };
     if (vkAllocateDescriptorSets(vulkanContext->device, &allocInfo, &textContext->descriptorSet) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate descriptor set");
-        vkDestroyDescriptorPool(vulkanContext->device, textContext->descriptorPool, NULL);
-        vkDestroyDescriptorSetLayout(vulkanContext->device, textContext->descriptorSetLayout, NULL);
-        vkDestroyBuffer(vulkanContext->device, textContext->indexBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->indexBufferMemory, NULL);
-        vkDestroyBuffer(vulkanContext->device, textContext->vertexBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->vertexBufferMemory, NULL);
-        vkDestroySampler(vulkanContext->device, textContext->textureSampler, NULL);
-        vkDestroyImageView(vulkanContext->device, textContext->textureImageView, NULL);
-        SDL_DestroySurface(surface);
-        TTF_CloseFont(font);
-        TTF_Quit();
+        text_cleanup(vulkanContext, textContext);
         return false;
     }
 
@@ -386,11 +396,12 @@ bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
         .dstBinding = 1,
         .dstArrayElement = 0,
         .descriptorCount = 1,
-        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
         .pBufferInfo = &bufferInfo
     }
     };
     vkUpdateDescriptorSets(vulkanContext->device, 2, descriptorWrites, 0, NULL);
+    write_transform_descriptor(vulkanContext, textContext);
 
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
@@ -399,21 +410,11 @@ bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
     };
     if (vkCreatePipelineLayout(vulkanContext->device, &pipelineLayoutInfo, NULL, &textContext->pipelineLayout) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create pipeline layout");
-        vkDestroyDescriptorPool(vulkanContext->device, textContext->descriptorPool, NULL);
-        vkDestroyDescriptorSetLayout(vulkanContext->device, textContext->descriptorSetLayout, NULL);
-        vkDestroyBuffer(vulkanContext->device, textContext->indexBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->indexBufferMemory, NULL);
-        vkDestroyBuffer(vulkanContext->device, textContext->vertexBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->vertexBufferMemory, NULL);
-        vkDestroySampler(vulkanContext->device, textContext->textureSampler, NULL);
-        vkDestroyImageView(vulkanContext->device, textContext->textureImageView, NULL);
-        SDL_DestroySurface(surface);
-        TTF_CloseFont(font);
-        TTF_Quit();
+        text_cleanup(vulkanContext, textContext);
         return false;
     }
 
-    VkShaderModule vertShaderModule, fragShaderModule;
+    VkShaderModule vertShaderModule = VK_NULL_HANDLE, fragShaderModule = VK_NULL_HANDLE;
     VkShaderModuleCreateInfo vertShaderInfo = {
         .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
         .codeSize = sizeof(shader_text_vert_spv),
@@ -427,18 +428,9 @@ bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
     if (vkCreateShaderModule(vulkanContext->device, &vertShaderInfo, NULL, &vertShaderModule) != VK_SUCCESS ||
         vkCreateShaderModule(vulkanContext->device, &fragShaderInfo, NULL, &fragShaderModule) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create shader modules");
-        vkDestroyPipelineLayout(vulkanContext->device, textContext->pipelineLayout, NULL);
-        vkDestroyDescriptorPool(vulkanContext->device, textContext->descriptorPool, NULL);
-        vkDestroyDescriptorSetLayout(vulkanContext->device, textContext->descriptorSetLayout, NULL);
-        vkDestroyBuffer(vulkanContext->device, textContext->indexBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->indexBufferMemory, NULL);
-        vkDestroyBuffer(vulkanContext->device, textContext->vertexBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->vertexBufferMemory, NULL);
-        vkDestroySampler(vulkanContext->device, textContext->textureSampler, NULL);
-        vkDestroyImageView(vulkanContext->device, textContext->textureImageView, NULL);
-        SDL_DestroySurface(surface);
-        TTF_CloseFont(font);
-        TTF_Quit();
+        vkDestroyShaderModule(vulkanContext->device, fragShaderModule, NULL);
+        vkDestroyShaderModule(vulkanContext->device, vertShaderModule, NULL);
+        text_cleanup(vulkanContext, textContext);
         return false;
     }
 
@@ -456,35 +448,35 @@ bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
             .pName = "main"
         }
     };
+    // Every attribute advances per glyph; the four strip vertices pick their corner from gl_VertexIndex
     VkVertexInputBindingDescription bindingDesc = {
         .binding = 0,
-        .stride = sizeof(TextVertex),
-        .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+        .stride = sizeof(GlyphInstance),
+        .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE
     };
     VkVertexInputAttributeDescription attributeDescs[] = {
-        { .location = 0, .binding = 0, .format = VK_FORMAT_R32G32_SFLOAT, .offset = offsetof(TextVertex, x) },
-        { .location = 1, .binding = 0, .format = VK_FORMAT_R32G32_SFLOAT, .offset = offsetof(TextVertex, u) }
+        { .location = 0, .binding = 0, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = offsetof(GlyphInstance, x0) },
+        { .location = 1, .binding = 0, .format = VK_FORMAT_R16G16B16A16_UNORM, .offset = offsetof(GlyphInstance, u0) },
+        { .location = 2, .binding = 0, .format = VK_FORMAT_R8G8B8A8_UNORM, .offset = offsetof(GlyphInstance, color) },
+        { .location = 3, .binding = 0, .format = VK_FORMAT_R32_UINT, .offset = offsetof(GlyphInstance, label) }
     };
     VkPipelineVertexInputStateCreateInfo vertexInputInfo = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
         .vertexBindingDescriptionCount = 1,
         .pVertexBindingDescriptions = &bindingDesc,
-        .vertexAttributeDescriptionCount = 2,
+        .vertexAttributeDescriptionCount = SDL_arraysize(attributeDescs),
         .pVertexAttributeDescriptions = attributeDescs
     };
     VkPipelineInputAssemblyStateCreateInfo inputAssembly = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
         .primitiveRestartEnable = VK_FALSE
     };
-    VkViewport viewport = { 0.0f, 0.0f, (float)vulkanContext->swapchainExtent.width, (float)vulkanContext->swapchainExtent.height, 0.0f, 1.0f };
-    VkRect2D scissor = { {0, 0}, vulkanContext->swapchainExtent };
+    // Viewport and scissor are set by vulkan_render, so resizes keep this pipeline valid
     VkPipelineViewportStateCreateInfo viewportState = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
         .viewportCount = 1,
-        .pViewports = &viewport,
-        .scissorCount = 1,
-        .pScissors = &scissor
+        .scissorCount = 1
     };
     VkPipelineRasterizationStateCreateInfo rasterizer = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
@@ -513,6 +505,12 @@ bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
         .attachmentCount = 1,
         .pAttachments = &colorBlendAttachment
     };
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = SDL_arraysize(dynamicStates),
+        .pDynamicStates = dynamicStates
+    };
     VkGraphicsPipelineCreateInfo pipelineInfo = {
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
         .stageCount = 2,
@@ -523,75 +521,331 @@ bool text_init(VulkanContext *vulkanContext, TextContext *textContext) {
         .pRasterizationState = &rasterizer,
         .pMultisampleState = &multisampling,
         .pColorBlendState = &colorBlending,
+        .pDynamicState = &dynamicState,
         .layout = textContext->pipelineLayout,
         .renderPass = vulkanContext->renderPass,
         .subpass = 0
     };
-    if (vkCreateGraphicsPipelines(vulkanContext->device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, &textContext->graphicsPipeline) != VK_SUCCESS) {
+    Uint64 pipelineStart = SDL_GetPerformanceCounter();
+    if (vkCreateGraphicsPipelines(vulkanContext->device, vulkanContext->pipelineCache, 1, &pipelineInfo, NULL, &textContext->graphicsPipeline) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create graphics pipeline");
         vkDestroyShaderModule(vulkanContext->device, fragShaderModule, NULL);
         vkDestroyShaderModule(vulkanContext->device, vertShaderModule, NULL);
-        vkDestroyPipelineLayout(vulkanContext->device, textContext->pipelineLayout, NULL);
-        vkDestroyDescriptorPool(vulkanContext->device, textContext->descriptorPool, NULL);
-        vkDestroyDescriptorSetLayout(vulkanContext->device, textContext->descriptorSetLayout, NULL);
-        vkDestroyBuffer(vulkanContext->device, textContext->indexBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->indexBufferMemory, NULL);
-        vkDestroyBuffer(vulkanContext->device, textContext->vertexBuffer, NULL);
-        vkFreeMemory(vulkanContext->device, textContext->vertexBufferMemory, NULL);
-        vkDestroySampler(vulkanContext->device, textContext->textureSampler, NULL);
-        vkDestroyImageView(vulkanContext->device, textContext->textureImageView, NULL);
-        SDL_DestroySurface(surface);
-        TTF_CloseFont(font);
-        TTF_Quit();
+        text_cleanup(vulkanContext, textContext);
         return false;
     }
+    SDL_Log("Text pipeline created in %.3f ms (%s pipeline cache)",
+            (SDL_GetPerformanceCounter() - pipelineStart) * 1000.0 / SDL_GetPerformanceFrequency(),
+            vulkanContext->pipelineCacheWarm ? "warm" : "cold");
     vkDestroyShaderModule(vulkanContext->device, fragShaderModule, NULL);
     vkDestroyShaderModule(vulkanContext->device, vertShaderModule, NULL);
-    SDL_DestroySurface(surface);
-    TTF_CloseFont(font);
-    TTF_Quit();
     SDL_Log("Text module initialized successfully");
     return true;
 }
 
 
+// Copies recorded by one text_prepare, sourced from the frame's staging region
+typedef struct {
+    VkBufferImageCopy regions[TEXT_MAX_UPLOADS];
+    uint32_t count;
+    VkDeviceSize used;          // Bytes of the staging region taken
+} GlyphUploads;
+
+// Next codepoint of a UTF-8 string; malformed sequences decode to U+FFFD one byte at a time
+static uint32_t decode_utf8(const unsigned char **cursor) {
+    const unsigned char *c = *cursor;
+    uint32_t codepoint, length;
+    if (c[0] < 0x80) {
+        codepoint = c[0];
+        length = 1;
+    } else if ((c[0] & 0xE0) == 0xC0) {
+        codepoint = c[0] & 0x1F;
+        length = 2;
+    } else if ((c[0] & 0xF0) == 0xE0) {
+        codepoint = c[0] & 0x0F;
+        length = 3;
+    } else if ((c[0] & 0xF8) == 0xF0) {
+        codepoint = c[0] & 0x07;
+        length = 4;
+    } else {
+        *cursor = c + 1;
+        return 0xFFFD;
+    }
+    for (uint32_t i = 1; i < length; i++) {
+        if ((c[i] & 0xC0) != 0x80) {
+            *cursor = c + 1;
+            return 0xFFFD;
+        }
+        codepoint = (codepoint << 6) | (c[i] & 0x3F);
+    }
+    *cursor = c + length;
+    return codepoint;
+}
+
+// Whether one more glyph of this size, padded, fits the frame's copies and staging region
+static bool upload_fits(const GlyphUploads *uploads, uint32_t width, uint32_t height) {
+    VkDeviceSize bytes = (VkDeviceSize)(width + 2 * ATLAS_PADDING) * (height + 2 * ATLAS_PADDING);
+    return uploads->count < TEXT_MAX_UPLOADS && uploads->used + bytes <= TEXT_STAGING_BYTES;
+}
+
+// Atlas glyph for a codepoint. A miss is rasterized into the frame's staging region and queued
+// as one copy; NULL when it cannot be placed this frame.
+static const FontGlyph *text_glyph(VulkanContext *vulkanContext, TextContext *textContext, GlyphUploads *uploads,
+                                   Font *font, uint32_t codepoint) {
+    uint64_t key = ATLAS_KEY(font->id, codepoint);
+    const AtlasEntry *entry = atlas_lookup(&textContext->atlas, key);
+    if (entry) return &entry->glyph;
+
+    // Budget the upload from the cached metrics first, so a glyph waiting for a later frame is not
+    // rasterized again every frame
+    FontGlyph glyph;
+    if (!font_glyph_metrics(font, codepoint, &glyph)) return NULL;
+    if (!glyph.empty && !upload_fits(uploads, (uint32_t)(glyph.x1 - glyph.x0), (uint32_t)(glyph.y1 - glyph.y0))) {
+        textContext->glyphsDeferred = true;
+        return NULL;
+    }
+    FontBitmap bitmap;
+    if (!font_render_glyph(font, codepoint, &glyph, &bitmap)) return NULL;
+    // The region copies the padding too, so texels left by an evicted glyph never bleed into this one
+    uint32_t cellWidth = bitmap.width + 2 * ATLAS_PADDING, cellHeight = bitmap.height + 2 * ATLAS_PADDING;
+    VkDeviceSize bytes = glyph.empty ? 0 : (VkDeviceSize)cellWidth * cellHeight;
+    if (bytes > 0 && !upload_fits(uploads, bitmap.width, bitmap.height)) {
+        textContext->glyphsDeferred = true;
+        return NULL;
+    }
+    entry = atlas_insert(&textContext->atlas, key, &glyph, bitmap.width, bitmap.height);
+    if (!entry) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Glyph atlas full, U+%04X not drawn this frame", codepoint);
+        return NULL;
+    }
+    if (bytes == 0) return &entry->glyph;
+
+    VkDeviceSize base = (VkDeviceSize)vulkanContext->currentFrame * TEXT_STAGING_BYTES + uploads->used;
+    uint8_t *cell = (uint8_t *)textContext->stagingAllocation.mapped + base;
+    memset(cell, 0, bytes);
+    for (uint32_t row = 0; row < bitmap.height; row++) {
+        const uint8_t *source = bitmap.pitch >= 0
+            ? bitmap.pixels + row * bitmap.pitch
+            : bitmap.pixels + (bitmap.height - 1 - row) * -bitmap.pitch;
+        memcpy(cell + (row + ATLAS_PADDING) * cellWidth + ATLAS_PADDING, source, bitmap.width);
+    }
+    uploads->regions[uploads->count++] = (VkBufferImageCopy){
+        .bufferOffset = base,
+        .imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+        .imageOffset = { (int32_t)(entry->x - ATLAS_PADDING), (int32_t)(entry->y - ATLAS_PADDING), 0 },
+        .imageExtent = { cellWidth, cellHeight, 1 }
+    };
+    uploads->used += bytes;
+    return &entry->glyph;
+}
+
+// Shape a label's string into a run in label space, FONT_SDF_SIZE pixels from its top-left, and cache it.
+// Only the font's metrics cache is consulted; the atlas sees the glyphs once they are packed.
+static LayoutRun *shape_label(TextContext *textContext, Font *font, const TextLabel *label) {
+    if (label->length > textContext->shapeCapacity) {
+        uint32_t capacity = SDL_max(label->length, textContext->shapeCapacity * 2);
+        LayoutGlyph *glyphs = realloc(textContext->shapeGlyphs, capacity * sizeof(LayoutGlyph));
+        if (!glyphs) return NULL;
+        textContext->shapeGlyphs = glyphs;
+        textContext->shapeCapacity = capacity;
+    }
+    float penX = 0.0f;
+    float baseline = font->ascent;
+    uint32_t glyphCount = 0;
+    uint32_t previous = 0;
+    SpatialRect bounds = { 0.0f, 0.0f, 0.0f, font->lineHeight };
+    for (const unsigned char *c = (const unsigned char *)label->text; *c;) {
+        uint32_t codepoint = decode_utf8(&c);
+        if (codepoint == '\n') {
+            penX = 0.0f;
+            baseline += font->lineHeight;
+            bounds.maxY = SDL_max(bounds.maxY, baseline - font->ascent + font->lineHeight);
+            previous = 0;
+            continue;
+        }
+        if (previous) penX += font_kerning(font, previous, codepoint);
+        previous = codepoint;
+        FontGlyph glyph;
+        if (!font_glyph_metrics(font, codepoint, &glyph)) continue;
+        if (!glyph.empty) {
+            textContext->shapeGlyphs[glyphCount++] = (LayoutGlyph){ codepoint, penX, baseline };
+            bounds.minX = SDL_min(bounds.minX, penX + glyph.x0);
+            bounds.minY = SDL_min(bounds.minY, baseline + glyph.y0);
+            bounds.maxX = SDL_max(bounds.maxX, penX + glyph.x1);
+            bounds.maxY = SDL_max(bounds.maxY, baseline + glyph.y1);
+        }
+        penX += glyph.advance;
+        bounds.maxX = SDL_max(bounds.maxX, penX);
+    }
+    return layout_cache_insert(&textContext->layouts, label->layoutHash, label->font, label->text,
+                               textContext->shapeGlyphs, glyphCount, &bounds);
+}
+
+// Turn a run into glyph instances; only the atlas lookup runs per glyph. Returns how many were
+// written, fewer than the run holds when glyphs wait for a later frame's upload.
+static uint32_t pack_run(VulkanContext *vulkanContext, TextContext *textContext, GlyphUploads *uploads, Font *font,
+                         const LayoutRun *run, uint32_t color, uint32_t transform, GlyphInstance *instances) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < run->glyphCount; i++) {
+        const LayoutGlyph *pen = &run->glyphs[i];
+        const FontGlyph *glyph = text_glyph(vulkanContext, textContext, uploads, font, pen->codepoint);
+        if (!glyph) continue;
+        instances[count++] = (GlyphInstance){
+            pen->x + glyph->x0, pen->y + glyph->y0, pen->x + glyph->x1, pen->y + glyph->y1,
+            (uint16_t)(glyph->u0 * 65535.0f + 0.5f), (uint16_t)(glyph->v0 * 65535.0f + 0.5f),
+            (uint16_t)(glyph->u1 * 65535.0f + 0.5f), (uint16_t)(glyph->v1 * 65535.0f + 0.5f),
+            color, transform
+        };
+    }
+    return count;
+}
+
+static bool label_visible(const TextLabel *label, const SpatialRect *view) {
+    float scale = label->size / FONT_SDF_SIZE;
+    return label->position[0] + label->localBounds.maxX * scale >= view->minX &&
+           label->position[0] + label->localBounds.minX * scale <= view->maxX &&
+           label->position[1] + label->localBounds.maxY * scale >= view->minY &&
+           label->position[1] + label->localBounds.minY * scale <= view->maxY;
+}
+
+void text_prepare(VulkanContext *vulkanContext, TextContext *textContext, VkCommandBuffer commandBuffer) {
+    atlas_begin_frame(&textContext->atlas);
+    textContext->glyphsDeferred = false;
+    textContext->glyphCount = 0;
+    SpatialRect view;
+    vulkan_visible_rect(vulkanContext, &view);
+
+    // Size the frame's regions for the labels that may be visible; a label never laid out has
+    // no bounds yet and counts as visible until its first layout measures it
+    uint32_t candidates = 0, glyphBound = 0;
+    for (uint32_t i = 0; i < textContext->labelCapacity; i++) {
+        const TextLabel *label = &textContext->labels[i];
+        if (!label->text || (label->measured && !label_visible(label, &view))) continue;
+        candidates++;
+        glyphBound += label->length; // Bytes bound the glyphs a UTF-8 string can hold
+    }
+    if (!ensure_text_capacity(vulkanContext, textContext, glyphBound, candidates)) {
+        return;
+    }
+
+    // Glyph quads live in label space and labels are placed in world space, so every label zooms
+    // with the nodes; the distance field keeps the edges sharp at every camera scale
+    GlyphInstance *instances = (GlyphInstance *)((char *)textContext->instanceAllocation.mapped +
+                                                 vulkanContext->currentFrame * textContext->glyphCapacity * sizeof(GlyphInstance));
+    LabelTransform *transforms = (LabelTransform *)((char *)textContext->transformAllocation.mapped +
+                                                    vulkanContext->currentFrame * textContext->transformRegionSize);
+    GlyphUploads uploads;
+    uploads.count = 0;
+    uploads.used = 0;
+    uint32_t drawn = 0, culled = 0;
+    for (uint32_t i = 0; i < textContext->labelCapacity; i++) {
+        TextLabel *label = &textContext->labels[i];
+        if (!label->text) continue;
+        if (label->measured && !label_visible(label, &view)) {
+            culled++;
+            continue;
+        }
+        // A font still being preloaded keeps the frame loop redrawing until it arrives
+        Font *font = font_manager_get(&textContext->fonts, label->font);
+        if (!font) {
+            if (font_manager_state(&textContext->fonts, label->font) == FONT_STATE_PENDING) textContext->glyphsDeferred = true;
+            culled++;
+            continue;
+        }
+        // Shaping runs once per string; afterwards a label costs a cache probe plus one atlas lookup per glyph
+        LayoutRun *run = layout_cache_find(&textContext->layouts, label->layoutHash, label->font, label->text);
+        if (!run) run = shape_label(textContext, font, label);
+        if (!run) {
+            culled++;
+            continue;
+        }
+        label->localBounds = run->bounds;
+        label->measured = true;
+        if (run->glyphCount == 0 || !label_visible(label, &view)) {
+            culled++;
+            continue;
+        }
+        uint32_t count = pack_run(vulkanContext, textContext, &uploads, font, run, label->color, drawn, instances + textContext->glyphCount);
+        transforms[drawn++] = (LabelTransform){ label->position[0], label->position[1], label->size / FONT_SDF_SIZE, 0.0f };
+        textContext->glyphCount += count;
+    }
+    vulkanContext->stats.labelsDrawn = drawn;
+    vulkanContext->stats.labelsCulled = culled;
+    vulkanContext->stats.glyphsDrawn = textContext->glyphCount;
+    vulkanContext->stats.glyphsUploaded = uploads.count;
+    if (uploads.count == 0 && textContext->atlasCleared) return;
+
+    // Earlier frames may still sample texels an eviction hands out again; the barrier orders these
+    // copies after every fragment shader submitted before them on this queue. The first prepare
+    // starts from an undefined image and clears it, so padding and free space read as far outside.
+    VkImageMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = textContext->atlasCleared ? VK_ACCESS_SHADER_READ_BIT : 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = textContext->atlasCleared ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = textContext->textureImage,
+        .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+    };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, NULL, 0, NULL, 1, &barrier);
+    if (!textContext->atlasCleared) {
+        VkClearColorValue zero = { .float32 = { 0.0f, 0.0f, 0.0f, 0.0f } };
+        vkCmdClearColorImage(commandBuffer, textContext->textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                             &zero, 1, &barrier.subresourceRange);
+        textContext->atlasCleared = true;
+        if (uploads.count > 0) {
+            // The clear and the copies write the same texels
+            VkMemoryBarrier clearBarrier = {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT
+            };
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 0, 1, &clearBarrier, 0, NULL, 0, NULL);
+        }
+    }
+    if (uploads.count > 0) {
+        vkCmdCopyBufferToImage(commandBuffer, textContext->stagingBuffer, textContext->textureImage,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, uploads.count, uploads.regions);
+    }
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
 void text_render(VulkanContext *vulkanContext, TextContext *textContext, VkCommandBuffer commandBuffer) {
     if (!textContext->graphicsPipeline) {
         SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Text pipeline is invalid, skipping text render");
         return;
     }
+    if (textContext->glyphCount == 0) return;
 
-    mat4 projection, view, vp, mvp;
-    glm_ortho(0.0f, (float)vulkanContext->swapchainExtent.width,
-              (float)vulkanContext->swapchainExtent.height, 0.0f,
-              -1.0f, 1.0f, projection);
-    glm_mat4_identity(view); // Reset view to identity for screen-space text
-    glm_mat4_mul(projection, view, vp);
-
-    // Scale and translate the text quad
-    mat4 model;
-    glm_mat4_identity(model);
-    glm_scale(model, (vec3){100.0f, 100.0f, 1.0f}); // Scale quad to ~100x20 pixels
-    glm_translate(model, (vec3){1.0f, 1.0f, 0.0f}); // Move to (100,100) pixels
-    glm_mat4_mul(vp, model, mvp);
-
-    void *data;
-    vkMapMemory(vulkanContext->device, vulkanContext->uniformBufferMemory, 0, sizeof(mat4), 0, &data);
-    memcpy(data, mvp, sizeof(mat4));
-    vkUnmapMemory(vulkanContext->device, vulkanContext->uniformBufferMemory);
+    mat4 vp;
+    vulkan_view_projection(vulkanContext, vp);
+    uint32_t dynamicOffsets[2];
+    if (!vulkan_push_uniform(vulkanContext, vp, sizeof(mat4), &dynamicOffsets[0])) {
+        return;
+    }
+    dynamicOffsets[1] = (uint32_t)(vulkanContext->currentFrame * textContext->transformRegionSize);
 
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, textContext->graphicsPipeline);
     vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, textContext->pipelineLayout,
-                            0, 1, &textContext->descriptorSet, 0, NULL);
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &textContext->vertexBuffer, offsets);
-    vkCmdBindIndexBuffer(commandBuffer, textContext->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(commandBuffer, 6, 1, 0, 0, 0);
+                            0, 1, &textContext->descriptorSet, 2, dynamicOffsets);
+    VkDeviceSize offsets[] = { (VkDeviceSize)vulkanContext->currentFrame * textContext->glyphCapacity * sizeof(GlyphInstance) };
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &textContext->instanceBuffer, offsets);
+    vkCmdDraw(commandBuffer, 4, textContext->glyphCount, 0, 0);
+    vulkanContext->stats.drawCalls++;
 }
 
 
-
-
+// Safe to call on a partially initialized (zeroed) context
 void text_cleanup(VulkanContext *vulkanContext, TextContext *textContext) {
     SDL_Log("Cleaning up text module");
     vkDestroyPipeline(vulkanContext->device, textContext->graphicsPipeline, NULL);
@@ -600,10 +854,15 @@ void text_cleanup(VulkanContext *vulkanContext, TextContext *textContext) {
     vkDestroyDescriptorSetLayout(vulkanContext->device, textContext->descriptorSetLayout, NULL);
     vkDestroySampler(vulkanContext->device, textContext->textureSampler, NULL);
     vkDestroyImageView(vulkanContext->device, textContext->textureImageView, NULL);
-    vkDestroyImage(vulkanContext->device, textContext->textureImage, NULL);
-    vkFreeMemory(vulkanContext->device, textContext->textureImageMemory, NULL);
-    vkDestroyBuffer(vulkanContext->device, textContext->vertexBuffer, NULL);
-    vkFreeMemory(vulkanContext->device, textContext->vertexBufferMemory, NULL);
-    vkDestroyBuffer(vulkanContext->device, textContext->indexBuffer, NULL);
-    vkFreeMemory(vulkanContext->device, textContext->indexBufferMemory, NULL);
+    destroyImage(&vulkanContext->allocator, &textContext->textureImage, &textContext->textureImageAllocation);
+    destroyBuffer(&vulkanContext->allocator, &textContext->instanceBuffer, &textContext->instanceAllocation);
+    destroyBuffer(&vulkanContext->allocator, &textContext->transformBuffer, &textContext->transformAllocation);
+    destroyBuffer(&vulkanContext->allocator, &textContext->stagingBuffer, &textContext->stagingAllocation);
+    for (uint32_t i = 0; i < textContext->labelCapacity; i++) SDL_free(textContext->labels[i].text);
+    free(textContext->labels);
+    free(textContext->shapeGlyphs);
+    layout_cache_destroy(&textContext->layouts);
+    atlas_destroy(&textContext->atlas);
+    font_manager_destroy(&textContext->fonts);
+    memset(textContext, 0, sizeof(TextContext));
 }
\ No newline at end of file
@@ -0,0 +1,285 @@
+// module_transform.c
+#include "module_transform.h"
+#include <SDL3/SDL.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GROW_ARRAY(array, capacity) do { \
+        void *grown = realloc((array), (capacity) * sizeof(*(array))); \
+        if (!grown) return false; \
+        (array) = grown; \
+    } while (0)
+
+void transform_init(TransformHierarchy *hierarchy) {
+    memset(hierarchy, 0, sizeof(TransformHierarchy));
+    hierarchy->freeHead = TRANSFORM_HANDLE_INVALID;
+    hierarchy->dirtyBegin = UINT32_MAX;
+}
+
+void transform_destroy(TransformHierarchy *hierarchy) {
+    free(hierarchy->parents);
+    free(hierarchy->sizes);
+    free(hierarchy->locals);
+    free(hierarchy->worlds);
+    free(hierarchy->flags);
+    free(hierarchy->owners);
+    free(hierarchy->handles);
+    free(hierarchy->slotIndex);
+    transform_init(hierarchy);
+}
+
+void transform_affine_make(float x, float y, float rotation, TransformAffine *affine) {
+    float c = cosf(rotation);
+    float s = sinf(rotation);
+    *affine = (TransformAffine){ c, s, -s, c, x, y };
+}
+
+static bool grow_entries(TransformHierarchy *hierarchy) {
+    uint32_t capacity = hierarchy->capacity ? hierarchy->capacity * 2 : 64;
+    GROW_ARRAY(hierarchy->parents, capacity);
+    GROW_ARRAY(hierarchy->sizes, capacity);
+    GROW_ARRAY(hierarchy->locals, capacity);
+    GROW_ARRAY(hierarchy->worlds, capacity);
+    GROW_ARRAY(hierarchy->flags, capacity);
+    GROW_ARRAY(hierarchy->owners, capacity);
+    GROW_ARRAY(hierarchy->handles, capacity);
+    hierarchy->capacity = capacity;
+    return true;
+}
+
+static bool grow_slots(TransformHierarchy *hierarchy) {
+    uint32_t capacity = hierarchy->slotCapacity ? hierarchy->slotCapacity * 2 : 64;
+    GROW_ARRAY(hierarchy->slotIndex, capacity);
+    hierarchy->slotCapacity = capacity;
+    return true;
+}
+
+static bool transform_valid(const TransformHierarchy *hierarchy, TransformHandle handle) {
+    if (handle >= hierarchy->slotCount) return false;
+    uint32_t index = hierarchy->slotIndex[handle];
+    return index < hierarchy->count && hierarchy->handles[index] == handle;
+}
+
+static void mark_dirty(TransformHierarchy *hierarchy, uint32_t index) {
+    hierarchy->flags[index] |= TRANSFORM_FLAG_DIRTY;
+    hierarchy->dirtyBegin = SDL_min(hierarchy->dirtyBegin, index);
+    hierarchy->dirtyEnd = SDL_max(hierarchy->dirtyEnd, index + 1);
+}
+
+// Shift entries [from, count) so they start at to, for inserting or removing one entry at from
+static void shift_entries(TransformHierarchy *hierarchy, uint32_t from, uint32_t to) {
+    uint32_t n = hierarchy->count - from;
+    memmove(&hierarchy->parents[to], &hierarchy->parents[from], n * sizeof(uint32_t));
+    memmove(&hierarchy->sizes[to], &hierarchy->sizes[from], n * sizeof(uint32_t));
+    memmove(&hierarchy->locals[to], &hierarchy->locals[from], n * sizeof(TransformAffine));
+    memmove(&hierarchy->worlds[to], &hierarchy->worlds[from], n * sizeof(TransformAffine));
+    memmove(&hierarchy->flags[to], &hierarchy->flags[from], n * sizeof(uint8_t));
+    memmove(&hierarchy->owners[to], &hierarchy->owners[from], n * sizeof(uint32_t));
+    memmove(&hierarchy->handles[to], &hierarchy->handles[from], n * sizeof(TransformHandle));
+}
+
+// Move count elements from index from so they start at index to, shifting the elements between
+static void move_range(void *base, size_t size, uint32_t from, uint32_t count, uint32_t to, void *scratch) {
+    char *bytes = base;
+    memcpy(scratch, bytes + from * size, count * size);
+    if (to > from) {
+        memmove(bytes + from * size, bytes + (from + count) * size, (to - from) * size);
+    } else {
+        memmove(bytes + (to + count) * size, bytes + to * size, (from - to) * size);
+    }
+    memcpy(bytes + to * size, scratch, count * size);
+}
+
+static void move_entries(TransformHierarchy *hierarchy, uint32_t from, uint32_t count, uint32_t to, void *scratch) {
+    move_range(hierarchy->parents, sizeof(uint32_t), from, count, to, scratch);
+    move_range(hierarchy->sizes, sizeof(uint32_t), from, count, to, scratch);
+    move_range(hierarchy->locals, sizeof(TransformAffine), from, count, to, scratch);
+    move_range(hierarchy->worlds, sizeof(TransformAffine), from, count, to, scratch);
+    move_range(hierarchy->flags, sizeof(uint8_t), from, count, to, scratch);
+    move_range(hierarchy->owners, sizeof(uint32_t), from, count, to, scratch);
+    move_range(hierarchy->handles, sizeof(TransformHandle), from, count, to, scratch);
+}
+
+static void reindex_slots(TransformHierarchy *hierarchy, uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; i++) {
+        hierarchy->slotIndex[hierarchy->handles[i]] = i;
+    }
+}
+
+// Add delta to the subtree size of index and every ancestor
+static void resize_ancestors(TransformHierarchy *hierarchy, uint32_t index, int32_t delta) {
+    for (; index != TRANSFORM_ROOT; index = hierarchy->parents[index]) {
+        hierarchy->sizes[index] += delta;
+    }
+}
+
+TransformHandle transform_add(TransformHierarchy *hierarchy, TransformHandle parent, uint32_t owner, const TransformAffine *local) {
+    if (parent != TRANSFORM_HANDLE_INVALID && !transform_valid(hierarchy, parent)) return TRANSFORM_HANDLE_INVALID;
+    if (hierarchy->count == hierarchy->capacity && !grow_entries(hierarchy)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow transform hierarchy");
+        return TRANSFORM_HANDLE_INVALID;
+    }
+
+    TransformHandle handle;
+    if (hierarchy->freeHead != TRANSFORM_HANDLE_INVALID) {
+        handle = hierarchy->freeHead;
+        hierarchy->freeHead = hierarchy->slotIndex[handle];
+    } else {
+        if (hierarchy->slotCount == hierarchy->slotCapacity && !grow_slots(hierarchy)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow transform handle table");
+            return TRANSFORM_HANDLE_INVALID;
+        }
+        handle = hierarchy->slotCount++;
+    }
+
+    // Roots append; children go at the end of their parent's subtree
+    uint32_t parentIndex = parent == TRANSFORM_HANDLE_INVALID ? TRANSFORM_ROOT : hierarchy->slotIndex[parent];
+    uint32_t index = parentIndex == TRANSFORM_ROOT ? hierarchy->count : parentIndex + hierarchy->sizes[parentIndex];
+    shift_entries(hierarchy, index, index + 1);
+    hierarchy->count++;
+    for (uint32_t i = index + 1; i < hierarchy->count; i++) {
+        if (hierarchy->parents[i] != TRANSFORM_ROOT && hierarchy->parents[i] >= index) hierarchy->parents[i]++;
+    }
+    reindex_slots(hierarchy, index + 1, hierarchy->count);
+    if (hierarchy->dirtyBegin != UINT32_MAX && hierarchy->dirtyBegin >= index) hierarchy->dirtyBegin++;
+    if (hierarchy->dirtyEnd > index) hierarchy->dirtyEnd++;
+
+    hierarchy->parents[index] = parentIndex;
+    hierarchy->sizes[index] = 1;
+    hierarchy->locals[index] = *local;
+    hierarchy->flags[index] = 0;
+    hierarchy->owners[index] = owner;
+    hierarchy->handles[index] = handle;
+    hierarchy->slotIndex[handle] = index;
+    resize_ancestors(hierarchy, parentIndex, 1);
+    mark_dirty(hierarchy, index);
+    return handle;
+}
+
+bool transform_remove(TransformHierarchy *hierarchy, TransformHandle handle) {
+    if (!transform_valid(hierarchy, handle)) return false;
+    uint32_t index = hierarchy->slotIndex[handle];
+    uint32_t parentIndex = hierarchy->parents[index];
+    uint32_t size = hierarchy->sizes[index];
+
+    // Direct children take the removed entry's parent and need new world transforms
+    for (uint32_t i = index + 1; i < index + size; i++) {
+        if (hierarchy->parents[i] == index) {
+            hierarchy->parents[i] = parentIndex;
+            hierarchy->flags[i] |= TRANSFORM_FLAG_DIRTY;
+        }
+    }
+    resize_ancestors(hierarchy, parentIndex, -1);
+    shift_entries(hierarchy, index + 1, index);
+    hierarchy->count--;
+    for (uint32_t i = index; i < hierarchy->count; i++) {
+        if (hierarchy->parents[i] != TRANSFORM_ROOT && hierarchy->parents[i] > index) hierarchy->parents[i]--;
+    }
+    reindex_slots(hierarchy, index, hierarchy->count);
+    if (hierarchy->dirtyBegin != UINT32_MAX && hierarchy->dirtyBegin > index) hierarchy->dirtyBegin--;
+    if (hierarchy->dirtyEnd > index) hierarchy->dirtyEnd--;
+    if (size > 1) {
+        hierarchy->dirtyBegin = SDL_min(hierarchy->dirtyBegin, index);
+        hierarchy->dirtyEnd = SDL_max(hierarchy->dirtyEnd, index + size - 1);
+    }
+
+    hierarchy->slotIndex[handle] = hierarchy->freeHead;
+    hierarchy->freeHead = handle;
+    return true;
+}
+
+bool transform_set_parent(TransformHierarchy *hierarchy, TransformHandle handle, TransformHandle parent) {
+    if (!transform_valid(hierarchy, handle)) return false;
+    if (parent != TRANSFORM_HANDLE_INVALID && !transform_valid(hierarchy, parent)) return false;
+    uint32_t from = hierarchy->slotIndex[handle];
+    uint32_t size = hierarchy->sizes[from];
+    uint32_t oldParentIndex = hierarchy->parents[from];
+    uint32_t parentIndex = parent == TRANSFORM_HANDLE_INVALID ? TRANSFORM_ROOT : hierarchy->slotIndex[parent];
+    if (parentIndex != TRANSFORM_ROOT && parentIndex >= from && parentIndex < from + size) return false; // Cycle
+    if (parentIndex == oldParentIndex) return true;
+
+    void *scratch = malloc(size * sizeof(TransformAffine));
+    if (!scratch) return false;
+
+    // Detach, then find the insertion point as if the subtree were already gone
+    resize_ancestors(hierarchy, oldParentIndex, -(int32_t)size);
+    uint32_t to;
+    if (parentIndex == TRANSFORM_ROOT) {
+        to = hierarchy->count - size;
+    } else {
+        uint32_t shifted = parentIndex > from ? parentIndex - size : parentIndex;
+        to = shifted + hierarchy->sizes[parentIndex];
+    }
+
+    // Parents are held as handles while the block moves, then mapped back to dense indices
+    for (uint32_t i = 0; i < hierarchy->count; i++) {
+        if (hierarchy->parents[i] != TRANSFORM_ROOT) hierarchy->parents[i] = hierarchy->handles[hierarchy->parents[i]];
+    }
+    hierarchy->parents[from] = parent == TRANSFORM_HANDLE_INVALID ? TRANSFORM_ROOT : parent;
+    move_entries(hierarchy, from, size, to, scratch);
+    free(scratch);
+    uint32_t begin = SDL_min(from, to);
+    uint32_t end = SDL_max(from, to) + size;
+    reindex_slots(hierarchy, begin, end);
+    for (uint32_t i = 0; i < hierarchy->count; i++) {
+        if (hierarchy->parents[i] != TRANSFORM_ROOT) hierarchy->parents[i] = hierarchy->slotIndex[hierarchy->parents[i]];
+    }
+    resize_ancestors(hierarchy, hierarchy->parents[to], (int32_t)size);
+
+    // Flags moved with their entries somewhere inside [begin, end)
+    if (hierarchy->dirtyBegin < hierarchy->dirtyEnd) {
+        hierarchy->dirtyBegin = SDL_min(hierarchy->dirtyBegin, begin);
+        hierarchy->dirtyEnd = SDL_max(hierarchy->dirtyEnd, end);
+    }
+    mark_dirty(hierarchy, to);
+    return true;
+}
+
+bool transform_set_local(TransformHierarchy *hierarchy, TransformHandle handle, const TransformAffine *local) {
+    if (!transform_valid(hierarchy, handle)) return false;
+    uint32_t index = hierarchy->slotIndex[handle];
+    hierarchy->locals[index] = *local;
+    mark_dirty(hierarchy, index);
+    return true;
+}
+
+const TransformAffine *transform_get_world(const TransformHierarchy *hierarchy, TransformHandle handle) {
+    if (!transform_valid(hierarchy, handle)) return NULL;
+    return &hierarchy->worlds[hierarchy->slotIndex[handle]];
+}
+
+uint32_t transform_update(TransformHierarchy *hierarchy, TransformVisitor visit, void *userData) {
+    uint32_t updated = 0;
+    uint32_t subtreeEnd = 0; // End of the dirty subtree being walked
+    uint32_t end = SDL_min(hierarchy->dirtyEnd, hierarchy->count);
+    for (uint32_t i = hierarchy->dirtyBegin; i < end || i < subtreeEnd; i++) {
+        if (hierarchy->flags[i] & TRANSFORM_FLAG_DIRTY) {
+            hierarchy->flags[i] &= ~TRANSFORM_FLAG_DIRTY;
+            subtreeEnd = SDL_max(subtreeEnd, i + hierarchy->sizes[i]);
+        }
+        if (i >= subtreeEnd) continue;
+
+        const TransformAffine *l = &hierarchy->locals[i];
+        TransformAffine *w = &hierarchy->worlds[i];
+        uint32_t parentIndex = hierarchy->parents[i];
+        if (parentIndex == TRANSFORM_ROOT) {
+            *w = *l;
+        } else {
+            const TransformAffine *p = &hierarchy->worlds[parentIndex];
+            *w = (TransformAffine){
+                p->a * l->a + p->c * l->b,
+                p->b * l->a + p->d * l->b,
+                p->a * l->c + p->c * l->d,
+                p->b * l->c + p->d * l->d,
+                p->a * l->tx + p->c * l->ty + p->tx,
+                p->b * l->tx + p->d * l->ty + p->ty
+            };
+        }
+        if (visit) visit(userData, hierarchy->owners[i], w);
+        updated++;
+    }
+    hierarchy->dirtyBegin = UINT32_MAX;
+    hierarchy->dirtyEnd = 0;
+    return updated;
+}
@@ -0,0 +1,249 @@
+// module_upload.c
+#include "module_upload.h"
+#include "vulkan_utils.h"
+#include <SDL3/SDL.h>
+#include <string.h>
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+bool upload_init(UploadManager *upload, VkDevice device, MemoryAllocator *allocator,
+                 uint32_t transferFamily, VkQueue transferQueue, uint32_t graphicsFamily) {
+    memset(upload, 0, sizeof(UploadManager));
+    upload->device = device;
+    upload->allocator = allocator;
+    upload->queue = transferQueue;
+    upload->queueFamily = transferFamily;
+    upload->queueFamilies[0] = transferFamily;
+    upload->queueFamilies[1] = graphicsFamily;
+    upload->queueFamilyCount = transferFamily == graphicsFamily ? 1 : 2;
+
+    VkCommandPoolCreateInfo poolInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .queueFamilyIndex = transferFamily,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+    };
+    if (vkCreateCommandPool(device, &poolInfo, NULL, &upload->commandPool) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create upload command pool");
+        upload_cleanup(upload);
+        return false;
+    }
+    VkCommandBuffer commandBuffers[UPLOAD_BATCH_COUNT];
+    VkCommandBufferAllocateInfo allocInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = upload->commandPool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = UPLOAD_BATCH_COUNT
+    };
+    if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate upload command buffers");
+        upload_cleanup(upload);
+        return false;
+    }
+    for (uint32_t i = 0; i < UPLOAD_BATCH_COUNT; i++) {
+        upload->batches[i].commandBuffer = commandBuffers[i];
+    }
+
+    VkSemaphoreTypeCreateInfo timelineInfo = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0
+    };
+    VkSemaphoreCreateInfo semaphoreInfo = { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, .pNext = &timelineInfo };
+    if (vkCreateSemaphore(device, &semaphoreInfo, NULL, &upload->timeline) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create upload timeline semaphore");
+        upload_cleanup(upload);
+        return false;
+    }
+
+    if (!createBuffer(allocator, UPLOAD_STAGING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                      &upload->stagingBuffer, &upload->stagingAllocation)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create upload staging ring");
+        upload_cleanup(upload);
+        return false;
+    }
+
+    SDL_Log("Upload manager using queue family %u (%s), %llu MiB staging ring", transferFamily,
+            upload->queueFamilyCount > 1 ? "dedicated transfer" : "shared with graphics",
+            (unsigned long long)(UPLOAD_STAGING_SIZE / (1024 * 1024)));
+    return true;
+}
+
+// Callers must idle the device first
+void upload_cleanup(UploadManager *upload) {
+    if (upload->device == VK_NULL_HANDLE) return;
+    destroyBuffer(upload->allocator, &upload->stagingBuffer, &upload->stagingAllocation);
+    vkDestroySemaphore(upload->device, upload->timeline, NULL);
+    vkDestroyCommandPool(upload->device, upload->commandPool, NULL);
+    memset(upload, 0, sizeof(UploadManager));
+}
+
+void upload_get_sharing(const UploadManager *upload, VkSharingMode *sharingMode, uint32_t *familyCount, const uint32_t **families) {
+    // Concurrent sharing lets the graphics queue read transfer-queue writes without ownership transfers
+    *sharingMode = upload->queueFamilyCount > 1 ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+    *familyCount = upload->queueFamilyCount > 1 ? upload->queueFamilyCount : 0;
+    *families = upload->queueFamilies;
+}
+
+// Release staging space and batch slots of every submission the timeline has passed
+static void retire_batches(UploadManager *upload) {
+    uint64_t value = upload->completedValue;
+    vkGetSemaphoreCounterValue(upload->device, upload->timeline, &value);
+    upload->completedValue = value;
+
+    uint64_t newest = 0;
+    for (uint32_t i = 0; i < UPLOAD_BATCH_COUNT; i++) {
+        UploadBatch *batch = &upload->batches[i];
+        if (batch->recording || batch->value == 0 || batch->value > value) continue;
+        if (batch->value > newest) {
+            newest = batch->value;
+            upload->tail = batch->ringEnd;
+        }
+        batch->value = 0;
+    }
+    // Rewind only an empty ring: nothing in flight and nothing staged for the next submit
+    if (upload->completedValue == upload->submittedValue && upload->pendingBytes == 0 &&
+        !upload->batches[upload->currentBatch].recording) {
+        upload->head = 0;
+        upload->tail = 0;
+    }
+}
+
+static bool wait_value(UploadManager *upload, uint64_t value) {
+    VkSemaphoreWaitInfo waitInfo = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores = &upload->timeline,
+        .pValues = &value
+    };
+    if (vkWaitSemaphores(upload->device, &waitInfo, UINT64_MAX) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to wait for upload timeline value %llu", (unsigned long long)value);
+        return false;
+    }
+    retire_batches(upload);
+    return true;
+}
+
+// Carve size bytes out of the staging ring; the head never catches up with the tail
+static bool try_ring_alloc(UploadManager *upload, VkDeviceSize size, VkDeviceSize *offset) {
+    VkDeviceSize start = align_up(upload->head, UPLOAD_ALIGNMENT);
+    if (upload->head >= upload->tail) {
+        if (start + size > UPLOAD_STAGING_SIZE) {
+            if (size >= upload->tail) return false;
+            start = 0;
+        }
+    } else if (start + size >= upload->tail) {
+        return false;
+    }
+    *offset = start;
+    upload->head = start + size;
+    return true;
+}
+
+static bool ring_alloc(UploadManager *upload, VkDeviceSize size, VkDeviceSize *offset) {
+    if (try_ring_alloc(upload, size, offset)) return true;
+    retire_batches(upload);
+    if (try_ring_alloc(upload, size, offset)) return true;
+
+    // Ring full: submit what is pending and wait for the GPU to drain it
+    upload->stats.stalls++;
+    upload_flush(upload);
+    if (!wait_value(upload, upload->submittedValue)) return false;
+    return try_ring_alloc(upload, size, offset);
+}
+
+static VkCommandBuffer begin_batch(UploadManager *upload) {
+    UploadBatch *batch = &upload->batches[upload->currentBatch];
+    if (batch->recording) return batch->commandBuffer;
+    if (batch->value != 0) {
+        // Every slot is in flight; wait for the oldest one
+        upload->stats.stalls++;
+        if (!wait_value(upload, batch->value)) return VK_NULL_HANDLE;
+    }
+    vkResetCommandBuffer(batch->commandBuffer, 0);
+    VkCommandBufferBeginInfo beginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+    vkBeginCommandBuffer(batch->commandBuffer, &beginInfo);
+    batch->recording = true;
+    return batch->commandBuffer;
+}
+
+static bool stage(UploadManager *upload, const void *data, VkDeviceSize size, VkDeviceSize *offset) {
+    if (size == 0 || size > UPLOAD_STAGING_SIZE / 2) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Upload of %llu bytes does not fit the staging ring", (unsigned long long)size);
+        return false;
+    }
+    if (!ring_alloc(upload, size, offset)) return false;
+    memcpy((char *)upload->stagingAllocation.mapped + *offset, data, size);
+    upload->pendingBytes += size;
+    upload->stats.bytesQueued += size;
+    upload->stats.uploadsQueued++;
+    return true;
+}
+
+UploadHandle upload_buffer(UploadManager *upload, VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size) {
+    // Stage into a batch that is already recording; a full ring submits it to make room, and the
+    // copy then goes into the next one
+    VkDeviceSize stagingOffset;
+    if (begin_batch(upload) == VK_NULL_HANDLE || !stage(upload, data, size, &stagingOffset)) return UPLOAD_HANDLE_INVALID;
+    VkCommandBuffer commandBuffer = begin_batch(upload);
+    if (commandBuffer == VK_NULL_HANDLE) return UPLOAD_HANDLE_INVALID;
+
+    VkBufferCopy region = { .srcOffset = stagingOffset, .dstOffset = offset, .size = size };
+    vkCmdCopyBuffer(commandBuffer, upload->stagingBuffer, buffer, 1, &region);
+    return upload->submittedValue + 1;
+}
+
+// Submit the copies recorded since the last flush as one batch. Returns the timeline value
+// the graphics queue must wait on before reading anything uploaded so far (0 if nothing ever was).
+uint64_t upload_flush(UploadManager *upload) {
+    UploadBatch *batch = &upload->batches[upload->currentBatch];
+    if (batch->recording) {
+        vkEndCommandBuffer(batch->commandBuffer);
+        uint64_t value = upload->submittedValue + 1;
+        VkTimelineSemaphoreSubmitInfo timelineInfo = {
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .signalSemaphoreValueCount = 1,
+            .pSignalSemaphoreValues = &value
+        };
+        VkSubmitInfo submitInfo = {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = &timelineInfo,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &batch->commandBuffer,
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &upload->timeline
+        };
+        batch->recording = false;
+        upload->pendingBytes = 0; // Submitted, or dropped with the batch when the submit fails
+        if (vkQueueSubmit(upload->queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to submit upload batch");
+        } else {
+            batch->value = value;
+            batch->ringEnd = upload->head;
+            upload->submittedValue = value;
+            upload->stats.batchesSubmitted++;
+            upload->currentBatch = (upload->currentBatch + 1) % UPLOAD_BATCH_COUNT;
+        }
+    }
+    retire_batches(upload);
+    return upload->submittedValue;
+}
+
+bool upload_is_complete(UploadManager *upload, UploadHandle handle) {
+    if (handle == UPLOAD_HANDLE_INVALID || handle > upload->submittedValue) return false;
+    if (handle > upload->completedValue) retire_batches(upload);
+    return handle <= upload->completedValue;
+}
+
+// Blocking fallback for callers that cannot proceed without the data
+bool upload_wait(UploadManager *upload, UploadHandle handle) {
+    if (handle == UPLOAD_HANDLE_INVALID) return false;
+    if (handle > upload->submittedValue) upload_flush(upload);
+    if (handle <= upload->completedValue) return true;
+    return wait_value(upload, handle);
+}
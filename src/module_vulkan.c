@@ -12,6 +12,7 @@
 #include "module_vulkan.h"
 #include "vulkan_utils.h"
 #include "module_text.h"
+#include "module_wire.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include "shader2d_vert_spv.h"
@@ -19,30 +20,436 @@
 #include <string.h>
 
 
-static const Vertex triangleVertices[] = {
+// Every NodeMesh lives in one vertex and one index buffer
+static const Vertex meshVertices[] = {
+    // Triangle
     {0.0f, -0.5f, 1.0f, 0.0f, 0.0f},
     {0.5f, 0.5f, 0.0f, 1.0f, 0.0f},
-    {-0.5f, 0.5f, 0.0f, 0.0f, 1.0f}
-};
-
-static const Vertex squareVertices[] = {
+    {-0.5f, 0.5f, 0.0f, 0.0f, 1.0f},
+    // Square
     {-0.25f, -0.25f, 0.0f, 1.0f, 1.0f},
     {0.25f, -0.25f, 0.0f, 1.0f, 1.0f},
     {-0.25f, 0.25f, 0.0f, 1.0f, 1.0f},
     {0.25f, 0.25f, 0.0f, 1.0f, 1.0f}
 };
 
-static const uint32_t squareIndices[] = {0, 1, 2, 2, 1, 3};
+static const uint32_t meshIndices[] = {
+    0, 1, 2,         // Triangle
+    0, 1, 2, 2, 1, 3 // Square
+};
 
+typedef struct {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t vertexOffset;
+} MeshRange;
 
-bool vulkan_init(SDL_Window *window, VulkanContext *context) {
-    // Initialize Vulkan instance
-    uint32_t extensionCount = 0;
-    const char *const *extensions = SDL_Vulkan_GetInstanceExtensions(&extensionCount);
-    if (!extensions) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to get Vulkan extensions: %s", SDL_GetError());
+static const MeshRange meshRanges[NODE_MESH_COUNT] = {
+    [NODE_MESH_TRIANGLE] = { 0, 3, 0 },
+    [NODE_MESH_SQUARE] = { 3, 6, 3 }
+};
+
+#define NODE_INITIAL_CAPACITY 1024
+#define PIPELINE_CACHE_FILE "pipeline_cache.bin"
+
+
+static bool create_node_buffer(VulkanContext *context, uint32_t capacity) {
+    VkDeviceSize alignment = context->storageAlignment;
+    context->nodeRegionSize = (capacity * sizeof(NodeInstance) + alignment - 1) & ~(alignment - 1);
+    VkDeviceSize bufferSize = context->nodeRegionSize * context->framesInFlight;
+    if (!createBuffer(&context->allocator, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                     &context->nodeBuffer, &context->nodeAllocation)) {
+        return false;
+    }
+    context->nodeBufferMapped = context->nodeAllocation.mapped;
+    context->nodeCapacity = capacity;
+    return true;
+}
+
+static void write_node_descriptor(VulkanContext *context) {
+    VkDescriptorBufferInfo nodeBufferInfo = {
+        .buffer = context->nodeBuffer,
+        .offset = 0,
+        .range = context->nodeRegionSize
+    };
+    VkWriteDescriptorSet descriptorWrite = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = context->descriptorSet,
+        .dstBinding = 1,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+        .pBufferInfo = &nodeBufferInfo
+    };
+    vkUpdateDescriptorSets(context->device, 1, &descriptorWrite, 0, NULL);
+}
+
+// Growing is rare (capacity doubles), so it is allowed to drain the GPU
+static bool ensure_node_capacity(VulkanContext *context, uint32_t count) {
+    if (count <= context->nodeCapacity) return true;
+    uint32_t capacity = context->nodeCapacity ? context->nodeCapacity : NODE_INITIAL_CAPACITY;
+    while (capacity < count) capacity *= 2;
+    vkDeviceWaitIdle(context->device);
+    destroyBuffer(&context->allocator, &context->nodeBuffer, &context->nodeAllocation);
+    context->nodeBufferMapped = NULL;
+    if (!create_node_buffer(context, capacity)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow node instance buffer to %u nodes", capacity);
+        context->nodeCapacity = 0;
+        return false;
+    }
+    write_node_descriptor(context);
+    SDL_Log("Node instance buffer grown to %u nodes", capacity);
+    return true;
+}
+
+
+static void destroy_swapchain_images(VkDevice device, VkImageView *imageViews, VkFramebuffer *framebuffers,
+                                     VkSemaphore *renderFinishedSemaphores, uint32_t imageCount) {
+    for (uint32_t i = 0; i < imageCount; i++) {
+        if (framebuffers) vkDestroyFramebuffer(device, framebuffers[i], NULL);
+        if (imageViews) vkDestroyImageView(device, imageViews[i], NULL);
+        if (renderFinishedSemaphores) vkDestroySemaphore(device, renderFinishedSemaphores[i], NULL);
+    }
+    free(framebuffers);
+    free(imageViews);
+    free(renderFinishedSemaphores);
+}
+
+static void destroy_retired_swapchain(VulkanContext *context, RetiredSwapchain *retired) {
+    destroy_swapchain_images(context->device, retired->imageViews, retired->framebuffers,
+                             retired->renderFinishedSemaphores, retired->imageCount);
+    free(retired->fencesInUse);
+    vkDestroySwapchainKHR(context->device, retired->swapchain, NULL);
+}
+
+// Destroy retired swapchains once a full cycle of frames in flight has completed after their last
+// submission. That submission's fence only covers the GPU work; its present may still be waiting on
+// a renderFinished semaphore, and presents queued behind it are what show that wait is over.
+static void release_retired_swapchains(VulkanContext *context) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < context->retiredSwapchainCount; i++) {
+        RetiredSwapchain *retired = &context->retiredSwapchains[i];
+        if (retired->retireSerial + context->framesInFlight <= context->completedSerial) {
+            destroy_retired_swapchain(context, retired);
+        } else {
+            context->retiredSwapchains[kept++] = *retired;
+        }
+    }
+    context->retiredSwapchainCount = kept;
+}
+
+// Hand the current swapchain and its per-image resources to the retire list
+static void retire_swapchain(VulkanContext *context) {
+    if (context->retiredSwapchainCount == MAX_RETIRED_SWAPCHAINS) {
+        // The GPU fell far behind a burst of resizes; wait for it, presents included, and free the list
+        vkDeviceWaitIdle(context->device);
+        context->completedSerial = context->submitSerial;
+        for (uint32_t i = 0; i < context->retiredSwapchainCount; i++) {
+            destroy_retired_swapchain(context, &context->retiredSwapchains[i]);
+        }
+        context->retiredSwapchainCount = 0;
+    }
+    context->retiredSwapchains[context->retiredSwapchainCount++] = (RetiredSwapchain){
+        .swapchain = context->swapchain,
+        .imageViews = context->imageViews,
+        .framebuffers = context->framebuffers,
+        .renderFinishedSemaphores = context->renderFinishedSemaphores,
+        .fencesInUse = context->fencesInUse,
+        .imageCount = context->imageCount,
+        .retireSerial = context->submitSerial
+    };
+    context->swapchain = VK_NULL_HANDLE;
+    context->imageViews = NULL;
+    context->framebuffers = NULL;
+    context->renderFinishedSemaphores = NULL;
+    context->fencesInUse = NULL;
+    context->imageCount = 0;
+}
+
+// Create a swapchain for the current surface extent, passing the existing one as oldSwapchain.
+// The previous swapchain is retired, not destroyed, so frames still in flight keep their resources.
+static bool create_swapchain(VulkanContext *context) {
+    VkSurfaceCapabilitiesKHR capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(context->physicalDevice, context->surface, &capabilities);
+    VkExtent2D extent = capabilities.currentExtent;
+    if (extent.width == UINT32_MAX) {
+        // The surface size is defined by the swapchain; use the window size in pixels
+        int width, height;
+        SDL_GetWindowSizeInPixels(context->window, &width, &height);
+        extent.width = SDL_clamp((uint32_t)width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+        extent.height = SDL_clamp((uint32_t)height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+    }
+    if (extent.width == 0 || extent.height == 0) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Window minimized, skipping swapchain creation");
+        return false;
+    }
+
+    uint32_t minImageCount = capabilities.minImageCount + 1;
+    if (capabilities.maxImageCount > 0 && minImageCount > capabilities.maxImageCount) {
+        minImageCount = capabilities.maxImageCount;
+    }
+    uint32_t queueFamilyIndices[] = { context->graphicsFamily, context->presentFamily };
+    VkSwapchainKHR oldSwapchain = context->swapchain;
+    VkSwapchainCreateInfoKHR swapchainInfo = {
+        .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+        .surface = context->surface,
+        .minImageCount = minImageCount,
+        .imageFormat = context->surfaceFormat.format,
+        .imageColorSpace = context->surfaceFormat.colorSpace,
+        .imageExtent = extent,
+        .imageArrayLayers = 1,
+        .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        .imageSharingMode = queueFamilyIndices[0] == queueFamilyIndices[1] ? VK_SHARING_MODE_EXCLUSIVE : VK_SHARING_MODE_CONCURRENT,
+        .queueFamilyIndexCount = queueFamilyIndices[0] == queueFamilyIndices[1] ? 0 : 2,
+        .pQueueFamilyIndices = queueFamilyIndices,
+        .preTransform = capabilities.currentTransform,
+        .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
+        .presentMode = context->presentMode,
+        .clipped = VK_TRUE,
+        .oldSwapchain = oldSwapchain
+    };
+    VkSwapchainKHR swapchain;
+    VkResult result = vkCreateSwapchainKHR(context->device, &swapchainInfo, NULL, &swapchain);
+
+    // oldSwapchain is retired by the call even when it fails
+    if (oldSwapchain != VK_NULL_HANDLE) {
+        retire_swapchain(context);
+    }
+    if (result != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create swapchain");
+        return false;
+    }
+
+    // Create per-image resources
+    uint32_t imageCount = 0;
+    vkGetSwapchainImagesKHR(context->device, swapchain, &imageCount, NULL);
+    VkImage *images = malloc(imageCount * sizeof(VkImage));
+    VkImageView *imageViews = calloc(imageCount, sizeof(VkImageView));
+    VkFramebuffer *framebuffers = calloc(imageCount, sizeof(VkFramebuffer));
+    VkSemaphore *renderFinishedSemaphores = calloc(imageCount, sizeof(VkSemaphore));
+    VkFence *fencesInUse = calloc(imageCount, sizeof(VkFence));
+    bool success = images && imageViews && framebuffers && renderFinishedSemaphores && fencesInUse;
+    if (success) {
+        vkGetSwapchainImagesKHR(context->device, swapchain, &imageCount, images);
+    }
+    VkSemaphoreCreateInfo semaphoreInfo = { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    for (uint32_t i = 0; success && i < imageCount; i++) {
+        VkImageViewCreateInfo viewInfo = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = images[i],
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = context->surfaceFormat.format,
+            .components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY },
+            .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .subresourceRange.baseMipLevel = 0,
+            .subresourceRange.levelCount = 1,
+            .subresourceRange.baseArrayLayer = 0,
+            .subresourceRange.layerCount = 1
+        };
+        if (vkCreateImageView(context->device, &viewInfo, NULL, &imageViews[i]) != VK_SUCCESS) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create image view %u", i);
+            success = false;
+            break;
+        }
+        VkFramebufferCreateInfo framebufferInfo = {
+            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+            .renderPass = context->renderPass,
+            .attachmentCount = 1,
+            .pAttachments = &imageViews[i],
+            .width = extent.width,
+            .height = extent.height,
+            .layers = 1
+        };
+        if (vkCreateFramebuffer(context->device, &framebufferInfo, NULL, &framebuffers[i]) != VK_SUCCESS) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create framebuffer %u", i);
+            success = false;
+            break;
+        }
+        if (vkCreateSemaphore(context->device, &semaphoreInfo, NULL, &renderFinishedSemaphores[i]) != VK_SUCCESS) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create render finished semaphore %u", i);
+            success = false;
+            break;
+        }
+    }
+    free(images);
+    if (!success) {
+        destroy_swapchain_images(context->device, imageViews, framebuffers, renderFinishedSemaphores, imageCount);
+        free(fencesInUse);
+        vkDestroySwapchainKHR(context->device, swapchain, NULL);
+        return false;
+    }
+
+    context->swapchain = swapchain;
+    context->swapchainExtent = extent;
+    context->imageViews = imageViews;
+    context->framebuffers = framebuffers;
+    context->renderFinishedSemaphores = renderFinishedSemaphores;
+    context->fencesInUse = fencesInUse;
+    context->imageCount = imageCount;
+    return true;
+}
+
+// Headless counterpart of create_swapchain: one offscreen color target per frame in flight.
+// Images end each frame in TRANSFER_SRC_OPTIMAL so the last one can be read back.
+static bool create_offscreen_targets(VulkanContext *context) {
+    uint32_t imageCount = context->framesInFlight;
+    context->offscreenImages = calloc(imageCount, sizeof(VkImage));
+    context->offscreenAllocations = calloc(imageCount, sizeof(MemoryAllocation));
+    context->imageViews = calloc(imageCount, sizeof(VkImageView));
+    context->framebuffers = calloc(imageCount, sizeof(VkFramebuffer));
+    if (!context->offscreenImages || !context->offscreenAllocations || !context->imageViews || !context->framebuffers) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate offscreen target arrays");
+        return false;
+    }
+    context->imageCount = imageCount;
+
+    VkExtent2D extent = context->swapchainExtent;
+    for (uint32_t i = 0; i < imageCount; i++) {
+        VkImageCreateInfo imageInfo = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = context->surfaceFormat.format,
+            .extent = { extent.width, extent.height, 1 },
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+        };
+        if (!createImage(&context->allocator, &imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                         &context->offscreenImages[i], &context->offscreenAllocations[i])) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create offscreen image %u", i);
+            return false;
+        }
+        VkImageViewCreateInfo viewInfo = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = context->offscreenImages[i],
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = context->surfaceFormat.format,
+            .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .subresourceRange.levelCount = 1,
+            .subresourceRange.layerCount = 1
+        };
+        if (vkCreateImageView(context->device, &viewInfo, NULL, &context->imageViews[i]) != VK_SUCCESS) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create offscreen image view %u", i);
+            return false;
+        }
+        VkFramebufferCreateInfo framebufferInfo = {
+            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+            .renderPass = context->renderPass,
+            .attachmentCount = 1,
+            .pAttachments = &context->imageViews[i],
+            .width = extent.width,
+            .height = extent.height,
+            .layers = 1
+        };
+        if (vkCreateFramebuffer(context->device, &framebufferInfo, NULL, &context->framebuffers[i]) != VK_SUCCESS) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create offscreen framebuffer %u", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool has_instance_layer(const char *name) {
+    uint32_t layerCount = 0;
+    vkEnumerateInstanceLayerProperties(&layerCount, NULL);
+    VkLayerProperties *layers = malloc(layerCount * sizeof(VkLayerProperties));
+    if (!layers) return false;
+    vkEnumerateInstanceLayerProperties(&layerCount, layers);
+    bool found = false;
+    for (uint32_t i = 0; i < layerCount && !found; i++) {
+        found = strcmp(layers[i].layerName, name) == 0;
+    }
+    free(layers);
+    return found;
+}
+
+static const struct {
+    const char *name;
+    VkPresentModeKHR mode;
+} presentModeNames[] = {
+    { "fifo", VK_PRESENT_MODE_FIFO_KHR },
+    { "fifo-relaxed", VK_PRESENT_MODE_FIFO_RELAXED_KHR },
+    { "mailbox", VK_PRESENT_MODE_MAILBOX_KHR },
+    { "immediate", VK_PRESENT_MODE_IMMEDIATE_KHR }
+};
+
+void vulkan_present_config_init(PresentConfig *config) {
+    config->presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    config->framesInFlight = FRAMES_IN_FLIGHT;
+    config->paceFps = 0;
+    config->recordThreads = 1;
+    const char *value = SDL_getenv("NODE2D_PRESENT_MODE");
+    if (value && !vulkan_parse_present_mode(value, &config->presentMode)) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Unknown NODE2D_PRESENT_MODE '%s'", value);
+    }
+    if ((value = SDL_getenv("NODE2D_FRAMES_IN_FLIGHT"))) config->framesInFlight = (uint32_t)atoi(value);
+    if ((value = SDL_getenv("NODE2D_PACE_FPS"))) config->paceFps = (uint32_t)atoi(value);
+    if ((value = SDL_getenv("NODE2D_RECORD_THREADS"))) config->recordThreads = (uint32_t)atoi(value);
+}
+
+bool vulkan_parse_present_mode(const char *name, VkPresentModeKHR *mode) {
+    for (uint32_t i = 0; i < SDL_arraysize(presentModeNames); i++) {
+        if (SDL_strcasecmp(name, presentModeNames[i].name) == 0) {
+            *mode = presentModeNames[i].mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *vulkan_present_mode_name(VkPresentModeKHR mode) {
+    for (uint32_t i = 0; i < SDL_arraysize(presentModeNames); i++) {
+        if (presentModeNames[i].mode == mode) return presentModeNames[i].name;
+    }
+    return "unknown";
+}
+
+// Walk the fallback chain of the requested mode; FIFO is always supported
+static VkPresentModeKHR choose_present_mode(const VkPresentModeKHR *modes, uint32_t count, VkPresentModeKHR requested) {
+    VkPresentModeKHR chain[3] = { requested, VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR };
+    if (requested == VK_PRESENT_MODE_MAILBOX_KHR) chain[1] = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    if (requested == VK_PRESENT_MODE_IMMEDIATE_KHR) chain[1] = VK_PRESENT_MODE_MAILBOX_KHR;
+    for (uint32_t c = 0; c < SDL_arraysize(chain); c++) {
+        for (uint32_t i = 0; i < count; i++) {
+            if (modes[i] == chain[c]) return chain[c];
+        }
+    }
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+// Create a device-local buffer and queue its contents on the upload manager
+static bool create_static_buffer(VulkanContext *context, VkBufferUsageFlags usage, const void *data, VkDeviceSize size,
+                                 VkBuffer *buffer, MemoryAllocation *allocation) {
+    VkBufferCreateInfo bufferInfo = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+    };
+    upload_get_sharing(&context->upload, &bufferInfo.sharingMode, &bufferInfo.queueFamilyIndexCount, &bufferInfo.pQueueFamilyIndices);
+    if (!createBufferWithInfo(&context->allocator, &bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, allocation)) {
         return false;
     }
+    return upload_buffer(&context->upload, *buffer, 0, data, size) != UPLOAD_HANDLE_INVALID;
+}
+
+
+// Shared by vulkan_init and vulkan_init_headless; context->headless selects the presentation path
+static bool init_context(VulkanContext *context) {
+    // Initialize Vulkan instance; headless needs no surface extensions
+    uint32_t extensionCount = 0;
+    const char *const *extensions = NULL;
+    if (!context->headless) {
+        extensions = SDL_Vulkan_GetInstanceExtensions(&extensionCount);
+        if (!extensions) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to get Vulkan extensions: %s", SDL_GetError());
+            return false;
+        }
+    }
 
     VkApplicationInfo appInfo = {
         .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
@@ -53,25 +460,26 @@ bool vulkan_init(SDL_Window *window, VulkanContext *context) {
         .apiVersion = VK_API_VERSION_1_3
     };
 
+    // Validation is enabled when installed; perf lab machines only ship the ICD
     const char *validationLayers[] = { "VK_LAYER_KHRONOS_validation" };
     VkInstanceCreateInfo createInfo = {
         .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
         .pApplicationInfo = &appInfo,
         .enabledExtensionCount = extensionCount,
         .ppEnabledExtensionNames = extensions,
-        .enabledLayerCount = 1,
+        .enabledLayerCount = has_instance_layer(validationLayers[0]) ? 1 : 0,
         .ppEnabledLayerNames = validationLayers
     };
-    
+
     if (vkCreateInstance(&createInfo, NULL, &context->instance) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create Vulkan instance");
         return false;
     }
 
     // Create surface
-    if (!SDL_Vulkan_CreateSurface(window, context->instance, NULL, &context->surface)) {
+    if (!context->headless && !SDL_Vulkan_CreateSurface(context->window, context->instance, NULL, &context->surface)) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create Vulkan surface: %s", SDL_GetError());
-        vkDestroyInstance(context->instance, NULL);
+        vulkan_cleanup(context);
         return false;
     }
 
@@ -80,8 +488,7 @@ bool vulkan_init(SDL_Window *window, VulkanContext *context) {
     vkEnumeratePhysicalDevices(context->instance, &deviceCount, NULL);
     if (deviceCount == 0) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "No Vulkan physical devices found");
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+        vulkan_cleanup(context);
         return false;
     }
     VkPhysicalDevice *devices = malloc(deviceCount * sizeof(VkPhysicalDevice));
@@ -100,142 +507,114 @@ bool vulkan_init(SDL_Window *window, VulkanContext *context) {
         if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
             context->graphicsFamily = i;
         }
-        VkBool32 presentSupport = VK_FALSE;
-        vkGetPhysicalDeviceSurfaceSupportKHR(context->physicalDevice, i, context->surface, &presentSupport);
-        if (presentSupport) {
-            context->presentFamily = i;
+        if (context->headless) {
+            context->presentFamily = context->graphicsFamily; // Nothing is presented
+        } else {
+            VkBool32 presentSupport = VK_FALSE;
+            vkGetPhysicalDeviceSurfaceSupportKHR(context->physicalDevice, i, context->surface, &presentSupport);
+            if (presentSupport) {
+                context->presentFamily = i;
+            }
         }
         if (context->graphicsFamily != UINT32_MAX && context->presentFamily != UINT32_MAX) {
             break;
         }
     }
-    free(queueFamilies);
     if (context->graphicsFamily == UINT32_MAX || context->presentFamily == UINT32_MAX) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to find required queue families");
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+        free(queueFamilies);
+        vulkan_cleanup(context);
         return false;
     }
 
+    // Prefer a transfer-only family (DMA engine) for uploads, then any non-graphics family with transfer
+    context->transferFamily = context->graphicsFamily;
+    for (uint32_t pass = 0; pass < 2 && context->transferFamily == context->graphicsFamily; pass++) {
+        for (uint32_t i = 0; i < queueFamilyCount; i++) {
+            VkQueueFlags flags = queueFamilies[i].queueFlags;
+            if (!(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT)) continue;
+            if (pass == 0 && (flags & VK_QUEUE_COMPUTE_BIT)) continue;
+            context->transferFamily = i;
+            break;
+        }
+    }
+    free(queueFamilies);
+
     // Create logical device
     float queuePriority = 1.0f;
-    VkDeviceQueueCreateInfo queueCreateInfos[2] = {
-        {
-            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-            .queueFamilyIndex = context->graphicsFamily,
-            .queueCount = 1,
-            .pQueuePriorities = &queuePriority
-        },
-        {
+    uint32_t uniqueFamilies[] = { context->graphicsFamily, context->presentFamily, context->transferFamily };
+    VkDeviceQueueCreateInfo queueCreateInfos[3];
+    uint32_t queueCreateInfoCount = 0;
+    for (uint32_t i = 0; i < SDL_arraysize(uniqueFamilies); i++) {
+        bool seen = false;
+        for (uint32_t j = 0; j < queueCreateInfoCount; j++) {
+            seen |= queueCreateInfos[j].queueFamilyIndex == uniqueFamilies[i];
+        }
+        if (seen) continue;
+        queueCreateInfos[queueCreateInfoCount++] = (VkDeviceQueueCreateInfo){
             .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-            .queueFamilyIndex = context->presentFamily,
+            .queueFamilyIndex = uniqueFamilies[i],
             .queueCount = 1,
             .pQueuePriorities = &queuePriority
-        }
-    };
-    uint32_t queueCreateInfoCount = context->graphicsFamily == context->presentFamily ? 1 : 2;
+        };
+    }
     const char *deviceExtensions[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    // Timeline semaphores signal upload completion
+    VkPhysicalDeviceVulkan12Features features12 = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .timelineSemaphore = VK_TRUE
+    };
     VkDeviceCreateInfo deviceInfo = {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = &features12,
         .queueCreateInfoCount = queueCreateInfoCount,
         .pQueueCreateInfos = queueCreateInfos,
-        .enabledExtensionCount = SDL_arraysize(deviceExtensions),
+        .enabledExtensionCount = context->headless ? 0 : SDL_arraysize(deviceExtensions),
         .ppEnabledExtensionNames = deviceExtensions
     };
     if (vkCreateDevice(context->physicalDevice, &deviceInfo, NULL, &context->device) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create Vulkan device");
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+        vulkan_cleanup(context);
         return false;
     }
 
     vkGetDeviceQueue(context->device, context->graphicsFamily, 0, &context->graphicsQueue);
     vkGetDeviceQueue(context->device, context->presentFamily, 0, &context->presentQueue);
-
-    // Create swapchain
-    VkSurfaceCapabilitiesKHR capabilities;
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(context->physicalDevice, context->surface, &capabilities);
-    uint32_t formatCount;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(context->physicalDevice, context->surface, &formatCount, NULL);
-    VkSurfaceFormatKHR *formats = malloc(formatCount * sizeof(VkSurfaceFormatKHR));
-    vkGetPhysicalDeviceSurfaceFormatsKHR(context->physicalDevice, context->surface, &formatCount, formats);
-    VkSurfaceFormatKHR selectedFormat = formats[0]; // Pick first format
-    free(formats);
-    uint32_t presentModeCount;
-    vkGetPhysicalDeviceSurfacePresentModesKHR(context->physicalDevice, context->surface, &presentModeCount, NULL);
-    VkPresentModeKHR *presentModes = malloc(presentModeCount * sizeof(VkPresentModeKHR));
-    vkGetPhysicalDeviceSurfacePresentModesKHR(context->physicalDevice, context->surface, &presentModeCount, presentModes);
-    VkPresentModeKHR selectedPresentMode = presentModes[0]; // Pick first present mode
-    free(presentModes);
-    context->swapchainExtent = capabilities.currentExtent;
-    VkSwapchainCreateInfoKHR swapchainInfo = {
-        .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
-        .surface = context->surface,
-        .minImageCount = capabilities.minImageCount + 1,
-        .imageFormat = selectedFormat.format,
-        .imageColorSpace = selectedFormat.colorSpace,
-        .imageExtent = context->swapchainExtent,
-        .imageArrayLayers = 1,
-        .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-        .imageSharingMode = context->graphicsFamily == context->presentFamily ? VK_SHARING_MODE_EXCLUSIVE : VK_SHARING_MODE_CONCURRENT,
-        .queueFamilyIndexCount = queueCreateInfoCount,
-        .pQueueFamilyIndices = (uint32_t[]){context->graphicsFamily, context->presentFamily},
-        .preTransform = capabilities.currentTransform,
-        .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
-        .presentMode = selectedPresentMode,
-        .clipped = VK_TRUE,
-        .oldSwapchain = VK_NULL_HANDLE
-    };
-    if (vkCreateSwapchainKHR(context->device, &swapchainInfo, NULL, &context->swapchain) != VK_SUCCESS) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create swapchain");
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
-        return false;
-    }
-
-    // Get swapchain images
-    vkGetSwapchainImagesKHR(context->device, context->swapchain, &context->imageCount, NULL);
-    VkImage *images = malloc(context->imageCount * sizeof(VkImage));
-    vkGetSwapchainImagesKHR(context->device, context->swapchain, &context->imageCount, images);
-    context->imageViews = malloc(context->imageCount * sizeof(VkImageView));
-    for (uint32_t i = 0; i < context->imageCount; i++) {
-        VkImageViewCreateInfo viewInfo = {
-            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-            .image = images[i],
-            .viewType = VK_IMAGE_VIEW_TYPE_2D,
-            .format = selectedFormat.format,
-            .components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY },
-            .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-            .subresourceRange.baseMipLevel = 0,
-            .subresourceRange.levelCount = 1,
-            .subresourceRange.baseArrayLayer = 0,
-            .subresourceRange.layerCount = 1
-        };
-        if (vkCreateImageView(context->device, &viewInfo, NULL, &context->imageViews[i]) != VK_SUCCESS) {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create image view %u", i);
-            for (uint32_t j = 0; j < i; j++) vkDestroyImageView(context->device, context->imageViews[j], NULL);
-            free(context->imageViews);
-            free(images);
-            vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-            vkDestroyDevice(context->device, NULL);
-            vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-            vkDestroyInstance(context->instance, NULL);
-            return false;
-        }
+    vkGetDeviceQueue(context->device, context->transferFamily, 0, &context->transferQueue);
+    memory_allocator_init(&context->allocator, context->device, context->physicalDevice);
+
+    // Choose the surface format and present mode once; every swapchain recreation reuses them
+    if (context->headless) {
+        context->surfaceFormat = (VkSurfaceFormatKHR){ VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+        context->presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    } else {
+        uint32_t formatCount;
+        vkGetPhysicalDeviceSurfaceFormatsKHR(context->physicalDevice, context->surface, &formatCount, NULL);
+        VkSurfaceFormatKHR *formats = malloc(formatCount * sizeof(VkSurfaceFormatKHR));
+        vkGetPhysicalDeviceSurfaceFormatsKHR(context->physicalDevice, context->surface, &formatCount, formats);
+        context->surfaceFormat = formats[0]; // Pick first format
+        free(formats);
+        uint32_t presentModeCount;
+        vkGetPhysicalDeviceSurfacePresentModesKHR(context->physicalDevice, context->surface, &presentModeCount, NULL);
+        VkPresentModeKHR *presentModes = malloc(presentModeCount * sizeof(VkPresentModeKHR));
+        vkGetPhysicalDeviceSurfacePresentModesKHR(context->physicalDevice, context->surface, &presentModeCount, presentModes);
+        context->presentMode = choose_present_mode(presentModes, presentModeCount, context->present.presentMode);
+        free(presentModes);
+        SDL_Log("Present mode %s (requested %s), %u frames in flight",
+                vulkan_present_mode_name(context->presentMode),
+                vulkan_present_mode_name(context->present.presentMode), context->present.framesInFlight);
     }
-    free(images);
 
     // Create render pass
     VkAttachmentDescription colorAttachment = {
-        .format = selectedFormat.format,
+        .format = context->surfaceFormat.format,
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
         .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
         .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
         .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+        .finalLayout = context->headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
     };
     VkAttachmentReference colorAttachmentRef = { .attachment = 0, .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
     VkSubpassDescription subpass = {
@@ -243,13 +622,24 @@ bool vulkan_init(SDL_Window *window, VulkanContext *context) {
         .colorAttachmentCount = 1,
         .pColorAttachments = &colorAttachmentRef
     };
-    VkSubpassDependency dependency = {
-        .srcSubpass = VK_SUBPASS_EXTERNAL,
-        .dstSubpass = 0,
-        .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        .srcAccessMask = 0,
-        .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+    VkSubpassDependency dependencies[] = {
+        {
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = 0,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+        },
+        {
+            // Headless only: make the rendered image visible to the readback copy
+            .srcSubpass = 0,
+            .dstSubpass = VK_SUBPASS_EXTERNAL,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT
+        }
     };
     VkRenderPassCreateInfo renderPassInfo = {
         .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
@@ -257,47 +647,61 @@ bool vulkan_init(SDL_Window *window, VulkanContext *context) {
         .pAttachments = &colorAttachment,
         .subpassCount = 1,
         .pSubpasses = &subpass,
-        .dependencyCount = 1,
-        .pDependencies = &dependency
+        .dependencyCount = context->headless ? 2 : 1,
+        .pDependencies = dependencies
     };
     if (vkCreateRenderPass(context->device, &renderPassInfo, NULL, &context->renderPass) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create render pass");
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+        vulkan_cleanup(context);
+        return false;
+    }
+
+    // Create swapchain, image views, framebuffers and per-image semaphores, or the offscreen targets
+    context->framesInFlight = context->present.framesInFlight;
+    context->currentFrame = 0;
+    if (context->headless ? !create_offscreen_targets(context) : !create_swapchain(context)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create render targets");
+        vulkan_cleanup(context);
         return false;
     }
 
     // Create descriptor set layout
-    VkDescriptorSetLayoutBinding uboLayoutBinding = {
-        .binding = 0,
-        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-        .descriptorCount = 1,
-        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
-        .pImmutableSamplers = NULL
+    VkDescriptorSetLayoutBinding layoutBindings[] = {
+        {
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            .pImmutableSamplers = NULL
+        },
+        {
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            .pImmutableSamplers = NULL
+        }
     };
     VkDescriptorSetLayoutCreateInfo layoutInfo = {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-        .bindingCount = 1,
-        .pBindings = &uboLayoutBinding
+        .bindingCount = SDL_arraysize(layoutBindings),
+        .pBindings = layoutBindings
     };
     if (vkCreateDescriptorSetLayout(context->device, &layoutInfo, NULL, &context->descriptorSetLayout) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create descriptor set layout");
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+        vulkan_cleanup(context);
         return false;
     }
 
+    // Load the pipeline cache stored next to the executable; a missing or stale file starts cold
+    const char *basePath = SDL_GetBasePath();
+    SDL_snprintf(context->pipelineCachePath, sizeof(context->pipelineCachePath), "%s%s",
+                 basePath ? basePath : "", PIPELINE_CACHE_FILE);
+    context->pipelineCache = loadPipelineCache(context->device, context->physicalDevice,
+                                               context->pipelineCachePath, &context->pipelineCacheWarm);
+
     // Create graphics pipeline
-    VkShaderModule vertShaderModule, fragShaderModule;
+    VkShaderModule vertShaderModule = VK_NULL_HANDLE, fragShaderModule = VK_NULL_HANDLE;
     VkShaderModuleCreateInfo vertShaderInfo = {
         .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
         .codeSize = sizeof(shader2d_vert_spv),
@@ -311,14 +715,8 @@ bool vulkan_init(SDL_Window *window, VulkanContext *context) {
     if (vkCreateShaderModule(context->device, &vertShaderInfo, NULL, &vertShaderModule) != VK_SUCCESS ||
         vkCreateShaderModule(context->device, &fragShaderInfo, NULL, &fragShaderModule) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create shader modules");
-        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+        vkDestroyShaderModule(context->device, vertShaderModule, NULL);
+        vulkan_cleanup(context);
         return false;
     }
 
@@ -357,14 +755,11 @@ bool vulkan_init(SDL_Window *window, VulkanContext *context) {
         .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
         .primitiveRestartEnable = VK_FALSE
     };
-    VkViewport viewport = { 0.0f, 0.0f, (float)context->swapchainExtent.width, (float)context->swapchainExtent.height, 0.0f, 1.0f };
-    VkRect2D scissor = { {0, 0}, context->swapchainExtent };
+    // Viewport and scissor are dynamic so the pipeline survives swapchain resizes
     VkPipelineViewportStateCreateInfo viewportState = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
         .viewportCount = 1,
-        .pViewports = &viewport,
-        .scissorCount = 1,
-        .pScissors = &scissor
+        .scissorCount = 1
     };
     VkPipelineRasterizationStateCreateInfo rasterizer = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
@@ -391,6 +786,12 @@ bool vulkan_init(SDL_Window *window, VulkanContext *context) {
         .attachmentCount = 1,
         .pAttachments = &colorBlendAttachment
     };
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = SDL_arraysize(dynamicStates),
+        .pDynamicStates = dynamicStates
+    };
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
         .setLayoutCount = 1,
@@ -400,14 +801,7 @@ bool vulkan_init(SDL_Window *window, VulkanContext *context) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create pipeline layout");
         vkDestroyShaderModule(context->device, fragShaderModule, NULL);
         vkDestroyShaderModule(context->device, vertShaderModule, NULL);
-        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+        vulkan_cleanup(context);
         return false;
     }
     VkGraphicsPipelineCreateInfo pipelineInfo = {
@@ -420,59 +814,25 @@ bool vulkan_init(SDL_Window *window, VulkanContext *context) {
         .pRasterizationState = &rasterizer,
         .pMultisampleState = &multisampling,
         .pColorBlendState = &colorBlending,
-        .pDynamicState = NULL,
+        .pDynamicState = &dynamicState,
         .layout = context->pipelineLayout,
         .renderPass = context->renderPass,
         .subpass = 0
     };
-    if (vkCreateGraphicsPipelines(context->device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, &context->graphicsPipeline) != VK_SUCCESS) {
+    Uint64 pipelineStart = SDL_GetPerformanceCounter();
+    if (vkCreateGraphicsPipelines(context->device, context->pipelineCache, 1, &pipelineInfo, NULL, &context->graphicsPipeline) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create graphics pipeline");
-        vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
         vkDestroyShaderModule(context->device, fragShaderModule, NULL);
         vkDestroyShaderModule(context->device, vertShaderModule, NULL);
-        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+        vulkan_cleanup(context);
         return false;
     }
+    SDL_Log("shader2d pipeline created in %.3f ms (%s pipeline cache)",
+            (SDL_GetPerformanceCounter() - pipelineStart) * 1000.0 / SDL_GetPerformanceFrequency(),
+            context->pipelineCacheWarm ? "warm" : "cold");
     vkDestroyShaderModule(context->device, fragShaderModule, NULL);
     vkDestroyShaderModule(context->device, vertShaderModule, NULL);
 
-    // Create framebuffers
-    context->framebuffers = malloc(context->imageCount * sizeof(VkFramebuffer));
-    for (uint32_t i = 0; i < context->imageCount; i++) {
-        VkFramebufferCreateInfo framebufferInfo = {
-            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-            .renderPass = context->renderPass,
-            .attachmentCount = 1,
-            .pAttachments = &context->imageViews[i],
-            .width = context->swapchainExtent.width,
-            .height = context->swapchainExtent.height,
-            .layers = 1
-        };
-        if (vkCreateFramebuffer(context->device, &framebufferInfo, NULL, &context->framebuffers[i]) != VK_SUCCESS) {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create framebuffer %u", i);
-            for (uint32_t j = 0; j < i; j++) vkDestroyFramebuffer(context->device, context->framebuffers[j], NULL);
-            free(context->framebuffers);
-            vkDestroyPipeline(context->device, context->graphicsPipeline, NULL);
-            vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
-            vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-            vkDestroyRenderPass(context->device, context->renderPass, NULL);
-            for (uint32_t j = 0; j < context->imageCount; j++) vkDestroyImageView(context->device, context->imageViews[j], NULL);
-            free(context->imageViews);
-            vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-            vkDestroyDevice(context->device, NULL);
-            vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-            vkDestroyInstance(context->instance, NULL);
-            return false;
-        }
-    }
-
     // Create command pool
     VkCommandPoolCreateInfo poolInfo = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
@@ -481,86 +841,57 @@ bool vulkan_init(SDL_Window *window, VulkanContext *context) {
     };
     if (vkCreateCommandPool(context->device, &poolInfo, NULL, &context->commandPool) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create command pool");
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyFramebuffer(context->device, context->framebuffers[i], NULL);
-        free(context->framebuffers);
-        vkDestroyPipeline(context->device, context->graphicsPipeline, NULL);
-        vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
-        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+        vulkan_cleanup(context);
         return false;
     }
 
-    // Allocate command buffers
-    context->commandBuffers = malloc(context->imageCount * sizeof(VkCommandBuffer));
+    // Allocate one command buffer per frame in flight; these do not depend on the swapchain
+    context->commandBuffers = calloc(context->framesInFlight, sizeof(VkCommandBuffer));
     VkCommandBufferAllocateInfo allocInfo = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
         .commandPool = context->commandPool,
         .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = context->imageCount
+        .commandBufferCount = context->framesInFlight
     };
-    if (vkAllocateCommandBuffers(context->device, &allocInfo, context->commandBuffers) != VK_SUCCESS) {
+    if (!context->commandBuffers || vkAllocateCommandBuffers(context->device, &allocInfo, context->commandBuffers) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate command buffers");
-        vkDestroyCommandPool(context->device, context->commandPool, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyFramebuffer(context->device, context->framebuffers[i], NULL);
-        free(context->framebuffers);
-        vkDestroyPipeline(context->device, context->graphicsPipeline, NULL);
-        vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
-        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+        vulkan_cleanup(context);
         return false;
     }
 
-    // Create semaphores and fences
-    context->imageAvailableSemaphores = malloc(context->imageCount * sizeof(VkSemaphore));
-    context->renderFinishedSemaphores = malloc(context->imageCount * sizeof(VkSemaphore));
-    context->inFlightFences = malloc(context->imageCount * sizeof(VkFence));
-    context->fencesInUse = malloc(context->imageCount * sizeof(VkFence));
+    // Create per-frame semaphores and fences
+    context->imageAvailableSemaphores = calloc(context->framesInFlight, sizeof(VkSemaphore));
+    context->inFlightFences = calloc(context->framesInFlight, sizeof(VkFence));
+    context->frameSerials = calloc(context->framesInFlight, sizeof(uint64_t));
+    if (!context->imageAvailableSemaphores || !context->inFlightFences || !context->frameSerials) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate synchronization arrays");
+        vulkan_cleanup(context);
+        return false;
+    }
     VkSemaphoreCreateInfo semaphoreInfo = { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
     VkFenceCreateInfo fenceInfo = { .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, .flags = VK_FENCE_CREATE_SIGNALED_BIT };
-    for (uint32_t i = 0; i < context->imageCount; i++) {
+    for (uint32_t i = 0; i < context->framesInFlight; i++) {
         if (vkCreateSemaphore(context->device, &semaphoreInfo, NULL, &context->imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(context->device, &semaphoreInfo, NULL, &context->renderFinishedSemaphores[i]) != VK_SUCCESS ||
             vkCreateFence(context->device, &fenceInfo, NULL, &context->inFlightFences[i]) != VK_SUCCESS) {
             SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create synchronization objects for frame %u", i);
-            for (uint32_t j = 0; j < i; j++) {
-                vkDestroySemaphore(context->device, context->imageAvailableSemaphores[j], NULL);
-                vkDestroySemaphore(context->device, context->renderFinishedSemaphores[j], NULL);
-                vkDestroyFence(context->device, context->inFlightFences[j], NULL);
-            }
-            free(context->imageAvailableSemaphores);
-            free(context->renderFinishedSemaphores);
-            free(context->inFlightFences);
-            free(context->fencesInUse);
-            vkFreeCommandBuffers(context->device, context->commandPool, context->imageCount, context->commandBuffers);
-            free(context->commandBuffers);
-            vkDestroyCommandPool(context->device, context->commandPool, NULL);
-            for (uint32_t j = 0; j < context->imageCount; j++) vkDestroyFramebuffer(context->device, context->framebuffers[j], NULL);
-            free(context->framebuffers);
-            vkDestroyPipeline(context->device, context->graphicsPipeline, NULL);
-            vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
-            vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-            vkDestroyRenderPass(context->device, context->renderPass, NULL);
-            for (uint32_t j = 0; j < context->imageCount; j++) vkDestroyImageView(context->device, context->imageViews[j], NULL);
-            free(context->imageViews);
-            vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-            vkDestroyDevice(context->device, NULL);
-            vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-            vkDestroyInstance(context->instance, NULL);
+            vulkan_cleanup(context);
             return false;
         }
-        context->fencesInUse[i] = VK_NULL_HANDLE;
+    }
+
+    // Create profiler; one timestamp query pool per frame in flight
+    if (!profiler_init(&context->profiler, context->device, context->physicalDevice,
+                       context->graphicsFamily, context->framesInFlight)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create profiler");
+        vulkan_cleanup(context);
+        return false;
+    }
+
+    // Create record threads and their per-frame command pools
+    if (!vulkan_set_record_threads(context, context->present.recordThreads)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create record threads");
+        vulkan_cleanup(context);
+        return false;
     }
 
     // Initialize camera
@@ -568,442 +899,610 @@ bool vulkan_init(SDL_Window *window, VulkanContext *context) {
     context->camera.position[1] = 0.0f;
     context->camera.scale = 1.0f;
 
-    // Initialize object positions
-    glm_vec2_zero(context->objects[0].position); // Triangle
-    glm_vec2_zero(context->objects[1].position); // Square
-    glm_mat4_identity(context->objects[0].modelMatrix);
-    glm_mat4_identity(context->objects[1].modelMatrix);
-
-    // Create triangle vertex buffer
-    VkDeviceSize bufferSize = sizeof(triangleVertices);
-    context->triangleVertexBuffer = VK_NULL_HANDLE;
-    context->triangleVertexBufferMemory = VK_NULL_HANDLE;
-    if (!createBuffer(context->device, context->physicalDevice, bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                    &context->triangleVertexBuffer, &context->triangleVertexBufferMemory)) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create triangle vertex buffer");
-        // Clean up any partially created resources
-        if (context->triangleVertexBuffer != VK_NULL_HANDLE) {
-            vkDestroyBuffer(context->device, context->triangleVertexBuffer, NULL);
-        }
-        if (context->triangleVertexBufferMemory != VK_NULL_HANDLE) {
-            vkFreeMemory(context->device, context->triangleVertexBufferMemory, NULL);
-        }
-        // Clean up other resources
-        for (uint32_t i = 0; i < context->imageCount; i++) {
-            vkDestroySemaphore(context->device, context->imageAvailableSemaphores[i], NULL);
-            vkDestroySemaphore(context->device, context->renderFinishedSemaphores[i], NULL);
-            vkDestroyFence(context->device, context->inFlightFences[i], NULL);
-        }
-        free(context->imageAvailableSemaphores);
-        free(context->renderFinishedSemaphores);
-        free(context->inFlightFences);
-        free(context->fencesInUse);
-        vkFreeCommandBuffers(context->device, context->commandPool, context->imageCount, context->commandBuffers);
-        free(context->commandBuffers);
-        vkDestroyCommandPool(context->device, context->commandPool, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyFramebuffer(context->device, context->framebuffers[i], NULL);
-        free(context->framebuffers);
-        vkDestroyPipeline(context->device, context->graphicsPipeline, NULL);
-        vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
-        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+    // Initialize node store with the default triangle and square
+    node_store_init(&context->nodes);
+    node_add(&context->nodes, NODE_MESH_TRIANGLE, 200.0f, 200.0f, 100.0f, (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+    node_add(&context->nodes, NODE_MESH_SQUARE, 350.0f, 200.0f, 100.0f, (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+
+    // Create upload manager; static geometry and textures are staged through it
+    if (!upload_init(&context->upload, context->device, &context->allocator,
+                     context->transferFamily, context->transferQueue, context->graphicsFamily)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create upload manager");
+        vulkan_cleanup(context);
         return false;
     }
-    void *data;
-    vkMapMemory(context->device, context->triangleVertexBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, triangleVertices, bufferSize);
-    vkUnmapMemory(context->device, context->triangleVertexBufferMemory);
-
-    // Create square vertex buffer
-    static const Vertex squareVertices[] = {
-        {-0.25f, -0.25f, 0.0f, 1.0f, 1.0f},
-        {0.25f, -0.25f, 0.0f, 1.0f, 1.0f},
-        {-0.25f, 0.25f, 0.0f, 1.0f, 1.0f},
-        {0.25f, 0.25f, 0.0f, 1.0f, 1.0f}
-    };
-    // Create square vertex buffer
-    bufferSize = sizeof(squareVertices);
-    context->squareVertexBuffer = VK_NULL_HANDLE;
-    context->squareVertexBufferMemory = VK_NULL_HANDLE;
-    if (!createBuffer(context->device, context->physicalDevice, bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                    &context->squareVertexBuffer, &context->squareVertexBufferMemory)) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create square vertex buffer");
-        // Clean up square buffer resources
-        if (context->squareVertexBuffer != VK_NULL_HANDLE) {
-            vkDestroyBuffer(context->device, context->squareVertexBuffer, NULL);
-        }
-        if (context->squareVertexBufferMemory != VK_NULL_HANDLE) {
-            vkFreeMemory(context->device, context->squareVertexBufferMemory, NULL);
-        }
-        // Clean up triangle buffer resources
-        if (context->triangleVertexBuffer != VK_NULL_HANDLE) {
-            vkDestroyBuffer(context->device, context->triangleVertexBuffer, NULL);
-        }
-        if (context->triangleVertexBufferMemory != VK_NULL_HANDLE) {
-            vkFreeMemory(context->device, context->triangleVertexBufferMemory, NULL);
-        }
-        // Clean up other resources
-        for (uint32_t i = 0; i < context->imageCount; i++) {
-            vkDestroySemaphore(context->device, context->imageAvailableSemaphores[i], NULL);
-            vkDestroySemaphore(context->device, context->renderFinishedSemaphores[i], NULL);
-            vkDestroyFence(context->device, context->inFlightFences[i], NULL);
-        }
-        free(context->imageAvailableSemaphores);
-        free(context->renderFinishedSemaphores);
-        free(context->inFlightFences);
-        free(context->fencesInUse);
-        vkFreeCommandBuffers(context->device, context->commandPool, context->imageCount, context->commandBuffers);
-        free(context->commandBuffers);
-        vkDestroyCommandPool(context->device, context->commandPool, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyFramebuffer(context->device, context->framebuffers[i], NULL);
-        free(context->framebuffers);
-        vkDestroyPipeline(context->device, context->graphicsPipeline, NULL);
-        vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
-        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+
+    // Create shared mesh vertex and index buffers in device-local memory
+    if (!create_static_buffer(context, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, meshVertices, sizeof(meshVertices),
+                              &context->meshVertexBuffer, &context->meshVertexAllocation) ||
+        !create_static_buffer(context, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, meshIndices, sizeof(meshIndices),
+                              &context->meshIndexBuffer, &context->meshIndexAllocation)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create mesh buffers");
+        vulkan_cleanup(context);
         return false;
     }
-    vkMapMemory(context->device, context->squareVertexBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, squareVertices, bufferSize);
-    vkUnmapMemory(context->device, context->squareVertexBufferMemory);
 
-    // Create square index buffer
-    static const uint32_t squareIndices[] = {0, 1, 2, 2, 1, 3};
-    bufferSize = sizeof(squareIndices);
-    if (!createBuffer(context->device, context->physicalDevice, bufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+    // Create uniform ring: one region per frame in flight, each split into aligned slots
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(context->physicalDevice, &deviceProperties);
+    VkDeviceSize uniformAlignment = deviceProperties.limits.minUniformBufferOffsetAlignment;
+    if (uniformAlignment == 0) uniformAlignment = 1;
+    context->uniformSlotSize = (sizeof(mat4) + uniformAlignment - 1) & ~(uniformAlignment - 1);
+    VkDeviceSize bufferSize = context->uniformSlotSize * UNIFORM_RING_SLOTS_PER_FRAME * context->framesInFlight;
+    if (!createBuffer(&context->allocator, bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                     &context->squareIndexBuffer, &context->squareIndexBufferMemory)) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create square index buffer");
-        vkDestroyBuffer(context->device, context->squareVertexBuffer, NULL);
-        vkFreeMemory(context->device, context->squareVertexBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->triangleVertexBuffer, NULL);
-        vkFreeMemory(context->device, context->triangleVertexBufferMemory, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) {
-            vkDestroySemaphore(context->device, context->imageAvailableSemaphores[i], NULL);
-            vkDestroySemaphore(context->device, context->renderFinishedSemaphores[i], NULL);
-            vkDestroyFence(context->device, context->inFlightFences[i], NULL);
-        }
-        free(context->imageAvailableSemaphores);
-        free(context->renderFinishedSemaphores);
-        free(context->inFlightFences);
-        free(context->fencesInUse);
-        vkFreeCommandBuffers(context->device, context->commandPool, context->imageCount, context->commandBuffers);
-        free(context->commandBuffers);
-        vkDestroyCommandPool(context->device, context->commandPool, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyFramebuffer(context->device, context->framebuffers[i], NULL);
-        free(context->framebuffers);
-        vkDestroyPipeline(context->device, context->graphicsPipeline, NULL);
-        vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
-        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+                     &context->uniformBuffer, &context->uniformAllocation)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create uniform ring buffer");
+        vulkan_cleanup(context);
         return false;
     }
-    vkMapMemory(context->device, context->squareIndexBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, squareIndices, bufferSize);
-    vkUnmapMemory(context->device, context->squareIndexBufferMemory);
-
-    // Create uniform buffer
-    bufferSize = sizeof(mat4);
-    if (!createBuffer(context->device, context->physicalDevice, bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                     &context->uniformBuffer, &context->uniformBufferMemory)) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create uniform buffer");
-        vkDestroyBuffer(context->device, context->squareIndexBuffer, NULL);
-        vkFreeMemory(context->device, context->squareIndexBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->squareVertexBuffer, NULL);
-        vkFreeMemory(context->device, context->squareVertexBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->triangleVertexBuffer, NULL);
-        vkFreeMemory(context->device, context->triangleVertexBufferMemory, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) {
-            vkDestroySemaphore(context->device, context->imageAvailableSemaphores[i], NULL);
-            vkDestroySemaphore(context->device, context->renderFinishedSemaphores[i], NULL);
-            vkDestroyFence(context->device, context->inFlightFences[i], NULL);
-        }
-        free(context->imageAvailableSemaphores);
-        free(context->renderFinishedSemaphores);
-        free(context->inFlightFences);
-        free(context->fencesInUse);
-        vkFreeCommandBuffers(context->device, context->commandPool, context->imageCount, context->commandBuffers);
-        free(context->commandBuffers);
-        vkDestroyCommandPool(context->device, context->commandPool, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyFramebuffer(context->device, context->framebuffers[i], NULL);
-        free(context->framebuffers);
-        vkDestroyPipeline(context->device, context->graphicsPipeline, NULL);
-        vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
-        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+    context->uniformBufferMapped = context->uniformAllocation.mapped;
+
+    // Create node instance storage ring
+    context->storageAlignment = deviceProperties.limits.minStorageBufferOffsetAlignment;
+    if (context->storageAlignment == 0) context->storageAlignment = 1;
+    if (!create_node_buffer(context, NODE_INITIAL_CAPACITY)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create node instance buffer");
+        vulkan_cleanup(context);
         return false;
     }
 
     // Create descriptor pool
-    VkDescriptorPoolSize poolSize = {
-        .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-        .descriptorCount = context->imageCount
+    VkDescriptorPoolSize poolSizes[] = {
+        { .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, .descriptorCount = 1 },
+        { .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, .descriptorCount = 1 }
     };
     VkDescriptorPoolCreateInfo descriptorPoolInfo = {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-        .maxSets = context->imageCount,
-        .poolSizeCount = 1,
-        .pPoolSizes = &poolSize
+        .maxSets = 1,
+        .poolSizeCount = SDL_arraysize(poolSizes),
+        .pPoolSizes = poolSizes
     };
     if (vkCreateDescriptorPool(context->device, &descriptorPoolInfo, NULL, &context->descriptorPool) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create descriptor pool");
-        vkDestroyBuffer(context->device, context->uniformBuffer, NULL);
-        vkFreeMemory(context->device, context->uniformBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->squareIndexBuffer, NULL);
-        vkFreeMemory(context->device, context->squareIndexBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->squareVertexBuffer, NULL);
-        vkFreeMemory(context->device, context->squareVertexBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->triangleVertexBuffer, NULL);
-        vkFreeMemory(context->device, context->triangleVertexBufferMemory, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) {
-            vkDestroySemaphore(context->device, context->imageAvailableSemaphores[i], NULL);
-            vkDestroySemaphore(context->device, context->renderFinishedSemaphores[i], NULL);
-            vkDestroyFence(context->device, context->inFlightFences[i], NULL);
-        }
-        free(context->imageAvailableSemaphores);
-        free(context->renderFinishedSemaphores);
-        free(context->inFlightFences);
-        free(context->fencesInUse);
-        vkFreeCommandBuffers(context->device, context->commandPool, context->imageCount, context->commandBuffers);
-        free(context->commandBuffers);
-        vkDestroyCommandPool(context->device, context->commandPool, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyFramebuffer(context->device, context->framebuffers[i], NULL);
-        free(context->framebuffers);
-        vkDestroyPipeline(context->device, context->graphicsPipeline, NULL);
-        vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
-        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+        vulkan_cleanup(context);
         return false;
     }
 
-    // Allocate descriptor sets
-    context->descriptorSets = malloc(context->imageCount * sizeof(VkDescriptorSet));
-    VkDescriptorSetLayout layouts[context->imageCount];
-    for (uint32_t i = 0; i < context->imageCount; i++) {
-        layouts[i] = context->descriptorSetLayout;
-    }
+    // Allocate descriptor set; the per-draw slot is selected with a dynamic offset
     VkDescriptorSetAllocateInfo descriptorAllocInfo = {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
         .descriptorPool = context->descriptorPool,
-        .descriptorSetCount = context->imageCount,
-        .pSetLayouts = layouts
+        .descriptorSetCount = 1,
+        .pSetLayouts = &context->descriptorSetLayout
     };
-    if (vkAllocateDescriptorSets(context->device, &descriptorAllocInfo, context->descriptorSets) != VK_SUCCESS) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate descriptor sets");
-        vkDestroyDescriptorPool(context->device, context->descriptorPool, NULL);
-        vkDestroyBuffer(context->device, context->uniformBuffer, NULL);
-        vkFreeMemory(context->device, context->uniformBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->squareIndexBuffer, NULL);
-        vkFreeMemory(context->device, context->squareIndexBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->squareVertexBuffer, NULL);
-        vkFreeMemory(context->device, context->squareVertexBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->triangleVertexBuffer, NULL);
-        vkFreeMemory(context->device, context->triangleVertexBufferMemory, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) {
-            vkDestroySemaphore(context->device, context->imageAvailableSemaphores[i], NULL);
-            vkDestroySemaphore(context->device, context->renderFinishedSemaphores[i], NULL);
-            vkDestroyFence(context->device, context->inFlightFences[i], NULL);
-        }
-        free(context->imageAvailableSemaphores);
-        free(context->renderFinishedSemaphores);
-        free(context->inFlightFences);
-        free(context->fencesInUse);
-        vkFreeCommandBuffers(context->device, context->commandPool, context->imageCount, context->commandBuffers);
-        free(context->commandBuffers);
-        vkDestroyCommandPool(context->device, context->commandPool, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyFramebuffer(context->device, context->framebuffers[i], NULL);
-        free(context->framebuffers);
-        vkDestroyPipeline(context->device, context->graphicsPipeline, NULL);
-        vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
-        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+    if (vkAllocateDescriptorSets(context->device, &descriptorAllocInfo, &context->descriptorSet) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate descriptor set");
+        vulkan_cleanup(context);
         return false;
     }
 
-    // Update descriptor sets
-    for (uint32_t i = 0; i < context->imageCount; i++) {
-        VkDescriptorBufferInfo bufferInfo = {
-            .buffer = context->uniformBuffer,
-            .offset = 0,
-            .range = sizeof(mat4)
-        };
-        VkWriteDescriptorSet descriptorWrite = {
-            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-            .dstSet = context->descriptorSets[i],
-            .dstBinding = 0,
-            .dstArrayElement = 0,
-            .descriptorCount = 1,
-            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-            .pBufferInfo = &bufferInfo
-        };
-        vkUpdateDescriptorSets(context->device, 1, &descriptorWrite, 0, NULL);
-    }
+    // Update descriptor set
+    VkDescriptorBufferInfo uniformBufferInfo = {
+        .buffer = context->uniformBuffer,
+        .offset = 0,
+        .range = sizeof(mat4)
+    };
+    VkWriteDescriptorSet descriptorWrite = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = context->descriptorSet,
+        .dstBinding = 0,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .pBufferInfo = &uniformBufferInfo
+    };
+    vkUpdateDescriptorSets(context->device, 1, &descriptorWrite, 0, NULL);
+    write_node_descriptor(context);
 
     // Initialize text module
-    context->textContext = malloc(sizeof(TextContext));
+    context->textContext = calloc(1, sizeof(TextContext));
     if (!context->textContext) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate TextContext");
-        vkDestroyDescriptorPool(context->device, context->descriptorPool, NULL);
-        vkDestroyBuffer(context->device, context->uniformBuffer, NULL);
-        vkFreeMemory(context->device, context->uniformBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->squareIndexBuffer, NULL);
-        vkFreeMemory(context->device, context->squareIndexBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->squareVertexBuffer, NULL);
-        vkFreeMemory(context->device, context->squareVertexBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->triangleVertexBuffer, NULL);
-        vkFreeMemory(context->device, context->triangleVertexBufferMemory, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) {
-            vkDestroySemaphore(context->device, context->imageAvailableSemaphores[i], NULL);
-            vkDestroySemaphore(context->device, context->renderFinishedSemaphores[i], NULL);
-            vkDestroyFence(context->device, context->inFlightFences[i], NULL);
-        }
-        free(context->imageAvailableSemaphores);
-        free(context->renderFinishedSemaphores);
-        free(context->inFlightFences);
-        free(context->fencesInUse);
-        vkFreeCommandBuffers(context->device, context->commandPool, context->imageCount, context->commandBuffers);
-        free(context->commandBuffers);
-        vkDestroyCommandPool(context->device, context->commandPool, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyFramebuffer(context->device, context->framebuffers[i], NULL);
-        free(context->framebuffers);
-        vkDestroyPipeline(context->device, context->graphicsPipeline, NULL);
-        vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
-        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+        vulkan_cleanup(context);
         return false;
     }
-    memset(context->textContext, 0, sizeof(TextContext));
     if (!text_init(context, context->textContext)) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize text module");
         free(context->textContext);
-        vkDestroyDescriptorPool(context->device, context->descriptorPool, NULL);
-        vkDestroyBuffer(context->device, context->uniformBuffer, NULL);
-        vkFreeMemory(context->device, context->uniformBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->squareIndexBuffer, NULL);
-        vkFreeMemory(context->device, context->squareIndexBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->squareVertexBuffer, NULL);
-        vkFreeMemory(context->device, context->squareVertexBufferMemory, NULL);
-        vkDestroyBuffer(context->device, context->triangleVertexBuffer, NULL);
-        vkFreeMemory(context->device, context->triangleVertexBufferMemory, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) {
-            vkDestroySemaphore(context->device, context->imageAvailableSemaphores[i], NULL);
-            vkDestroySemaphore(context->device, context->renderFinishedSemaphores[i], NULL);
-            vkDestroyFence(context->device, context->inFlightFences[i], NULL);
+        context->textContext = NULL;
+        vulkan_cleanup(context);
+        return false;
+    }
+
+    // Initialize wire module
+    context->wireContext = calloc(1, sizeof(WireContext));
+    if (!context->wireContext) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate WireContext");
+        vulkan_cleanup(context);
+        return false;
+    }
+    if (!wire_init(context, context->wireContext)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize wire module");
+        free(context->wireContext);
+        context->wireContext = NULL;
+        vulkan_cleanup(context);
+        return false;
+    }
+
+    context->dirty = true;
+    SDL_Log("Vulkan initialized successfully%s", context->headless ? " (headless)" : "");
+    memory_log_stats(&context->allocator);
+    return true;
+}
+
+static void set_present_config(VulkanContext *context, const PresentConfig *config) {
+    if (config) {
+        context->present = *config;
+    } else {
+        vulkan_present_config_init(&context->present);
+    }
+    context->present.framesInFlight = SDL_clamp(context->present.framesInFlight, 1, MAX_FRAMES_IN_FLIGHT);
+    context->present.recordThreads = SDL_clamp(context->present.recordThreads, 1, JOB_MAX_THREADS);
+}
+
+bool vulkan_init(SDL_Window *window, const PresentConfig *config, VulkanContext *context) {
+    // The context must be zero-initialized; every failure unwinds through vulkan_cleanup
+    context->window = window;
+    set_present_config(context, config);
+    return init_context(context);
+}
+
+bool vulkan_init_headless(const PresentConfig *config, VulkanContext *context, uint32_t width, uint32_t height) {
+    // The context must be zero-initialized; no SDL video subsystem is required
+    context->headless = true;
+    context->swapchainExtent = (VkExtent2D){ width, height };
+    set_present_config(context, config);
+    return init_context(context);
+}
+
+void vulkan_pace_frame(VulkanContext *context) {
+    if (context->present.paceFps == 0) return;
+    Uint64 interval = SDL_NS_PER_SECOND / context->present.paceFps;
+    Uint64 now = SDL_GetTicksNS();
+    if (context->nextFrameNs > now) {
+        SDL_DelayPrecise(context->nextFrameNs - now);
+        now = context->nextFrameNs;
+    }
+    // After a long frame, restart the schedule instead of rushing to catch up
+    context->nextFrameNs = context->nextFrameNs + interval > now ? context->nextFrameNs + interval : now + interval;
+}
+
+// Camera changes, edits and animations call this; the main loop sleeps while nothing is dirty
+void vulkan_request_redraw(VulkanContext *context) {
+    context->dirty = true;
+}
+
+static void record_frame_interval(VulkanContext *context) {
+    Uint64 now = SDL_GetTicksNS();
+    RenderStats *stats = &context->stats;
+    if (stats->lastPresentNs != 0) {
+        stats->frameIntervalsNs[stats->frameIndex % FRAME_INTERVAL_SAMPLES] = now - stats->lastPresentNs;
+        if (stats->frameIntervalCount < FRAME_INTERVAL_SAMPLES) stats->frameIntervalCount++;
+    }
+    stats->lastPresentNs = now;
+}
+
+
+
+
+bool vulkan_push_uniform(VulkanContext *context, const void *data, VkDeviceSize size, uint32_t *dynamicOffset) {
+    if (size > context->uniformSlotSize || context->uniformSlotCursor >= UNIFORM_RING_SLOTS_PER_FRAME) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Uniform ring exhausted for this frame");
+        return false;
+    }
+    VkDeviceSize offset = (context->currentFrame * UNIFORM_RING_SLOTS_PER_FRAME + context->uniformSlotCursor) * context->uniformSlotSize;
+    memcpy((char *)context->uniformBufferMapped + offset, data, size);
+    context->uniformSlotCursor++;
+    context->stats.uniformBytesWritten += size;
+    context->stats.uniformSlotsUsed++;
+    *dynamicOffset = (uint32_t)offset;
+    return true;
+}
+
+
+// Secondary command buffers per frame: one per node chunk, plus one for text and one for wires
+static void destroy_record_pools(VulkanContext *context) {
+    job_system_destroy(&context->jobs);
+    for (uint32_t i = 0; context->recordPools && i < context->framesInFlight * context->recordThreads; i++) {
+        vkDestroyCommandPool(context->device, context->recordPools[i], NULL);
+    }
+    free(context->recordPools);
+    free(context->recordBuffers);
+    context->recordPools = NULL;
+    context->recordBuffers = NULL;
+    context->recordThreads = 1;
+}
+
+// Pools are reset whole each frame, so they are transient and never reset per buffer
+bool vulkan_set_record_threads(VulkanContext *context, uint32_t threads) {
+    threads = SDL_clamp(threads, 1, JOB_MAX_THREADS);
+    vkDeviceWaitIdle(context->device); // The old pools may still back frames in flight
+    destroy_record_pools(context);
+    if (threads == 1) {
+        SDL_Log("Recording frames on the main thread");
+        return true;
+    }
+
+    context->recordPools = calloc(context->framesInFlight * threads, sizeof(VkCommandPool));
+    context->recordBuffers = calloc(context->framesInFlight * (threads + 2), sizeof(VkCommandBuffer));
+    if (!context->recordPools || !context->recordBuffers) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate record command pools");
+        destroy_record_pools(context);
+        return false;
+    }
+    context->recordThreads = threads;
+    VkCommandPoolCreateInfo poolInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .queueFamilyIndex = context->graphicsFamily,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+    };
+    for (uint32_t frame = 0; frame < context->framesInFlight; frame++) {
+        VkCommandBuffer *buffers = &context->recordBuffers[frame * (threads + 2)];
+        for (uint32_t chunk = 0; chunk < threads; chunk++) {
+            VkCommandPool *pool = &context->recordPools[frame * threads + chunk];
+            if (vkCreateCommandPool(context->device, &poolInfo, NULL, pool) != VK_SUCCESS) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create record command pool");
+                destroy_record_pools(context);
+                return false;
+            }
+            // Chunk 0's pool also owns the text and wire buffers, recorded on the main thread after the chunks finish
+            VkCommandBufferAllocateInfo allocInfo = {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = *pool,
+                .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                .commandBufferCount = 1
+            };
+            VkCommandBufferAllocateInfo mainAllocInfo = allocInfo;
+            mainAllocInfo.commandBufferCount = 2;
+            if (vkAllocateCommandBuffers(context->device, &allocInfo, &buffers[chunk]) != VK_SUCCESS ||
+                (chunk == 0 && vkAllocateCommandBuffers(context->device, &mainAllocInfo, &buffers[threads]) != VK_SUCCESS)) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate secondary command buffers");
+                destroy_record_pools(context);
+                return false;
+            }
         }
-        free(context->imageAvailableSemaphores);
-        free(context->renderFinishedSemaphores);
-        free(context->inFlightFences);
-        free(context->fencesInUse);
-        vkFreeCommandBuffers(context->device, context->commandPool, context->imageCount, context->commandBuffers);
-        free(context->commandBuffers);
-        vkDestroyCommandPool(context->device, context->commandPool, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyFramebuffer(context->device, context->framebuffers[i], NULL);
-        free(context->framebuffers);
-        vkDestroyPipeline(context->device, context->graphicsPipeline, NULL);
-        vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
-        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-        vkDestroyRenderPass(context->device, context->renderPass, NULL);
-        for (uint32_t i = 0; i < context->imageCount; i++) vkDestroyImageView(context->device, context->imageViews[i], NULL);
-        free(context->imageViews);
-        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-        vkDestroyDevice(context->device, NULL);
-        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
-        vkDestroyInstance(context->instance, NULL);
+    }
+    if (!job_system_init(&context->jobs, threads)) {
+        destroy_record_pools(context);
         return false;
     }
+    SDL_Log("Recording node chunks on %u threads", threads);
+    return true;
+}
+
+// Viewport and scissor follow the current swapchain extent
+static void set_viewport(const VulkanContext *context, VkCommandBuffer commandBuffer) {
+    VkViewport viewport = { 0.0f, 0.0f, (float)context->swapchainExtent.width, (float)context->swapchainExtent.height, 0.0f, 1.0f };
+    VkRect2D scissor = { {0, 0}, context->swapchainExtent };
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+static void bind_node_pipeline(const VulkanContext *context, VkCommandBuffer commandBuffer, const uint32_t dynamicOffsets[2]) {
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, context->graphicsPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            context->pipelineLayout, 0, 1, &context->descriptorSet, 2, dynamicOffsets);
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &context->meshVertexBuffer, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, context->meshIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
+static int compare_indices(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static bool cull_visit(void *userData, uint32_t item, const SpatialRect *bounds) {
+    (void)bounds;
+    VulkanContext *context = userData;
+    uint32_t mesh = context->nodes.slotMesh[item];
+    context->cull.indices[mesh][context->cull.counts[mesh]++] = context->nodes.slotIndex[item];
+    return true;
+}
+
+// Collect the nodes overlapping the camera's world rectangle from the spatial index. Sorting
+// restores the batch order, so overlapping nodes keep drawing back to front.
+static bool cull_nodes(VulkanContext *context) {
+    NodeCullList *cull = &context->cull;
+    for (int m = 0; m < NODE_MESH_COUNT; m++) {
+        uint32_t count = context->nodes.batches[m].count;
+        if (count > cull->capacities[m]) {
+            uint32_t *indices = realloc(cull->indices[m], count * sizeof(uint32_t));
+            if (!indices) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow node cull list");
+                return false;
+            }
+            cull->indices[m] = indices;
+            cull->capacities[m] = count;
+        }
+        cull->counts[m] = 0;
+    }
+
+    SpatialRect view;
+    vulkan_visible_rect(context, &view);
+    node_query_rect(&context->nodes, &view, cull_visit, context);
+
+    uint32_t visible = 0;
+    for (int m = 0; m < NODE_MESH_COUNT; m++) {
+        // A fully visible mesh needs no order; packing copies its batch as one block
+        if (cull->counts[m] != context->nodes.batches[m].count) {
+            qsort(cull->indices[m], cull->counts[m], sizeof(uint32_t), compare_indices);
+        }
+        visible += cull->counts[m];
+    }
+    context->stats.nodesCulled = context->nodes.count - visible;
+    return true;
+}
+
+// Copy visible instances [from, from + count) of mesh m to dst
+static void pack_visible(const VulkanContext *context, int m, uint32_t from, uint32_t count, NodeInstance *dst) {
+    const NodeMeshBatch *batch = &context->nodes.batches[m];
+    if (context->cull.counts[m] == batch->count) {
+        memcpy(dst, batch->instances + from, count * sizeof(NodeInstance));
+        return;
+    }
+    const uint32_t *indices = context->cull.indices[m] + from;
+    for (uint32_t i = 0; i < count; i++) {
+        dst[i] = batch->instances[indices[i]];
+    }
+}
+
+// Lay out one contiguous range of visible instances per mesh; returns the total instance count
+static uint32_t node_instance_ranges(VulkanContext *context, uint32_t firstInstance[NODE_MESH_COUNT]) {
+    uint32_t instanceCount = 0;
+    for (int m = 0; m < NODE_MESH_COUNT; m++) {
+        firstInstance[m] = instanceCount;
+        instanceCount += context->cull.counts[m];
+    }
+    context->stats.instanceBytesWritten = instanceCount * sizeof(NodeInstance);
+    context->stats.instancesDrawn = instanceCount;
+    context->stats.drawCalls = 0;
+    return instanceCount;
+}
+
+static void record_inline(VulkanContext *context, VkCommandBuffer commandBuffer, uint32_t currentFrame, mat4 vp) {
+    Profiler *profiler = &context->profiler;
+    set_viewport(context, commandBuffer);
+
+    // Pack node instances into this frame's storage region
+    uint32_t nodeOffset = (uint32_t)(currentFrame * context->nodeRegionSize);
+    NodeInstance *instances = (NodeInstance *)((char *)context->nodeBufferMapped + nodeOffset);
+    uint32_t firstInstance[NODE_MESH_COUNT];
+    uint32_t instanceCount = node_instance_ranges(context, firstInstance);
+    for (int m = 0; m < NODE_MESH_COUNT; m++) {
+        pack_visible(context, m, 0, context->cull.counts[m], instances + firstInstance[m]);
+    }
+
+    // Wires go first so nodes cover their ends
+    if (context->wireContext) {
+        PROFILE_GPU_BEGIN(profiler, commandBuffer, "wires");
+        wire_render(context, context->wireContext, commandBuffer);
+        PROFILE_GPU_END(profiler, commandBuffer);
+    }
+
+    // Draw every mesh with one instanced call
+    PROFILE_GPU_BEGIN(profiler, commandBuffer, "nodes");
+    uint32_t dynamicOffsets[2];
+    if (instanceCount > 0 && vulkan_push_uniform(context, vp, sizeof(mat4), &dynamicOffsets[0])) {
+        dynamicOffsets[1] = nodeOffset;
+        bind_node_pipeline(context, commandBuffer, dynamicOffsets);
+        for (int m = 0; m < NODE_MESH_COUNT; m++) {
+            uint32_t count = context->cull.counts[m];
+            if (count == 0) continue;
+            vkCmdDrawIndexed(commandBuffer, meshRanges[m].indexCount, count,
+                             meshRanges[m].firstIndex, meshRanges[m].vertexOffset, firstInstance[m]);
+            context->stats.drawCalls++;
+        }
+    }
+    PROFILE_GPU_END(profiler, commandBuffer);
 
-    SDL_Log("Vulkan initialized successfully");
+    // Render text
+    if (context->textContext) {
+        PROFILE_GPU_BEGIN(profiler, commandBuffer, "text");
+        text_render(context, context->textContext, commandBuffer);
+        PROFILE_GPU_END(profiler, commandBuffer);
+    }
+}
+
+// Shared by the chunk jobs of one frame; each chunk writes only its own slots
+typedef struct {
+    VulkanContext *context;
+    NodeInstance *instances;              // This frame's region of the node ring
+    uint32_t firstInstance[NODE_MESH_COUNT];
+    uint32_t instanceCount;               // 0 when nothing is drawn; chunks still reset their pools
+    uint32_t dynamicOffsets[2];
+    uint32_t chunkCount;
+    VkCommandPool *commandPools;          // Per chunk, this frame's
+    VkCommandBuffer *commandBuffers;      // Per chunk, then the text and wire buffers
+    VkFramebuffer framebuffer;
+    uint32_t drawCalls[JOB_MAX_THREADS];
+    bool recorded[JOB_MAX_THREADS];       // The chunk has draws and ended successfully
+} NodeRecordJob;
+
+static bool begin_secondary(const VulkanContext *context, VkCommandBuffer commandBuffer, VkFramebuffer framebuffer) {
+    VkCommandBufferInheritanceInfo inheritanceInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = context->renderPass,
+        .subpass = 0,
+        .framebuffer = framebuffer
+    };
+    VkCommandBufferBeginInfo beginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritanceInfo
+    };
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) return false;
+    set_viewport(context, commandBuffer); // Dynamic state is not inherited from the primary
     return true;
 }
 
+// Pack and draw an even share of the flattened instance range; a chunk may span both meshes
+static void record_node_chunk(void *userData, uint32_t chunk) {
+    NodeRecordJob *job = userData;
+    VulkanContext *context = job->context;
+    uint32_t start = (uint32_t)((uint64_t)job->instanceCount * chunk / job->chunkCount);
+    uint32_t end = (uint32_t)((uint64_t)job->instanceCount * (chunk + 1) / job->chunkCount);
+    job->drawCalls[chunk] = 0;
+    job->recorded[chunk] = false;
+    vkResetCommandPool(context->device, job->commandPools[chunk], 0);
+    if (start == end) return;
+
+    VkCommandBuffer commandBuffer = job->commandBuffers[chunk];
+    if (!begin_secondary(context, commandBuffer, job->framebuffer)) return;
+    bind_node_pipeline(context, commandBuffer, job->dynamicOffsets);
+    for (int m = 0; m < NODE_MESH_COUNT; m++) {
+        uint32_t meshStart = SDL_max(start, job->firstInstance[m]);
+        uint32_t meshEnd = SDL_min(end, job->firstInstance[m] + context->cull.counts[m]);
+        if (meshStart >= meshEnd) continue;
+        pack_visible(context, m, meshStart - job->firstInstance[m], meshEnd - meshStart, job->instances + meshStart);
+        vkCmdDrawIndexed(commandBuffer, meshRanges[m].indexCount, meshEnd - meshStart,
+                         meshRanges[m].firstIndex, meshRanges[m].vertexOffset, meshStart);
+        job->drawCalls[chunk]++;
+    }
+    job->recorded[chunk] = vkEndCommandBuffer(commandBuffer) == VK_SUCCESS;
+}
 
+// Split the nodes into one chunk per record thread, each packed and recorded into its own
+// secondary command buffer, then execute them from the primary
+static void record_secondaries(VulkanContext *context, VkCommandBuffer commandBuffer, uint32_t currentFrame,
+                               VkFramebuffer framebuffer, mat4 vp) {
+    uint32_t threads = context->recordThreads;
+    uint32_t nodeOffset = (uint32_t)(currentFrame * context->nodeRegionSize);
+    NodeRecordJob job = {
+        .context = context,
+        .instances = (NodeInstance *)((char *)context->nodeBufferMapped + nodeOffset),
+        .dynamicOffsets = { 0, nodeOffset },
+        .chunkCount = threads,
+        .commandPools = &context->recordPools[currentFrame * threads],
+        .commandBuffers = &context->recordBuffers[currentFrame * (threads + 2)],
+        .framebuffer = framebuffer
+    };
+    job.instanceCount = node_instance_ranges(context, job.firstInstance);
+    if (job.instanceCount > 0 && !vulkan_push_uniform(context, vp, sizeof(mat4), &job.dynamicOffsets[0])) {
+        job.instanceCount = 0;
+    }
+    job_system_run(&context->jobs, record_node_chunk, &job, threads);
+
+    // Wires go first so nodes cover their ends; chunk 0 has already reset the pool it shares
+    VkCommandBuffer secondaries[JOB_MAX_THREADS + 2];
+    uint32_t secondaryCount = 0;
+    VkCommandBuffer wireBuffer = job.commandBuffers[threads + 1];
+    if (context->wireContext && context->wireContext->drawCount > 0 && begin_secondary(context, wireBuffer, framebuffer)) {
+        wire_render(context, context->wireContext, wireBuffer);
+        if (vkEndCommandBuffer(wireBuffer) == VK_SUCCESS) secondaries[secondaryCount++] = wireBuffer;
+    }
+    for (uint32_t chunk = 0; chunk < threads; chunk++) {
+        if (!job.recorded[chunk]) continue;
+        secondaries[secondaryCount++] = job.commandBuffers[chunk];
+        context->stats.drawCalls += job.drawCalls[chunk];
+    }
+
+    // Text goes last so it stays on top
+    VkCommandBuffer textBuffer = job.commandBuffers[threads];
+    if (context->textContext && begin_secondary(context, textBuffer, framebuffer)) {
+        text_render(context, context->textContext, textBuffer);
+        if (vkEndCommandBuffer(textBuffer) == VK_SUCCESS) secondaries[secondaryCount++] = textBuffer;
+    }
+    if (secondaryCount > 0) vkCmdExecuteCommands(commandBuffer, secondaryCount, secondaries);
+}
 
 
 bool vulkan_render(VulkanContext *context) {
-    static uint32_t currentFrame = 0;
+    uint32_t currentFrame = context->currentFrame;
+    VkCommandBuffer commandBuffer = context->commandBuffers[currentFrame];
 
-    // Wait for fence
-    if (vkWaitForFences(context->device, 1, &context->inFlightFences[currentFrame], VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to wait for fence");
+    // A previous recreation failed part-way; ask the caller to try again
+    if (!context->headless && context->swapchain == VK_NULL_HANDLE) {
+        upload_flush(&context->upload);
         return false;
     }
 
-    // Acquire image
-    uint32_t imageIndex;
-    VkResult result = vkAcquireNextImageKHR(context->device, context->swapchain, UINT64_MAX,
-                                            context->imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+    // Grow the node instance ring before any per-frame state is touched
+    if (!ensure_node_capacity(context, context->nodes.count)) {
         return false;
-    } else if (result != VK_SUCCESS) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to acquire swapchain image");
+    }
+
+    // Rebuild the instances of nodes changed since the last frame, then cull against the
+    // camera before recording so both record paths only see visible nodes
+    Profiler *profiler = &context->profiler;
+    PROFILE_CPU_BEGIN(profiler, "transforms");
+    context->stats.transformsRebuilt = node_store_update_transforms(&context->nodes);
+    PROFILE_CPU_END(profiler);
+    PROFILE_CPU_BEGIN(profiler, "cull");
+    bool culled = cull_nodes(context);
+    PROFILE_CPU_END(profiler);
+    if (!culled) {
         return false;
     }
 
-    if (context->fencesInUse[imageIndex] != VK_NULL_HANDLE) {
-        vkWaitForFences(context->device, 1, &context->fencesInUse[imageIndex], VK_TRUE, UINT64_MAX);
+    // Wait for fence
+    PROFILE_CPU_BEGIN(profiler, "wait frame");
+    VkResult result = vkWaitForFences(context->device, 1, &context->inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+    PROFILE_CPU_END(profiler);
+    if (result != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to wait for fence");
+        return false;
     }
-    context->fencesInUse[imageIndex] = context->inFlightFences[currentFrame];
 
-    // Reset fence and command buffer
-    vkResetFences(context->device, 1, &context->inFlightFences[currentFrame]);
-    vkResetCommandBuffer(context->commandBuffers[imageIndex], 0);
+    // Submissions retire in order, so everything up to this frame's last serial is done
+    if (context->frameSerials[currentFrame] > context->completedSerial) {
+        context->completedSerial = context->frameSerials[currentFrame];
+    }
+    release_retired_swapchains(context);
+
+    // Acquire image; headless frames own the offscreen image of their frame slot
+    uint32_t imageIndex = currentFrame;
+    if (!context->headless) {
+        PROFILE_CPU_BEGIN(profiler, "acquire");
+        result = vkAcquireNextImageKHR(context->device, context->swapchain, UINT64_MAX,
+                                       context->imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+        PROFILE_CPU_END(profiler);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            return false;
+        } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to acquire swapchain image");
+            return false;
+        }
+
+        if (context->fencesInUse[imageIndex] != VK_NULL_HANDLE && context->fencesInUse[imageIndex] != context->inFlightFences[currentFrame]) {
+            vkWaitForFences(context->device, 1, &context->fencesInUse[imageIndex], VK_TRUE, UINT64_MAX);
+        }
+        context->fencesInUse[imageIndex] = context->inFlightFences[currentFrame];
+    }
+
+    // The fence is reset only right before the submit, so a frame that fails earlier leaves it signalled
+    vkResetCommandBuffer(commandBuffer, 0);
+
+    // The fence guarantees the GPU is done with this frame's uniform region
+    context->uniformSlotCursor = 0;
+    context->stats.uniformBytesWritten = 0;
+    context->stats.uniformSlotsUsed = 0;
 
     // Calculate view-projection matrix
-    mat4 projection, view, vp;
-    glm_ortho(0.0f, context->swapchainExtent.width / context->camera.scale,
-              context->swapchainExtent.height / context->camera.scale, 0.0f,
-              -1.0f, 1.0f, projection);
-    glm_translate_make(view, (vec3){context->camera.position[0], context->camera.position[1], 0.0f});
-    glm_mat4_mul(projection, view, vp);
+    PROFILE_CPU_BEGIN(profiler, "matrices");
+    mat4 vp;
+    vulkan_view_projection(context, vp);
+    PROFILE_CPU_END(profiler);
 
     // Begin command buffer
+    PROFILE_CPU_BEGIN(profiler, "record");
+    Uint64 recordStart = SDL_GetTicksNS();
     VkCommandBufferBeginInfo beginInfo = { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-    vkBeginCommandBuffer(context->commandBuffers[imageIndex], &beginInfo);
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    profiler_gpu_frame_begin(profiler, commandBuffer, currentFrame);
+    // Glyph copies into the atlas must land before the render pass samples it
+    if (context->textContext) {
+        PROFILE_GPU_BEGIN(profiler, commandBuffer, "text prepare");
+        text_prepare(context, context->textContext, commandBuffer);
+        PROFILE_GPU_END(profiler, commandBuffer);
+    }
+    if (context->wireContext) {
+        PROFILE_CPU_BEGIN(profiler, "wires");
+        wire_prepare(context, context->wireContext);
+        PROFILE_CPU_END(profiler);
+    }
+    PROFILE_GPU_BEGIN(profiler, commandBuffer, "render pass");
 
     VkClearValue clearColor = { .color = { { 0.0f, 0.0f, 0.0f, 1.0f } } };
     VkRenderPassBeginInfo renderPassInfo = {
@@ -1015,58 +1514,81 @@ bool vulkan_render(VulkanContext *context) {
         .clearValueCount = 1,
         .pClearValues = &clearColor
     };
-    vkCmdBeginRenderPass(context->commandBuffers[imageIndex], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-    // Render triangle and square
-    vkCmdBindPipeline(context->commandBuffers[imageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, context->graphicsPipeline);
-    VkDeviceSize offsets[] = {0};
-    for (int i = 0; i < 2; i++) {
-        mat4 mvp;
-        glm_mat4_mul(vp, context->objects[i].modelMatrix, mvp);
-        void *data;
-        vkMapMemory(context->device, context->uniformBufferMemory, 0, sizeof(mat4), 0, &data);
-        memcpy(data, mvp, sizeof(mat4));
-        vkUnmapMemory(context->device, context->uniformBufferMemory);
-
-        vkCmdBindDescriptorSets(context->commandBuffers[imageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                context->pipelineLayout, 0, 1, &context->descriptorSets[imageIndex], 0, NULL);
-        if (i == 0) {
-            vkCmdBindVertexBuffers(context->commandBuffers[imageIndex], 0, 1, &context->triangleVertexBuffer, offsets);
-            vkCmdDraw(context->commandBuffers[imageIndex], 3, 1, 0, 0);
-        } else {
-            vkCmdBindVertexBuffers(context->commandBuffers[imageIndex], 0, 1, &context->squareVertexBuffer, offsets);
-            vkCmdBindIndexBuffer(context->commandBuffers[imageIndex], context->squareIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
-            vkCmdDrawIndexed(context->commandBuffers[imageIndex], 6, 1, 0, 0, 0);
-        }
-    }
-
-    // Render text
-    if (context->textContext) {
-        text_render(context, context->textContext, context->commandBuffers[imageIndex]);
+    if (context->recordThreads > 1) {
+        // Timestamps cannot be written inside a subpass fed by secondaries, so the chunks have no GPU scopes
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        record_secondaries(context, commandBuffer, currentFrame, context->framebuffers[imageIndex], vp);
+    } else {
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        record_inline(context, commandBuffer, currentFrame, vp);
     }
 
-    vkCmdEndRenderPass(context->commandBuffers[imageIndex]);
-    if (vkEndCommandBuffer(context->commandBuffers[imageIndex]) != VK_SUCCESS) {
+    vkCmdEndRenderPass(commandBuffer);
+    PROFILE_GPU_END(profiler, commandBuffer);
+    profiler_gpu_frame_end(profiler, commandBuffer);
+    result = vkEndCommandBuffer(commandBuffer);
+    context->stats.recordNs = SDL_GetTicksNS() - recordStart;
+    PROFILE_CPU_END(profiler);
+    if (result != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to end command buffer");
         return false;
     }
 
+    // Send this frame's uploads as one transfer batch; the draw waits on its timeline value
+    PROFILE_CPU_BEGIN(profiler, "submit");
+    uint64_t uploadValue = upload_flush(&context->upload);
+    VkSemaphore waitSemaphores[2];
+    uint64_t waitValues[2];
+    VkPipelineStageFlags waitStages[2];
+    uint32_t waitCount = 0;
+    if (!context->headless) {
+        waitSemaphores[waitCount] = context->imageAvailableSemaphores[currentFrame];
+        waitValues[waitCount] = 0;
+        waitStages[waitCount++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    }
+    if (uploadValue > 0) {
+        waitSemaphores[waitCount] = context->upload.timeline;
+        waitValues[waitCount] = uploadValue;
+        waitStages[waitCount++] = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    }
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount = waitCount,
+        .pWaitSemaphoreValues = waitValues
+    };
+
     // Submit
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
     VkSubmitInfo submitInfo = {
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .waitSemaphoreCount = 1,
-        .pWaitSemaphores = &context->imageAvailableSemaphores[currentFrame],
+        .pNext = &timelineInfo,
+        .waitSemaphoreCount = waitCount,
+        .pWaitSemaphores = waitSemaphores,
         .pWaitDstStageMask = waitStages,
         .commandBufferCount = 1,
-        .pCommandBuffers = &context->commandBuffers[imageIndex],
-        .signalSemaphoreCount = 1,
-        .pSignalSemaphores = &context->renderFinishedSemaphores[imageIndex]
+        .pCommandBuffers = &commandBuffer,
+        .signalSemaphoreCount = context->headless ? 0 : 1,
+        .pSignalSemaphores = context->headless ? NULL : &context->renderFinishedSemaphores[imageIndex]
     };
-    if (vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, context->inFlightFences[currentFrame]) != VK_SUCCESS) {
+    vkResetFences(context->device, 1, &context->inFlightFences[currentFrame]);
+    result = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, context->inFlightFences[currentFrame]);
+    PROFILE_CPU_END(profiler);
+    if (result != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to submit draw command buffer");
+        // An empty submit signals the fence again, so the next wait on this frame cannot hang
+        vkQueueSubmit(context->graphicsQueue, 0, NULL, context->inFlightFences[currentFrame]);
         return false;
     }
+    context->frameSerials[currentFrame] = ++context->submitSerial;
+    context->stats.frameIndex++;
+    context->dirty = false;
+    // Glyphs that missed this frame's upload budget are drawn by the next one
+    if (context->textContext && context->textContext->glyphsDeferred) context->dirty = true;
+    context->currentFrame = (currentFrame + 1) % context->framesInFlight;
+    context->lastImageIndex = imageIndex;
+    if (context->headless) {
+        record_frame_interval(context);
+        return true;
+    }
 
     // Present
     VkPresentInfoKHR presentInfo = {
@@ -1077,7 +1599,10 @@ bool vulkan_render(VulkanContext *context) {
         .pSwapchains = &context->swapchain,
         .pImageIndices = &imageIndex
     };
+    PROFILE_CPU_BEGIN(profiler, "present");
     result = vkQueuePresentKHR(context->presentQueue, &presentInfo);
+    PROFILE_CPU_END(profiler);
+    record_frame_interval(context);
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
         return false;
     } else if (result != VK_SUCCESS) {
@@ -1085,211 +1610,256 @@ bool vulkan_render(VulkanContext *context) {
         return false;
     }
 
-    currentFrame = (currentFrame + 1) % context->imageCount;
     return true;
 }
 
 
+void vulkan_log_stats(const VulkanContext *context) {
+    SDL_Log("Frame %llu (%llu skipped): uniform ring %llu bytes in %u slots, %u nodes (%llu bytes) in %u draw calls, "
+            "%u nodes culled, %u transforms rebuilt, %u/%u labels drawn/culled (%u glyphs), recorded in %.3f ms on %u threads",
+            (unsigned long long)context->stats.frameIndex,
+            (unsigned long long)context->stats.framesSkipped,
+            (unsigned long long)context->stats.uniformBytesWritten,
+            context->stats.uniformSlotsUsed,
+            context->stats.instancesDrawn,
+            (unsigned long long)context->stats.instanceBytesWritten,
+            context->stats.drawCalls,
+            context->stats.nodesCulled,
+            context->stats.transformsRebuilt,
+            context->stats.labelsDrawn,
+            context->stats.labelsCulled,
+            context->stats.glyphsDrawn,
+            context->stats.recordNs / 1e6,
+            context->recordThreads);
+    if (context->textContext) {
+        const GlyphAtlas *atlas = &context->textContext->atlas;
+        SDL_Log("Glyph atlas: %u glyphs, %.1f%% occupied, %llu hits, %llu misses, %llu evictions, %u uploaded last frame",
+                atlas->count, atlas_occupancy(atlas) * 100.0f,
+                (unsigned long long)atlas->stats.hits,
+                (unsigned long long)atlas->stats.misses,
+                (unsigned long long)atlas->stats.evictions,
+                context->stats.glyphsUploaded);
+        const LayoutCache *layouts = &context->textContext->layouts;
+        SDL_Log("Layout cache: %u runs in %.1f of %.1f KB, %llu hits, %llu misses, %llu evictions",
+                layouts->count, layouts->bytes / 1024.0, layouts->budget / 1024.0,
+                (unsigned long long)layouts->stats.hits,
+                (unsigned long long)layouts->stats.misses,
+                (unsigned long long)layouts->stats.evictions);
+    }
 
+    if (context->wireContext) {
+        SDL_Log("Wires: %u drawn, %u culled, %u endpoints updated last frame",
+                context->stats.wiresDrawn, context->stats.wiresCulled, context->stats.wireEndpointsUpdated);
+    }
 
+    const RenderStats *stats = &context->stats;
+    if (stats->frameIntervalCount > 0) {
+        Uint64 total = 0, shortest = UINT64_MAX, longest = 0;
+        for (uint32_t i = 0; i < stats->frameIntervalCount; i++) {
+            Uint64 interval = stats->frameIntervalsNs[i];
+            total += interval;
+            if (interval < shortest) shortest = interval;
+            if (interval > longest) longest = interval;
+        }
+        double averageMs = total / 1e6 / stats->frameIntervalCount;
+        SDL_Log("Present %s, %u frames in flight%s: frame interval %.2f ms (%.1f fps), min %.2f ms, max %.2f ms over %u frames",
+                context->headless ? "offscreen" : vulkan_present_mode_name(context->presentMode),
+                context->framesInFlight, context->present.paceFps ? ", paced" : "",
+                averageMs, averageMs > 0.0 ? 1000.0 / averageMs : 0.0,
+                shortest / 1e6, longest / 1e6, stats->frameIntervalCount);
+    }
+}
 
 
-void vulkan_cleanup(VulkanContext *context) {
+// Copy the most recent headless frame into a host buffer and write it as a BMP
+bool vulkan_save_frame(VulkanContext *context, const char *path) {
+    if (!context->headless || context->stats.frameIndex == 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "No headless frame to read back");
+        return false;
+    }
+    VkExtent2D extent = context->swapchainExtent;
+    VkBuffer readbackBuffer;
+    MemoryAllocation readbackAllocation;
+    if (!createBuffer(&context->allocator, (VkDeviceSize)extent.width * extent.height * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                      &readbackBuffer, &readbackAllocation)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create readback buffer");
+        return false;
+    }
+
+    // The copy reuses the next frame's command buffer and fence once every frame has drained
     vkDeviceWaitIdle(context->device);
+    VkCommandBuffer commandBuffer = context->commandBuffers[context->currentFrame];
+    VkFence fence = context->inFlightFences[context->currentFrame];
+    vkResetFences(context->device, 1, &fence);
+    vkResetCommandBuffer(commandBuffer, 0);
+    VkCommandBufferBeginInfo beginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    VkBufferImageCopy region = {
+        .imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+        .imageExtent = { extent.width, extent.height, 1 }
+    };
+    vkCmdCopyImageToBuffer(commandBuffer, context->offscreenImages[context->lastImageIndex],
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+    VkBufferMemoryBarrier hostBarrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = readbackBuffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE
+    };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                         0, NULL, 1, &hostBarrier, 0, NULL);
+    vkEndCommandBuffer(commandBuffer);
 
-    if (context->textContext) {
-        text_cleanup(context, context->textContext);
-        free(context->textContext);
+    VkSubmitInfo submitInfo = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &commandBuffer
+    };
+    bool success = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, fence) == VK_SUCCESS &&
+                   vkWaitForFences(context->device, 1, &fence, VK_TRUE, UINT64_MAX) == VK_SUCCESS;
+    if (!success) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to copy frame to readback buffer");
+    } else {
+        // B8G8R8A8_UNORM is BGRA in memory
+        SDL_Surface *surface = SDL_CreateSurfaceFrom((int)extent.width, (int)extent.height, SDL_PIXELFORMAT_BGRA32,
+                                                     readbackAllocation.mapped, (int)extent.width * 4);
+        success = surface && SDL_SaveBMP(surface, path);
+        if (success) {
+            SDL_Log("Saved frame %llu (%ux%u) to %s", (unsigned long long)context->stats.frameIndex,
+                    extent.width, extent.height, path);
+        } else {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to save frame to %s: %s", path, SDL_GetError());
+        }
+        SDL_DestroySurface(surface);
     }
+    destroyBuffer(&context->allocator, &readbackBuffer, &readbackAllocation);
+    return success;
+}
+
 
-    vkDestroyBuffer(context->device, context->triangleVertexBuffer, NULL);
-    vkFreeMemory(context->device, context->triangleVertexBufferMemory, NULL);
-    vkDestroyBuffer(context->device, context->squareVertexBuffer, NULL);
-    vkFreeMemory(context->device, context->squareVertexBufferMemory, NULL);
-    vkDestroyBuffer(context->device, context->squareIndexBuffer, NULL);
-    vkFreeMemory(context->device, context->squareIndexBufferMemory, NULL);
-    vkDestroyBuffer(context->device, context->uniformBuffer, NULL);
-    vkFreeMemory(context->device, context->uniformBufferMemory, NULL);
-    vkDestroyDescriptorPool(context->device, context->descriptorPool, NULL);
-    vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
-    free(context->descriptorSets);
+// World to clip space for the current camera, shared by nodes and world-space text
+void vulkan_view_projection(const VulkanContext *context, mat4 vp) {
+    mat4 projection, view;
+    glm_ortho(0.0f, context->swapchainExtent.width / context->camera.scale,
+              context->swapchainExtent.height / context->camera.scale, 0.0f,
+              -1.0f, 1.0f, projection);
+    glm_translate_make(view, (vec3){context->camera.position[0], context->camera.position[1], 0.0f});
+    glm_mat4_mul(projection, view, vp);
+}
 
-    // ... rest of cleanup ...
+// World rectangle covered by the swapchain at the current camera
+void vulkan_visible_rect(const VulkanContext *context, SpatialRect *rect) {
+    vec2 topLeft, bottomRight;
+    vulkan_screen_to_world(context, 0.0f, 0.0f, topLeft);
+    vulkan_screen_to_world(context, (float)context->swapchainExtent.width, (float)context->swapchainExtent.height, bottomRight);
+    *rect = (SpatialRect){ topLeft[0], topLeft[1], bottomRight[0], bottomRight[1] };
 }
 
+void vulkan_screen_to_world(const VulkanContext *context, float screenX, float screenY, vec2 world) {
+    // Inverse of the orthographic projection and camera translation used by vulkan_render
+    world[0] = screenX / context->camera.scale - context->camera.position[0];
+    world[1] = screenY / context->camera.scale - context->camera.position[1];
+}
 
 
 
-bool recreate_swapchain(VulkanContext *context, SDL_Window *window) {
-    SDL_Log("Recreating swapchain");
 
-    // Wait for the device to be idle
-    vkDeviceWaitIdle(context->device);
+// Safe to call on a partially initialized (zeroed) context
+void vulkan_cleanup(VulkanContext *context) {
+    if (context->device != VK_NULL_HANDLE) {
+        vkDeviceWaitIdle(context->device);
+
+        if (context->textContext) {
+            text_cleanup(context, context->textContext);
+            free(context->textContext);
+            context->textContext = NULL;
+        }
+        if (context->wireContext) {
+            wire_cleanup(context, context->wireContext);
+            free(context->wireContext);
+            context->wireContext = NULL;
+        }
+
+        upload_cleanup(&context->upload);
+        destroyBuffer(&context->allocator, &context->meshVertexBuffer, &context->meshVertexAllocation);
+        destroyBuffer(&context->allocator, &context->meshIndexBuffer, &context->meshIndexAllocation);
+        destroyBuffer(&context->allocator, &context->nodeBuffer, &context->nodeAllocation);
+        destroyBuffer(&context->allocator, &context->uniformBuffer, &context->uniformAllocation);
+        context->nodeBufferMapped = NULL;
+        context->uniformBufferMapped = NULL;
+        vkDestroyDescriptorPool(context->device, context->descriptorPool, NULL);
+        vkDestroyDescriptorSetLayout(context->device, context->descriptorSetLayout, NULL);
+
+        vkDestroyPipeline(context->device, context->graphicsPipeline, NULL);
+        vkDestroyPipelineLayout(context->device, context->pipelineLayout, NULL);
+        savePipelineCache(context->device, context->pipelineCache, context->pipelineCachePath);
+        vkDestroyPipelineCache(context->device, context->pipelineCache, NULL);
 
-    // Destroy old resources
-    for (uint32_t i = 0; i < context->imageCount; i++) {
-        vkDestroyFramebuffer(context->device, context->framebuffers[i], NULL);
-        vkDestroyImageView(context->device, context->imageViews[i], NULL);
+        for (uint32_t i = 0; i < context->framesInFlight; i++) {
+            if (context->imageAvailableSemaphores) vkDestroySemaphore(context->device, context->imageAvailableSemaphores[i], NULL);
+            if (context->inFlightFences) vkDestroyFence(context->device, context->inFlightFences[i], NULL);
+        }
+        destroy_record_pools(context);
+        vkDestroyCommandPool(context->device, context->commandPool, NULL);
+        profiler_destroy(&context->profiler);
+
+        for (uint32_t i = 0; i < context->retiredSwapchainCount; i++) {
+            destroy_retired_swapchain(context, &context->retiredSwapchains[i]);
+        }
+        context->retiredSwapchainCount = 0;
+        destroy_swapchain_images(context->device, context->imageViews, context->framebuffers,
+                                 context->renderFinishedSemaphores, context->imageCount);
+        for (uint32_t i = 0; context->offscreenImages && i < context->imageCount; i++) {
+            destroyImage(&context->allocator, &context->offscreenImages[i], &context->offscreenAllocations[i]);
+        }
+        vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
+        vkDestroyRenderPass(context->device, context->renderPass, NULL);
+        memory_allocator_destroy(&context->allocator);
+        vkDestroyDevice(context->device, NULL);
     }
-    vkFreeCommandBuffers(context->device, context->commandPool, context->imageCount, context->commandBuffers);
-    for (uint32_t i = 0; i < context->imageCount; i++) {
-        vkDestroySemaphore(context->device, context->imageAvailableSemaphores[i], NULL);
-        vkDestroySemaphore(context->device, context->renderFinishedSemaphores[i], NULL);
-        vkDestroyFence(context->device, context->inFlightFences[i], NULL);
+    for (int m = 0; m < NODE_MESH_COUNT; m++) {
+        free(context->cull.indices[m]);
     }
-    free(context->framebuffers);
-    free(context->imageViews);
+    memset(&context->cull, 0, sizeof(NodeCullList));
     free(context->commandBuffers);
     free(context->imageAvailableSemaphores);
-    free(context->renderFinishedSemaphores);
     free(context->inFlightFences);
+    free(context->frameSerials);
     free(context->fencesInUse);
-    vkDestroySwapchainKHR(context->device, context->swapchain, NULL);
-
-    // Get new surface capabilities
-    VkSurfaceCapabilitiesKHR surfaceCaps;
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(context->physicalDevice, context->surface, &surfaceCaps);
-    context->swapchainExtent = surfaceCaps.currentExtent;
-    if (context->swapchainExtent.width == 0 || context->swapchainExtent.height == 0) {
-        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Window minimized, skipping swapchain recreation");
-        return false;
-    }
-
-    // Recreate swapchain
-    uint32_t formatCount, presentModeCount;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(context->physicalDevice, context->surface, &formatCount, NULL);
-    VkSurfaceFormatKHR *formats = malloc(formatCount * sizeof(VkSurfaceFormatKHR));
-    vkGetPhysicalDeviceSurfaceFormatsKHR(context->physicalDevice, context->surface, &formatCount, formats);
-    VkSurfaceFormatKHR surfaceFormat = formats[0]; // Simplified: pick first format
-    free(formats);
-    vkGetPhysicalDeviceSurfacePresentModesKHR(context->physicalDevice, context->surface, &presentModeCount, NULL);
-    VkPresentModeKHR *presentModes = malloc(presentModeCount * sizeof(VkPresentModeKHR));
-    vkGetPhysicalDeviceSurfacePresentModesKHR(context->physicalDevice, context->surface, &presentModeCount, presentModes);
-    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
-    free(presentModes);
-
-    uint32_t queueFamilyIndices[] = { context->graphicsFamily, context->presentFamily }; // From vulkan_init
-    VkSwapchainCreateInfoKHR swapchainInfo = {
-        .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
-        .surface = context->surface,
-        .minImageCount = surfaceCaps.minImageCount + 1,
-        .imageFormat = surfaceFormat.format,
-        .imageColorSpace = surfaceFormat.colorSpace,
-        .imageExtent = context->swapchainExtent,
-        .imageArrayLayers = 1,
-        .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-        .imageSharingMode = queueFamilyIndices[0] == queueFamilyIndices[1] ? VK_SHARING_MODE_EXCLUSIVE : VK_SHARING_MODE_CONCURRENT,
-        .queueFamilyIndexCount = queueFamilyIndices[0] == queueFamilyIndices[1] ? 0 : 2,
-        .pQueueFamilyIndices = queueFamilyIndices,
-        .preTransform = surfaceCaps.currentTransform,
-        .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
-        .presentMode = presentMode,
-        .clipped = VK_TRUE,
-        .oldSwapchain = VK_NULL_HANDLE
-    };
-    if (vkCreateSwapchainKHR(context->device, &swapchainInfo, NULL, &context->swapchain) != VK_SUCCESS) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to recreate swapchain");
-        return false;
+    free(context->offscreenImages);
+    free(context->offscreenAllocations);
+    node_store_destroy(&context->nodes);
+    if (context->instance != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(context->instance, context->surface, NULL);
+        vkDestroyInstance(context->instance, NULL);
     }
+    context->device = VK_NULL_HANDLE;
+    context->instance = VK_NULL_HANDLE;
+}
 
-    // Get new swapchain images
-    vkGetSwapchainImagesKHR(context->device, context->swapchain, &context->imageCount, NULL);
-    VkImage *swapchainImages = malloc(context->imageCount * sizeof(VkImage));
-    vkGetSwapchainImagesKHR(context->device, context->swapchain, &context->imageCount, swapchainImages);
 
-    // Recreate image views
-    context->imageViews = malloc(context->imageCount * sizeof(VkImageView));
-    for (uint32_t i = 0; i < context->imageCount; i++) {
-        VkImageViewCreateInfo viewInfo = {
-            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-            .image = swapchainImages[i],
-            .viewType = VK_IMAGE_VIEW_TYPE_2D,
-            .format = surfaceFormat.format,
-            .components = { VK_COMPONENT_SWIZZLE_IDENTITY },
-            .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-            .subresourceRange.baseMipLevel = 0,
-            .subresourceRange.levelCount = 1,
-            .subresourceRange.baseArrayLayer = 0,
-            .subresourceRange.layerCount = 1
-        };
-        if (vkCreateImageView(context->device, &viewInfo, NULL, &context->imageViews[i]) != VK_SUCCESS) {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to recreate image view %u", i);
-            free(swapchainImages);
-            return false;
-        }
-    }
-    free(swapchainImages);
 
-    // Recreate framebuffers
-    context->framebuffers = malloc(context->imageCount * sizeof(VkFramebuffer));
-    for (uint32_t i = 0; i < context->imageCount; i++) {
-        VkFramebufferCreateInfo framebufferInfo = {
-            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-            .renderPass = context->renderPass,
-            .attachmentCount = 1,
-            .pAttachments = &context->imageViews[i],
-            .width = context->swapchainExtent.width,
-            .height = context->swapchainExtent.height,
-            .layers = 1
-        };
-        if (vkCreateFramebuffer(context->device, &framebufferInfo, NULL, &context->framebuffers[i]) != VK_SUCCESS) {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to recreate framebuffer %u", i);
-            return false;
-        }
-    }
 
-    // Recreate command buffers
-    context->commandBuffers = malloc(context->imageCount * sizeof(VkCommandBuffer));
-    VkCommandBufferAllocateInfo allocInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .commandPool = context->commandPool,
-        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = context->imageCount
-    };
-    if (vkAllocateCommandBuffers(context->device, &allocInfo, context->commandBuffers) != VK_SUCCESS) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate new command buffers");
-        free(context->commandBuffers);
-        return false;
-    }
+bool recreate_swapchain(VulkanContext *context, SDL_Window *window) {
+    SDL_Log("Recreating swapchain");
+    context->window = window;
 
-    // Recreate synchronization objects
-    context->imageAvailableSemaphores = malloc(context->imageCount * sizeof(VkSemaphore));
-    context->renderFinishedSemaphores = malloc(context->imageCount * sizeof(VkSemaphore));
-    context->inFlightFences = malloc(context->imageCount * sizeof(VkFence));
-    context->fencesInUse = malloc(context->imageCount * sizeof(VkFence));
-    if (!context->imageAvailableSemaphores || !context->renderFinishedSemaphores || 
-        !context->inFlightFences || !context->fencesInUse) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate synchronization arrays");
-        free(context->imageAvailableSemaphores);
-        free(context->renderFinishedSemaphores);
-        free(context->inFlightFences);
-        free(context->fencesInUse);
+    // No device idle: the old swapchain is handed to the new one and its
+    // per-image resources are released once their frames' fences signal
+    if (!create_swapchain(context)) {
         return false;
     }
-    VkSemaphoreCreateInfo semaphoreInfo = { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
-    VkFenceCreateInfo fenceInfo = { .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, .flags = VK_FENCE_CREATE_SIGNALED_BIT };
-    for (uint32_t i = 0; i < context->imageCount; i++) {
-        if (vkCreateSemaphore(context->device, &semaphoreInfo, NULL, &context->imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(context->device, &semaphoreInfo, NULL, &context->renderFinishedSemaphores[i]) != VK_SUCCESS ||
-            vkCreateFence(context->device, &fenceInfo, NULL, &context->inFlightFences[i]) != VK_SUCCESS) {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create synchronization objects for frame %u", i);
-            for (uint32_t j = 0; j < i; j++) {
-                vkDestroySemaphore(context->device, context->imageAvailableSemaphores[j], NULL);
-                vkDestroySemaphore(context->device, context->renderFinishedSemaphores[j], NULL);
-                vkDestroyFence(context->device, context->inFlightFences[j], NULL);
-            }
-            free(context->imageAvailableSemaphores);
-            free(context->renderFinishedSemaphores);
-            free(context->inFlightFences);
-            free(context->fencesInUse);
-            return false;
-        }
-        context->fencesInUse[i] = VK_NULL_HANDLE;
-    }
 
-    SDL_Log("Swapchain recreated successfully with %u images", context->imageCount);
+    context->dirty = true;
+    SDL_Log("Swapchain recreated successfully with %u images (%ux%u)",
+            context->imageCount, context->swapchainExtent.width, context->swapchainExtent.height);
     return true;
 }
-
-
-//
\ No newline at end of file
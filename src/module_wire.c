@@ -0,0 +1,512 @@
+// module_wire.c
+#include "module_wire.h"
+#include "vulkan_utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include "shader_wire_vert_spv.h"
+#include "shader_wire_frag_spv.h"
+
+static uint32_t pack_color(const float color[4]) {
+    uint32_t packed = 0;
+    for (int c = 0; c < 4; c++) {
+        packed |= (uint32_t)(SDL_clamp(color[c], 0.0f, 1.0f) * 255.0f + 0.5f) << (c * 8);
+    }
+    return packed;
+}
+
+// A cubic bezier lies inside the hull of its control points, so their box bounds the curve
+static void wire_bounds(const WireInstance *wire, SpatialRect *bounds) {
+    float points[4][2] = {
+        { wire->p0[0], wire->p0[1] },
+        { wire->p0[0] + wire->c1[0], wire->p0[1] + wire->c1[1] },
+        { wire->p3[0] + wire->c2[0], wire->p3[1] + wire->c2[1] },
+        { wire->p3[0], wire->p3[1] }
+    };
+    float h = wire->width * 0.5f;
+    *bounds = (SpatialRect){ points[0][0], points[0][1], points[0][0], points[0][1] };
+    for (int i = 1; i < 4; i++) {
+        bounds->minX = SDL_min(bounds->minX, points[i][0]);
+        bounds->minY = SDL_min(bounds->minY, points[i][1]);
+        bounds->maxX = SDL_max(bounds->maxX, points[i][0]);
+        bounds->maxY = SDL_max(bounds->maxY, points[i][1]);
+    }
+    bounds->minX -= h;
+    bounds->minY -= h;
+    bounds->maxX += h;
+    bounds->maxY += h;
+}
+
+#define GROW_ARRAY(array, capacity) do { \
+        void *grown = realloc((array), (capacity) * sizeof(*(array))); \
+        if (!grown) return false; \
+        (array) = grown; \
+    } while (0)
+
+static bool grow_wires(WireContext *wireContext) {
+    uint32_t capacity = wireContext->capacity ? wireContext->capacity * 2 : 64;
+    GROW_ARRAY(wireContext->instances, capacity);
+    GROW_ARRAY(wireContext->bounds, capacity);
+    GROW_ARRAY(wireContext->handles, capacity);
+    wireContext->capacity = capacity;
+    return true;
+}
+
+static bool grow_slots(WireContext *wireContext) {
+    uint32_t capacity = wireContext->slotCapacity ? wireContext->slotCapacity * 2 : 64;
+    GROW_ARRAY(wireContext->slots, capacity);
+    wireContext->slotCapacity = capacity;
+    return true;
+}
+
+// Node handles are dense from zero, so the list heads are a flat array sized to the largest one seen
+static bool grow_node_wires(WireContext *wireContext, NodeHandle node) {
+    if (node < wireContext->nodeWireCapacity) return true;
+    uint32_t capacity = wireContext->nodeWireCapacity ? wireContext->nodeWireCapacity : 64;
+    while (capacity <= node) capacity *= 2;
+    GROW_ARRAY(wireContext->nodeWires, capacity);
+    for (uint32_t i = wireContext->nodeWireCapacity; i < capacity; i++) wireContext->nodeWires[i] = WIRE_HANDLE_INVALID;
+    wireContext->nodeWireCapacity = capacity;
+    return true;
+}
+
+static WireSlot *get_wire(WireContext *wireContext, WireHandle wire) {
+    if (wire >= wireContext->slotCount || !wireContext->slots[wire].live) return NULL;
+    return &wireContext->slots[wire];
+}
+
+// Take the wire out of the list of one of its nodes; lists are as long as the node's degree
+static void unlink_wire(WireContext *wireContext, WireHandle wire, int end) {
+    NodeHandle node = wireContext->slots[wire].nodes[end];
+    WireHandle *link = &wireContext->nodeWires[node];
+    while (*link != wire) {
+        WireSlot *slot = &wireContext->slots[*link];
+        link = &slot->next[slot->nodes[0] == node ? 0 : 1];
+    }
+    *link = wireContext->slots[wire].next[end];
+}
+
+// Rewrite the endpoint each wire of the node has at it; nothing else of the wire changes
+static void node_moved(void *userData, NodeHandle handle, float x, float y) {
+    WireContext *wireContext = userData;
+    if (handle >= wireContext->nodeWireCapacity) return;
+    for (WireHandle wire = wireContext->nodeWires[handle]; wire != WIRE_HANDLE_INVALID;) {
+        const WireSlot *slot = &wireContext->slots[wire];
+        int end = slot->nodes[0] == handle ? 0 : 1;
+        WireInstance *instance = &wireContext->instances[slot->index];
+        float *endpoint = end == 0 ? instance->p0 : instance->p3;
+        endpoint[0] = x;
+        endpoint[1] = y;
+        wire_bounds(instance, &wireContext->bounds[slot->index]);
+        wireContext->endpointsUpdated++;
+        wire = slot->next[end];
+    }
+}
+
+static void node_removed(void *userData, NodeHandle handle) {
+    WireContext *wireContext = userData;
+    if (handle >= wireContext->nodeWireCapacity) return;
+    while (wireContext->nodeWires[handle] != WIRE_HANDLE_INVALID) {
+        wire_remove(wireContext, wireContext->nodeWires[handle]);
+    }
+}
+
+// A node added since the last transform update has no world position yet; the move reported for
+// it by that update fills its endpoint in before the wire is drawn
+WireHandle wire_add(WireContext *wireContext, NodeHandle from, NodeHandle to, float width, const float color[4]) {
+    float p0[2], p3[2];
+    if (from == to || !node_get_world_position(wireContext->nodes, from, p0) ||
+        !node_get_world_position(wireContext->nodes, to, p3)) {
+        return WIRE_HANDLE_INVALID;
+    }
+    if ((wireContext->count == wireContext->capacity && !grow_wires(wireContext)) ||
+        !grow_node_wires(wireContext, SDL_max(from, to))) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow wires");
+        return WIRE_HANDLE_INVALID;
+    }
+
+    // Reuse a released handle before issuing a new one
+    WireHandle handle;
+    if (wireContext->freeSlot != WIRE_HANDLE_INVALID) {
+        handle = wireContext->freeSlot;
+        wireContext->freeSlot = wireContext->slots[handle].index;
+    } else {
+        if (wireContext->slotCount == wireContext->slotCapacity && !grow_slots(wireContext)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow wire handle table");
+            return WIRE_HANDLE_INVALID;
+        }
+        handle = wireContext->slotCount++;
+    }
+
+    uint32_t index = wireContext->count++;
+    wireContext->instances[index] = (WireInstance){
+        { p0[0], p0[1] }, { p3[0], p3[1] },
+        { WIRE_DEFAULT_TANGENT, 0.0f }, { -WIRE_DEFAULT_TANGENT, 0.0f },
+        pack_color(color), width
+    };
+    wire_bounds(&wireContext->instances[index], &wireContext->bounds[index]);
+    wireContext->handles[index] = handle;
+
+    WireSlot *slot = &wireContext->slots[handle];
+    slot->nodes[0] = from;
+    slot->nodes[1] = to;
+    slot->next[0] = wireContext->nodeWires[from];
+    slot->next[1] = wireContext->nodeWires[to];
+    slot->index = index;
+    slot->live = true;
+    wireContext->nodeWires[from] = handle;
+    wireContext->nodeWires[to] = handle;
+    return handle;
+}
+
+bool wire_remove(WireContext *wireContext, WireHandle wire) {
+    WireSlot *slot = get_wire(wireContext, wire);
+    if (!slot) return false;
+    unlink_wire(wireContext, wire, 0);
+    unlink_wire(wireContext, wire, 1);
+
+    // Swap the last wire into the hole to keep the arrays dense
+    uint32_t index = slot->index;
+    uint32_t last = --wireContext->count;
+    if (index != last) {
+        wireContext->instances[index] = wireContext->instances[last];
+        wireContext->bounds[index] = wireContext->bounds[last];
+        wireContext->handles[index] = wireContext->handles[last];
+        wireContext->slots[wireContext->handles[index]].index = index;
+    }
+
+    slot->live = false;
+    slot->index = wireContext->freeSlot;
+    wireContext->freeSlot = wire;
+    return true;
+}
+
+bool wire_set_tangents(WireContext *wireContext, WireHandle wire, const float c1[2], const float c2[2]) {
+    const WireSlot *slot = get_wire(wireContext, wire);
+    if (!slot) return false;
+    WireInstance *instance = &wireContext->instances[slot->index];
+    instance->c1[0] = c1[0];
+    instance->c1[1] = c1[1];
+    instance->c2[0] = c2[0];
+    instance->c2[1] = c2[1];
+    wire_bounds(instance, &wireContext->bounds[slot->index]);
+    return true;
+}
+
+static bool create_instance_buffer(VulkanContext *vulkanContext, WireContext *wireContext, uint32_t capacity) {
+    VkDeviceSize bufferSize = (VkDeviceSize)vulkanContext->framesInFlight * capacity * sizeof(WireInstance);
+    if (!createBuffer(&vulkanContext->allocator, bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    &wireContext->instanceBuffer, &wireContext->instanceAllocation)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create wire instance buffer");
+        return false;
+    }
+    wireContext->instanceCapacity = capacity;
+    return true;
+}
+
+// Growing is rare (capacity doubles), so it is allowed to drain the GPU, like the node ring
+static bool ensure_wire_capacity(VulkanContext *vulkanContext, WireContext *wireContext, uint32_t count) {
+    if (count <= wireContext->instanceCapacity) return true;
+    uint32_t capacity = SDL_max(wireContext->instanceCapacity, WIRE_INITIAL_CAPACITY);
+    while (capacity < count) capacity *= 2;
+    vkDeviceWaitIdle(vulkanContext->device);
+    destroyBuffer(&vulkanContext->allocator, &wireContext->instanceBuffer, &wireContext->instanceAllocation);
+    if (!create_instance_buffer(vulkanContext, wireContext, capacity)) {
+        wireContext->instanceCapacity = 0;
+        return false;
+    }
+    SDL_Log("Wire instance regions grown to %u wires", capacity);
+    return true;
+}
+
+bool wire_init(VulkanContext *vulkanContext, WireContext *wireContext) {
+    SDL_Log("Initializing wire module");
+    wireContext->freeSlot = WIRE_HANDLE_INVALID;
+    wireContext->nodes = &vulkanContext->nodes;
+    node_store_set_listener(&vulkanContext->nodes, &(NodeListener){ node_moved, node_removed, wireContext });
+
+    if (!create_instance_buffer(vulkanContext, wireContext, WIRE_INITIAL_CAPACITY)) {
+        wire_cleanup(vulkanContext, wireContext);
+        return false;
+    }
+
+    VkDescriptorSetLayoutBinding binding = {
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .pImmutableSamplers = NULL
+    };
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = 1,
+        .pBindings = &binding
+    };
+    if (vkCreateDescriptorSetLayout(vulkanContext->device, &layoutInfo, NULL, &wireContext->descriptorSetLayout) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create wire descriptor set layout");
+        wire_cleanup(vulkanContext, wireContext);
+        return false;
+    }
+
+    VkDescriptorPoolSize poolSize = { .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, .descriptorCount = 1 };
+    VkDescriptorPoolCreateInfo poolInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes = &poolSize
+    };
+    if (vkCreateDescriptorPool(vulkanContext->device, &poolInfo, NULL, &wireContext->descriptorPool) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create wire descriptor pool");
+        wire_cleanup(vulkanContext, wireContext);
+        return false;
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = wireContext->descriptorPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &wireContext->descriptorSetLayout
+    };
+    if (vkAllocateDescriptorSets(vulkanContext->device, &allocInfo, &wireContext->descriptorSet) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate wire descriptor set");
+        wire_cleanup(vulkanContext, wireContext);
+        return false;
+    }
+
+    VkDescriptorBufferInfo bufferInfo = {
+        .buffer = vulkanContext->uniformBuffer,
+        .offset = 0,
+        .range = sizeof(mat4)
+    };
+    VkWriteDescriptorSet descriptorWrite = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = wireContext->descriptorSet,
+        .dstBinding = 0,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .pBufferInfo = &bufferInfo
+    };
+    vkUpdateDescriptorSets(vulkanContext->device, 1, &descriptorWrite, 0, NULL);
+
+    // World units per screen pixel; it changes with the zoom, so it is pushed with every draw
+    VkPushConstantRange pushConstantRange = {
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .offset = 0,
+        .size = sizeof(float)
+    };
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &wireContext->descriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange
+    };
+    if (vkCreatePipelineLayout(vulkanContext->device, &pipelineLayoutInfo, NULL, &wireContext->pipelineLayout) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create wire pipeline layout");
+        wire_cleanup(vulkanContext, wireContext);
+        return false;
+    }
+
+    VkShaderModule vertShaderModule = VK_NULL_HANDLE, fragShaderModule = VK_NULL_HANDLE;
+    VkShaderModuleCreateInfo vertShaderInfo = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = sizeof(shader_wire_vert_spv),
+        .pCode = shader_wire_vert_spv
+    };
+    VkShaderModuleCreateInfo fragShaderInfo = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = sizeof(shader_wire_frag_spv),
+        .pCode = shader_wire_frag_spv
+    };
+    if (vkCreateShaderModule(vulkanContext->device, &vertShaderInfo, NULL, &vertShaderModule) != VK_SUCCESS ||
+        vkCreateShaderModule(vulkanContext->device, &fragShaderInfo, NULL, &fragShaderModule) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create wire shader modules");
+        vkDestroyShaderModule(vulkanContext->device, fragShaderModule, NULL);
+        vkDestroyShaderModule(vulkanContext->device, vertShaderModule, NULL);
+        wire_cleanup(vulkanContext, wireContext);
+        return false;
+    }
+
+    // The shader's segment count is a specialization constant, so WIRE_SEGMENTS stays the only definition
+    uint32_t segments = WIRE_SEGMENTS;
+    VkSpecializationMapEntry specializationEntry = { .constantID = 0, .offset = 0, .size = sizeof(uint32_t) };
+    VkSpecializationInfo specializationInfo = {
+        .mapEntryCount = 1,
+        .pMapEntries = &specializationEntry,
+        .dataSize = sizeof(segments),
+        .pData = &segments
+    };
+    VkPipelineShaderStageCreateInfo shaderStages[] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = vertShaderModule,
+            .pName = "main",
+            .pSpecializationInfo = &specializationInfo
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = fragShaderModule,
+            .pName = "main"
+        }
+    };
+    // Every attribute advances per wire; the strip vertices pick their curve parameter and side from gl_VertexIndex
+    VkVertexInputBindingDescription bindingDesc = {
+        .binding = 0,
+        .stride = sizeof(WireInstance),
+        .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE
+    };
+    VkVertexInputAttributeDescription attributeDescs[] = {
+        { .location = 0, .binding = 0, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = offsetof(WireInstance, p0) },
+        { .location = 1, .binding = 0, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = offsetof(WireInstance, c1) },
+        { .location = 2, .binding = 0, .format = VK_FORMAT_R8G8B8A8_UNORM, .offset = offsetof(WireInstance, color) },
+        { .location = 3, .binding = 0, .format = VK_FORMAT_R32_SFLOAT, .offset = offsetof(WireInstance, width) }
+    };
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        .vertexBindingDescriptionCount = 1,
+        .pVertexBindingDescriptions = &bindingDesc,
+        .vertexAttributeDescriptionCount = SDL_arraysize(attributeDescs),
+        .pVertexAttributeDescriptions = attributeDescs
+    };
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+        .primitiveRestartEnable = VK_FALSE
+    };
+    // Viewport and scissor are set by vulkan_render, so resizes keep this pipeline valid
+    VkPipelineViewportStateCreateInfo viewportState = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1
+    };
+    VkPipelineRasterizationStateCreateInfo rasterizer = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .polygonMode = VK_POLYGON_MODE_FILL,
+        .cullMode = VK_CULL_MODE_NONE,
+        .frontFace = VK_FRONT_FACE_CLOCKWISE,
+        .lineWidth = 1.0f
+    };
+    VkPipelineMultisampleStateCreateInfo multisampling = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT
+    };
+    // The ribbon's edges fade over one pixel, so wires blend like text
+    VkPipelineColorBlendAttachmentState colorBlendAttachment = {
+        .blendEnable = VK_TRUE,
+        .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+        .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+        .colorBlendOp = VK_BLEND_OP_ADD,
+        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .alphaBlendOp = VK_BLEND_OP_ADD,
+        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+    };
+    VkPipelineColorBlendStateCreateInfo colorBlending = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .logicOpEnable = VK_FALSE,
+        .attachmentCount = 1,
+        .pAttachments = &colorBlendAttachment
+    };
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = SDL_arraysize(dynamicStates),
+        .pDynamicStates = dynamicStates
+    };
+    VkGraphicsPipelineCreateInfo pipelineInfo = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .stageCount = 2,
+        .pStages = shaderStages,
+        .pVertexInputState = &vertexInputInfo,
+        .pInputAssemblyState = &inputAssembly,
+        .pViewportState = &viewportState,
+        .pRasterizationState = &rasterizer,
+        .pMultisampleState = &multisampling,
+        .pColorBlendState = &colorBlending,
+        .pDynamicState = &dynamicState,
+        .layout = wireContext->pipelineLayout,
+        .renderPass = vulkanContext->renderPass,
+        .subpass = 0
+    };
+    Uint64 pipelineStart = SDL_GetPerformanceCounter();
+    if (vkCreateGraphicsPipelines(vulkanContext->device, vulkanContext->pipelineCache, 1, &pipelineInfo, NULL, &wireContext->graphicsPipeline) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create wire pipeline");
+        vkDestroyShaderModule(vulkanContext->device, fragShaderModule, NULL);
+        vkDestroyShaderModule(vulkanContext->device, vertShaderModule, NULL);
+        wire_cleanup(vulkanContext, wireContext);
+        return false;
+    }
+    SDL_Log("Wire pipeline created in %.3f ms (%s pipeline cache)",
+            (SDL_GetPerformanceCounter() - pipelineStart) * 1000.0 / SDL_GetPerformanceFrequency(),
+            vulkanContext->pipelineCacheWarm ? "warm" : "cold");
+    vkDestroyShaderModule(vulkanContext->device, fragShaderModule, NULL);
+    vkDestroyShaderModule(vulkanContext->device, vertShaderModule, NULL);
+    SDL_Log("Wire module initialized successfully");
+    return true;
+}
+
+void wire_prepare(VulkanContext *vulkanContext, WireContext *wireContext) {
+    wireContext->drawCount = 0;
+    vulkanContext->stats.wireEndpointsUpdated = wireContext->endpointsUpdated;
+    wireContext->endpointsUpdated = 0;
+    if (!ensure_wire_capacity(vulkanContext, wireContext, wireContext->count)) {
+        return;
+    }
+
+    // Only the packing runs per frame; curves are evaluated on the GPU, one strip per wire
+    SpatialRect view;
+    vulkan_visible_rect(vulkanContext, &view);
+    WireInstance *instances = (WireInstance *)((char *)wireContext->instanceAllocation.mapped +
+                                               vulkanContext->currentFrame * wireContext->instanceCapacity * sizeof(WireInstance));
+    uint32_t drawn = 0;
+    for (uint32_t i = 0; i < wireContext->count; i++) {
+        const SpatialRect *bounds = &wireContext->bounds[i];
+        if (bounds->maxX < view.minX || bounds->minX > view.maxX || bounds->maxY < view.minY || bounds->minY > view.maxY) {
+            continue;
+        }
+        instances[drawn++] = wireContext->instances[i];
+    }
+    wireContext->drawCount = drawn;
+    vulkanContext->stats.wiresDrawn = drawn;
+    vulkanContext->stats.wiresCulled = wireContext->count - drawn;
+}
+
+void wire_render(VulkanContext *vulkanContext, WireContext *wireContext, VkCommandBuffer commandBuffer) {
+    if (!wireContext->graphicsPipeline || wireContext->drawCount == 0) return;
+
+    mat4 vp;
+    vulkan_view_projection(vulkanContext, vp);
+    uint32_t dynamicOffset;
+    if (!vulkan_push_uniform(vulkanContext, vp, sizeof(mat4), &dynamicOffset)) {
+        return;
+    }
+    float pixelSize = 1.0f / vulkanContext->camera.scale;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, wireContext->graphicsPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, wireContext->pipelineLayout,
+                            0, 1, &wireContext->descriptorSet, 1, &dynamicOffset);
+    vkCmdPushConstants(commandBuffer, wireContext->pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float), &pixelSize);
+    VkDeviceSize offsets[] = { (VkDeviceSize)vulkanContext->currentFrame * wireContext->instanceCapacity * sizeof(WireInstance) };
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &wireContext->instanceBuffer, offsets);
+    vkCmdDraw(commandBuffer, 2 * (WIRE_SEGMENTS + 1), wireContext->drawCount, 0, 0);
+    vulkanContext->stats.drawCalls++;
+}
+
+// Safe to call on a partially initialized (zeroed) context
+void wire_cleanup(VulkanContext *vulkanContext, WireContext *wireContext) {
+    if (wireContext->nodes) node_store_set_listener(wireContext->nodes, NULL);
+    vkDestroyPipeline(vulkanContext->device, wireContext->graphicsPipeline, NULL);
+    vkDestroyPipelineLayout(vulkanContext->device, wireContext->pipelineLayout, NULL);
+    vkDestroyDescriptorPool(vulkanContext->device, wireContext->descriptorPool, NULL);
+    vkDestroyDescriptorSetLayout(vulkanContext->device, wireContext->descriptorSetLayout, NULL);
+    destroyBuffer(&vulkanContext->allocator, &wireContext->instanceBuffer, &wireContext->instanceAllocation);
+    free(wireContext->instances);
+    free(wireContext->bounds);
+    free(wireContext->handles);
+    free(wireContext->slots);
+    free(wireContext->nodeWires);
+    memset(wireContext, 0, sizeof(WireContext));
+}
@@ -1,155 +1,162 @@
 // vulkan_utils.c
 #include "vulkan_utils.h"
+#include <stdlib.h>
 #include <string.h>
 
-uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties) {
- VkPhysicalDeviceMemoryProperties memProperties;
- vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
- for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
- if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
- return i;
- }
- }
- SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to find suitable memory type");
- return UINT32_MAX;
-}
-
-
-bool createBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage,
-                 VkMemoryPropertyFlags properties, VkBuffer *buffer, VkDeviceMemory *bufferMemory) {
-    *buffer = VK_NULL_HANDLE;
-    *bufferMemory = VK_NULL_HANDLE;
-
-    // Create buffer
+// Create a buffer and bind it to a sub-allocation; host-visible memory comes back mapped in allocation->mapped
+bool createBuffer(MemoryAllocator *allocator, VkDeviceSize size, VkBufferUsageFlags usage,
+                  VkMemoryPropertyFlags properties, VkBuffer *buffer, MemoryAllocation *allocation) {
     VkBufferCreateInfo bufferInfo = {
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
         .size = size,
         .usage = usage,
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE
     };
-    if (vkCreateBuffer(device, &bufferInfo, NULL, buffer) != VK_SUCCESS) {
+    return createBufferWithInfo(allocator, &bufferInfo, properties, buffer, allocation);
+}
+
+// Same as createBuffer for callers that need control over sharing or flags
+bool createBufferWithInfo(MemoryAllocator *allocator, const VkBufferCreateInfo *bufferInfo, VkMemoryPropertyFlags properties,
+                          VkBuffer *buffer, MemoryAllocation *allocation) {
+    *buffer = VK_NULL_HANDLE;
+    memset(allocation, 0, sizeof(MemoryAllocation));
+
+    // Create buffer
+    if (vkCreateBuffer(allocator->device, bufferInfo, NULL, buffer) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create buffer");
         return false;
     }
 
-    // Get memory requirements
+    // Sub-allocate memory
     VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(device, *buffer, &memRequirements);
-
-    // Find suitable memory type
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-    uint32_t memoryTypeIndex = UINT32_MAX;
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((memRequirements.memoryTypeBits & (1 << i)) &&
-            (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            memoryTypeIndex = i;
-            break;
-        }
-    }
-    if (memoryTypeIndex == UINT32_MAX) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to find suitable memory type");
-        vkDestroyBuffer(device, *buffer, NULL);
-        *buffer = VK_NULL_HANDLE;
-        return false;
-    }
-
-    // Allocate memory
-    VkMemoryAllocateInfo allocInfo = {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = memRequirements.size,
-        .memoryTypeIndex = memoryTypeIndex
-    };
-    if (vkAllocateMemory(device, &allocInfo, NULL, bufferMemory) != VK_SUCCESS) {
+    vkGetBufferMemoryRequirements(allocator->device, *buffer, &memRequirements);
+    if (!memory_allocate(allocator, &memRequirements, properties, false, allocation)) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate buffer memory");
-        vkDestroyBuffer(device, *buffer, NULL);
+        vkDestroyBuffer(allocator->device, *buffer, NULL);
         *buffer = VK_NULL_HANDLE;
         return false;
     }
 
     // Bind memory to buffer
-    if (vkBindBufferMemory(device, *buffer, *bufferMemory, 0) != VK_SUCCESS) {
+    if (vkBindBufferMemory(allocator->device, *buffer, allocation->memory, allocation->offset) != VK_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to bind buffer memory");
-        vkFreeMemory(device, *bufferMemory, NULL);
-        vkDestroyBuffer(device, *buffer, NULL);
+        memory_free(allocator, allocation);
+        vkDestroyBuffer(allocator->device, *buffer, NULL);
         *buffer = VK_NULL_HANDLE;
-        *bufferMemory = VK_NULL_HANDLE;
         return false;
     }
 
     return true;
 }
 
+void destroyBuffer(MemoryAllocator *allocator, VkBuffer *buffer, MemoryAllocation *allocation) {
+    if (*buffer != VK_NULL_HANDLE) vkDestroyBuffer(allocator->device, *buffer, NULL);
+    memory_free(allocator, allocation);
+    *buffer = VK_NULL_HANDLE;
+}
 
-VkCommandBuffer beginSingleTimeCommands(VkDevice device, VkCommandPool commandPool) {
- VkCommandBufferAllocateInfo allocInfo = {
- .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
- .commandPool = commandPool,
- .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
- .commandBufferCount = 1
- };
- VkCommandBuffer commandBuffer;
- vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
- VkCommandBufferBeginInfo beginInfo = {
- .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
- .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
- };
- vkBeginCommandBuffer(commandBuffer, &beginInfo);
- return commandBuffer;
+// Create an image and bind it to a sub-allocation
+bool createImage(MemoryAllocator *allocator, const VkImageCreateInfo *imageInfo, VkMemoryPropertyFlags properties,
+                 VkImage *image, MemoryAllocation *allocation) {
+    *image = VK_NULL_HANDLE;
+    memset(allocation, 0, sizeof(MemoryAllocation));
+    if (vkCreateImage(allocator->device, imageInfo, NULL, image) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create image");
+        return false;
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(allocator->device, *image, &memRequirements);
+    if (!memory_allocate(allocator, &memRequirements, properties, imageInfo->tiling == VK_IMAGE_TILING_OPTIMAL, allocation)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate image memory");
+        vkDestroyImage(allocator->device, *image, NULL);
+        *image = VK_NULL_HANDLE;
+        return false;
+    }
+
+    if (vkBindImageMemory(allocator->device, *image, allocation->memory, allocation->offset) != VK_SUCCESS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to bind image memory");
+        memory_free(allocator, allocation);
+        vkDestroyImage(allocator->device, *image, NULL);
+        *image = VK_NULL_HANDLE;
+        return false;
+    }
+
+    return true;
 }
 
-void endSingleTimeCommands(VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue, VkCommandBuffer commandBuffer) {
- vkEndCommandBuffer(commandBuffer);
- VkSubmitInfo submitInfo = {
- .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
- .commandBufferCount = 1,
- .pCommandBuffers = &commandBuffer
- };
- vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
- vkQueueWaitIdle(graphicsQueue);
- vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+void destroyImage(MemoryAllocator *allocator, VkImage *image, MemoryAllocation *allocation) {
+    if (*image != VK_NULL_HANDLE) vkDestroyImage(allocator->device, *image, NULL);
+    memory_free(allocator, allocation);
+    *image = VK_NULL_HANDLE;
 }
 
-void transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout) {
- VkImageMemoryBarrier barrier = {
- .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
- .oldLayout = oldLayout,
- .newLayout = newLayout,
- .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
- .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
- .image = image,
- .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
- .subresourceRange.baseMipLevel = 0,
- .subresourceRange.levelCount = 1,
- .subresourceRange.baseArrayLayer = 0,
- .subresourceRange.layerCount = 1
- };
- VkPipelineStageFlags srcStage, dstStage;
- if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
- barrier.srcAccessMask = 0;
- barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
- srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
- dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
- } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
- barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
- barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
- srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
- dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
- }
- vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, NULL, 0, NULL, 1, &barrier); 
+
+// Returns a pipeline cache seeded from path when the file was written by this exact device and driver,
+// otherwise an empty cache. Returns VK_NULL_HANDLE only if the cache object itself cannot be created.
+VkPipelineCache loadPipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, const char *path, bool *warm) {
+    *warm = false;
+    size_t dataSize = 0;
+    void *data = SDL_LoadFile(path, &dataSize);
+    if (data) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        VkPipelineCacheHeaderVersionOne header;
+        if (dataSize < sizeof(header)) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Pipeline cache %s is truncated, ignoring", path);
+        } else {
+            memcpy(&header, data, sizeof(header));
+            if (header.headerSize < sizeof(header) || header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Pipeline cache %s has an unknown header, ignoring", path);
+            } else if (header.vendorID != properties.vendorID || header.deviceID != properties.deviceID) {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Pipeline cache %s belongs to another device, ignoring", path);
+            } else if (memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Pipeline cache %s is stale (driver changed), ignoring", path);
+            } else {
+                *warm = true;
+            }
+        }
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = *warm ? dataSize : 0,
+        .pInitialData = *warm ? data : NULL
+    };
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    if (vkCreatePipelineCache(device, &cacheInfo, NULL, &pipelineCache) != VK_SUCCESS && *warm) {
+        // The driver rejected the data despite a matching header; start cold
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Driver rejected pipeline cache %s, starting empty", path);
+        *warm = false;
+        cacheInfo.initialDataSize = 0;
+        cacheInfo.pInitialData = NULL;
+        if (vkCreatePipelineCache(device, &cacheInfo, NULL, &pipelineCache) != VK_SUCCESS) {
+            pipelineCache = VK_NULL_HANDLE;
+        }
+    }
+    if (pipelineCache == VK_NULL_HANDLE) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create pipeline cache");
+    } else {
+        SDL_Log("Pipeline cache %s: %s (%zu bytes)", path, *warm ? "warm" : "cold", *warm ? dataSize : (size_t)0);
+    }
+    SDL_free(data);
+    return pipelineCache;
 }
 
-void copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
- VkBufferImageCopy region = {
- .bufferOffset = 0,
- .bufferRowLength = 0,
- .bufferImageHeight = 0,
- .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
- .imageSubresource.mipLevel = 0,
- .imageSubresource.baseArrayLayer = 0,
- .imageSubresource.layerCount = 1,
- .imageOffset = {0, 0, 0},
- .imageExtent = {width, height, 1}
- };
- vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-}
\ No newline at end of file
+void savePipelineCache(VkDevice device, VkPipelineCache pipelineCache, const char *path) {
+    if (pipelineCache == VK_NULL_HANDLE) return;
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, NULL) != VK_SUCCESS || dataSize == 0) {
+        return;
+    }
+    void *data = malloc(dataSize);
+    if (!data) return;
+    if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, data) == VK_SUCCESS) {
+        if (SDL_SaveFile(path, data, dataSize)) {
+            SDL_Log("Saved pipeline cache %s (%zu bytes)", path, dataSize);
+        } else {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to save pipeline cache %s: %s", path, SDL_GetError());
+        }
+    }
+    free(data);
+}